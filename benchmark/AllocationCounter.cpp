@@ -0,0 +1,58 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+/** @brief Number of heap allocations of the process */
+static std::atomic<unsigned long> num_allocations(0);
+
+void* operator new(std::size_t size)
+{
+	num_allocations.fetch_add(1, std::memory_order_relaxed);
+	void* pointer = std::malloc(size == 0 ? 1 : size);
+	if (pointer == NULL)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+
+namespace dwl
+{
+
+namespace benchmark
+{
+
+unsigned long getNumberOfAllocations()
+{
+	return num_allocations.load();
+}
+
+} //@namespace benchmark
+} //@namespace dwl
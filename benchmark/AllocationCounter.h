@@ -0,0 +1,22 @@
+#ifndef DWL__BENCHMARK__ALLOCATION_COUNTER__H
+#define DWL__BENCHMARK__ALLOCATION_COUNTER__H
+
+
+namespace dwl
+{
+
+namespace benchmark
+{
+
+/**
+ * @brief Gets the number of heap allocations of the process. The allocations are counted by
+ * replacing the global operator new in AllocationCounter.cpp, so that source has to be linked
+ * once in every program that calls this function
+ * @return The number of heap allocations since the program started
+ */
+unsigned long getNumberOfAllocations();
+
+} //@namespace benchmark
+} //@namespace dwl
+
+#endif
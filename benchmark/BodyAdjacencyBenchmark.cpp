@@ -0,0 +1,570 @@
+#include <dwl/model/GridBasedBodyAdjacency.h>
+#include <dwl/model/LatticeBasedBodyAdjacency.h>
+#include <dwl/model/StanceStencils.h>
+#include <dwl/model/StanceCostKernel.h>
+#include <dwl/environment/TerrainMap.h>
+#include <dwl/environment/DenseTerrainView.h>
+#include <dwl/environment/ObstacleGrid.h>
+#include <dwl/environment/FootprintMask.h>
+#include <dwl/robot/Robot.h>
+#include <dwl/behavior/MotorPrimitives.h>
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+
+/**
+ * Benchmark of the body adjacency models over synthetic terrains (flat, stepped, rubble and
+ * corridor) at several sizes and resolutions. It reports the throughput, latency percentiles and
+ * heap allocations per operation, writes the results in JSON (one benchmark per line) and compares
+ * them against a stored baseline. The terrains and queries are generated from a fixed seed, so
+ * two runs measure exactly the same work.
+ *
+ * Usage: BodyAdjacencyBenchmark [--robot file] [--primitives file] [--output file]
+ *                               [--baseline file] [--tolerance fraction] [--threads number]
+ *                               [--quick]
+ * The exit code is 1 if a benchmark regressed w.r.t. the baseline.
+ */
+
+
+namespace dwl
+{
+
+namespace benchmark
+{
+
+/** @brief Types of synthetic terrain */
+enum TerrainType {FLAT, STEPPED, RUBBLE, CORRIDOR, NUM_TERRAIN_TYPES};
+
+static const char* TERRAIN_NAMES[NUM_TERRAIN_TYPES] = {"flat", "stepped", "rubble", "corridor"};
+
+
+/** @brief Synthetic terrain */
+struct SyntheticTerrain
+{
+	/** @brief Type of the terrain */
+	TerrainType type;
+
+	/** @brief Size of the (squared) terrain in meters */
+	double size;
+
+	/** @brief Resolution of the terrain cells */
+	double resolution;
+
+	/** @brief Terrain cells */
+	std::vector<TerrainCell> cells;
+
+	/** @brief Keys of the occupied cells */
+	std::vector<Key> obstacle_keys;
+};
+
+
+/** @brief Measurements of a benchmark */
+struct BenchmarkResult
+{
+	BenchmarkResult() : operations(0), seconds(0), allocations(0) {}
+
+	/** @brief Name of the benchmark */
+	std::string name;
+
+	/** @brief Number of measured operations */
+	unsigned long operations;
+
+	/** @brief Total time of the measured operations */
+	double seconds;
+
+	/** @brief Latency of every operation in nanoseconds */
+	std::vector<double> latencies;
+
+	/** @brief Number of heap allocations of the measured operations */
+	unsigned long allocations;
+};
+
+
+/** @brief Options of the benchmark */
+struct BenchmarkOptions
+{
+	BenchmarkOptions() : robot_file("benchmark/config/quadruped.yaml"),
+			primitives_file("benchmark/config/body_primitives.yaml"), tolerance(0.15),
+			num_threads(1), is_quick(false) {}
+
+	std::string robot_file;
+	std::string primitives_file;
+	std::string output_file;
+	std::string baseline_file;
+	double tolerance;
+	unsigned int num_threads;
+	bool is_quick;
+};
+
+
+/**
+ * @brief Generates a synthetic terrain
+ * @param SyntheticTerrain& Synthetic terrain, its type, size and resolution have to be defined
+ * @param environment::SpaceDiscretization& Space discretization of the terrain
+ */
+static void generateTerrain(SyntheticTerrain& terrain,
+							environment::SpaceDiscretization& space_discretization)
+{
+	std::mt19937 generator(1234 + terrain.type);
+	std::uniform_real_distribution<double> uniform(0., 1.);
+
+	terrain.cells.clear();
+	terrain.obstacle_keys.clear();
+	double corridor_width = 1.2;
+	for (double y = 0; y < terrain.size; y += terrain.resolution) {
+		for (double x = 0; x < terrain.size; x += terrain.resolution) {
+			TerrainCell cell;
+			space_discretization.stateToKey(cell.key.x, x, true);
+			space_discretization.stateToKey(cell.key.y, y, true);
+			cell.plane_size = terrain.resolution;
+			cell.height_size = terrain.resolution;
+			cell.height = 0;
+			cell.cost = 0;
+
+			switch (terrain.type) {
+			case FLAT:
+				break;
+			case STEPPED: {
+				// Steps of 10 cm every 50 cm, the cells close to the step edge are costly
+				double step_position = fmod(x, 0.5);
+				cell.height = 0.1 * floor(x / 0.5);
+				if ((step_position < 0.06) || (step_position > 0.44))
+					cell.cost = 1.;
+				break;
+			}
+			case RUBBLE: {
+				// Random heights and costs, and sparse boulders
+				cell.height = 0.15 * uniform(generator);
+				cell.cost = uniform(generator);
+				if (uniform(generator) < 0.01)
+					terrain.obstacle_keys.push_back(cell.key);
+				break;
+			}
+			case CORRIDOR: {
+				// Terrain only inside the corridor, its walls are obstacles
+				double distance = fabs(y - 0.5 * terrain.size);
+				if (distance > 0.5 * corridor_width) {
+					if (distance < 0.5 * corridor_width + 2 * terrain.resolution)
+						terrain.obstacle_keys.push_back(cell.key);
+					continue;
+				}
+				cell.cost = 0.2 * uniform(generator);
+				break;
+			}
+			default:
+				break;
+			}
+
+			terrain.cells.push_back(cell);
+		}
+	}
+}
+
+
+/**
+ * @brief Generates random body states inside a terrain
+ * @param std::vector<Eigen::Vector3d>& Body states (x,y,yaw)
+ * @param const SyntheticTerrain& Synthetic terrain
+ * @param unsigned int Number of states
+ */
+static void generateStates(std::vector<Eigen::Vector3d>& states,
+						   const SyntheticTerrain& terrain,
+						   unsigned int num_states)
+{
+	std::mt19937 generator(4321 + terrain.type);
+	std::uniform_real_distribution<double> uniform(0., 1.);
+
+	states.clear();
+	double min_y = 0, max_y = terrain.size;
+	if (terrain.type == CORRIDOR) {
+		min_y = 0.5 * terrain.size - 0.5;
+		max_y = 0.5 * terrain.size + 0.5;
+	}
+	for (unsigned int i = 0; i < num_states; i++) {
+		Eigen::Vector3d state;
+		state << terrain.size * uniform(generator), min_y + (max_y - min_y) * uniform(generator),
+				2 * M_PI * uniform(generator) - M_PI;
+		states.push_back(state);
+	}
+}
+
+
+/**
+ * @brief Runs a benchmark, the operation is called once per iteration
+ * @param BenchmarkResult& Measurements of the benchmark
+ * @param std::string Name of the benchmark
+ * @param unsigned int Number of iterations
+ * @param const Operation& Operation, it receives the index of the iteration
+ */
+template <typename Operation>
+static void runBenchmark(BenchmarkResult& result,
+						 std::string name,
+						 unsigned int num_iterations,
+						 const Operation& operation)
+{
+	result = BenchmarkResult();
+	result.name = name;
+	result.latencies.reserve(num_iterations);
+
+	unsigned long allocations = getNumberOfAllocations();
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < num_iterations; i++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		operation(i);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		result.latencies.push_back(
+				std::chrono::duration<double, std::nano>(end - start).count());
+	}
+	result.seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - begin).count();
+
+	// The latency buffer was reserved before, so it doesn't allocate
+	result.allocations = getNumberOfAllocations() - allocations;
+	result.operations = num_iterations;
+}
+
+
+/**
+ * @brief Gets a percentile of the latencies of a benchmark
+ * @param const BenchmarkResult& Measurements of the benchmark
+ * @param double Percentile between 0 and 1
+ * @return The latency of the percentile in nanoseconds
+ */
+static double getPercentile(const BenchmarkResult& result,
+							double percentile)
+{
+	if (result.latencies.empty())
+		return 0;
+
+	std::vector<double> latencies(result.latencies);
+	std::size_t index = std::min((std::size_t) (percentile * latencies.size()),
+			latencies.size() - 1);
+	std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+	return latencies[index];
+}
+
+
+/**
+ * @brief Converts the measurements of a benchmark to a JSON line
+ * @param const BenchmarkResult& Measurements of the benchmark
+ * @return The JSON line
+ */
+static std::string toJson(const BenchmarkResult& result)
+{
+	double throughput = (result.seconds > 0) ? result.operations / result.seconds : 0;
+	double allocations = (result.operations > 0) ?
+			(double) result.allocations / result.operations : 0;
+
+	std::ostringstream json;
+	json << "{\"name\": \"" << result.name << "\", \"operations\": " << result.operations
+			<< ", \"throughput\": " << throughput
+			<< ", \"p50_ns\": " << getPercentile(result, 0.5)
+			<< ", \"p90_ns\": " << getPercentile(result, 0.9)
+			<< ", \"p99_ns\": " << getPercentile(result, 0.99)
+			<< ", \"max_ns\": " << getPercentile(result, 1.)
+			<< ", \"allocations_per_operation\": " << allocations << "}";
+	return json.str();
+}
+
+
+/**
+ * @brief Reads a number of a JSON line
+ * @param double& Number
+ * @param const std::string& JSON line
+ * @param std::string Key of the number
+ * @return True if the key was found
+ */
+static bool readJsonNumber(double& number,
+						   const std::string& line,
+						   std::string key)
+{
+	std::size_t position = line.find("\"" + key + "\": ");
+	if (position == std::string::npos)
+		return false;
+
+	number = atof(line.c_str() + position + key.size() + 4);
+	return true;
+}
+
+
+/**
+ * @brief Compares the results with a baseline, written by a previous run with --output
+ * @param const std::vector<std::string>& JSON lines of the results
+ * @param std::string Baseline file
+ * @param double Tolerated relative change of the throughput and median latency
+ * @return The number of regressions
+ */
+static unsigned int compareWithBaseline(const std::vector<std::string>& results,
+										std::string baseline_file,
+										double tolerance)
+{
+	std::ifstream baseline(baseline_file.c_str());
+	if (!baseline.is_open()) {
+		printf(RED "Could not open the baseline file %s\n" COLOR_RESET, baseline_file.c_str());
+		return 1;
+	}
+
+	// Reading the baseline lines by benchmark name
+	std::map<std::string, std::string> baseline_lines;
+	std::string line;
+	while (std::getline(baseline, line)) {
+		std::size_t begin = line.find("\"name\": \"");
+		if (begin == std::string::npos)
+			continue;
+		begin += 9;
+		baseline_lines[line.substr(begin, line.find('"', begin) - begin)] = line;
+	}
+
+	unsigned int num_regressions = 0;
+	printf("\n%-48s %12s %12s %12s\n", "benchmark", "throughput", "p50", "allocs/op");
+	for (std::size_t i = 0; i < results.size(); i++) {
+		std::size_t begin = results[i].find("\"name\": \"") + 9;
+		std::string name = results[i].substr(begin, results[i].find('"', begin) - begin);
+		std::map<std::string, std::string>::iterator baseline_iter = baseline_lines.find(name);
+		if (baseline_iter == baseline_lines.end()) {
+			printf(YELLOW "%-48s not in the baseline\n" COLOR_RESET, name.c_str());
+			continue;
+		}
+
+		double throughput, p50, allocations;
+		double baseline_throughput, baseline_p50, baseline_allocations;
+		readJsonNumber(throughput, results[i], "throughput");
+		readJsonNumber(p50, results[i], "p50_ns");
+		readJsonNumber(allocations, results[i], "allocations_per_operation");
+		readJsonNumber(baseline_throughput, baseline_iter->second, "throughput");
+		readJsonNumber(baseline_p50, baseline_iter->second, "p50_ns");
+		readJsonNumber(baseline_allocations, baseline_iter->second, "allocations_per_operation");
+
+		double throughput_change = (baseline_throughput > 0) ?
+				throughput / baseline_throughput - 1 : 0;
+		double p50_change = (baseline_p50 > 0) ? p50 / baseline_p50 - 1 : 0;
+		bool is_regression = (throughput_change < -tolerance) || (p50_change > tolerance) ||
+				(allocations > baseline_allocations + 0.5);
+		if (is_regression)
+			num_regressions++;
+
+		printf("%s%-48s %+11.1f%% %+11.1f%% %12.1f%s\n", is_regression ? RED : "",
+				name.c_str(), 100 * throughput_change, 100 * p50_change, allocations,
+				is_regression ? " REGRESSION" COLOR_RESET : "");
+	}
+
+	return num_regressions;
+}
+
+
+/**
+ * @brief Runs the benchmarks of a synthetic terrain
+ * @param std::vector<std::string>& JSON lines of the results
+ * @param SyntheticTerrain& Synthetic terrain
+ * @param robot::Robot& Reference robot
+ * @param const BenchmarkOptions& Options of the benchmark
+ */
+static void runTerrainBenchmarks(std::vector<std::string>& results,
+								 SyntheticTerrain& terrain,
+								 robot::Robot& robot,
+								 const BenchmarkOptions& options)
+{
+	// Building the terrain map
+	environment::TerrainMap terrain_map;
+	terrain_map.setResolution(terrain.resolution, true);
+	generateTerrain(terrain, terrain_map.getTerrainSpaceModel());
+	for (std::size_t i = 0; i < terrain.cells.size(); i++)
+		terrain_map.addCellToTerrainMap(terrain.cells[i]);
+
+	std::ostringstream suffix;
+	suffix << "/" << TERRAIN_NAMES[terrain.type] << "/" << terrain.size << "m/"
+			<< terrain.resolution;
+	printf(BLUE "Benchmarking the %s terrain (%lu cells)\n" COLOR_RESET, suffix.str().c_str(),
+			(unsigned long) terrain.cells.size());
+
+	unsigned int num_queries = options.is_quick ? 500 : 4000;
+	unsigned int num_builds = options.is_quick ? 1 : 3;
+	std::vector<Eigen::Vector3d> states;
+	generateStates(states, terrain, num_queries);
+	std::vector<Vertex> state_vertices(num_queries);
+	for (unsigned int i = 0; i < num_queries; i++)
+		terrain_map.getTerrainSpaceModel().stateToVertex(state_vertices[i], states[i]);
+
+	BenchmarkResult result;
+
+	// Computing the whole adjacency map of the grid-based model
+	model::GridBasedBodyAdjacency grid_adjacency;
+	grid_adjacency.reset(&robot, &terrain_map);
+	grid_adjacency.setNumberOfThreads(options.num_threads);
+	AdjacencyMap adjacency_map;
+	runBenchmark(result, "grid/computeAdjacencyMap" + suffix.str(), num_builds,
+			[&](unsigned int i) {
+				adjacency_map.clear();
+				grid_adjacency.reset(&robot, &terrain_map);
+				grid_adjacency.computeAdjacencyMap(adjacency_map, state_vertices[0],
+						state_vertices[1]);
+			});
+	results.push_back(toJson(result));
+
+	// Expanding the successors, the first pass warms up the caches of the models
+	std::vector<Edge> successors;
+	for (unsigned int i = 0; i < num_queries; i++)
+		grid_adjacency.getSuccessors(successors, state_vertices[i]);
+	runBenchmark(result, "grid/getSuccessors" + suffix.str(), num_queries,
+			[&](unsigned int i) { grid_adjacency.getSuccessors(successors, state_vertices[i]); });
+	results.push_back(toJson(result));
+
+	model::LatticeBasedBodyAdjacency lattice_adjacency;
+	lattice_adjacency.reset(&robot, &terrain_map);
+	for (unsigned int i = 0; i < num_queries; i++)
+		lattice_adjacency.getSuccessors(successors, state_vertices[i]);
+	runBenchmark(result, "lattice/getSuccessors" + suffix.str(), num_queries,
+			[&](unsigned int i) { lattice_adjacency.getSuccessors(successors, state_vertices[i]); });
+	results.push_back(toJson(result));
+
+	// Computing the body (stance) cost, i.e. the core of computeBodyCost without the caches
+	environment::DenseTerrainView terrain_view;
+	terrain_view.reset(&terrain_map);
+	model::StanceStencils stance_stencils;
+	stance_stencils.reset(terrain.resolution);
+	model::StanceCostKernel stance_cost_kernel;
+	Eigen::Vector3d action = Eigen::Vector3d::Zero();
+	SearchAreaMap stance_areas = robot.getFootstepSearchAreas(action);
+	int pattern = robot.getStancePattern(action);
+	std::vector<Key> body_keys(num_queries);
+	std::vector<unsigned short int> yaw_keys(num_queries);
+	for (unsigned int i = 0; i < num_queries; i++) {
+		terrain_map.getTerrainSpaceModel().stateToKey(body_keys[i].x, states[i](0), true);
+		terrain_map.getTerrainSpaceModel().stateToKey(body_keys[i].y, states[i](1), true);
+		terrain_map.getTerrainSpaceModel().stateToKey(yaw_keys[i], states[i](2), false);
+		if (!stance_stencils.isDefined(yaw_keys[i], pattern)) {
+			double yaw;
+			terrain_map.getTerrainSpaceModel().keyToState(yaw, yaw_keys[i], false);
+			stance_stencils.compute(yaw_keys[i], pattern, yaw, stance_areas);
+		}
+	}
+	double unknown_cost = 1.15 * terrain_view.getAverageCost();
+	double total_cost = 0;
+	runBenchmark(result, "stance/computeBodyCost" + suffix.str(), num_queries,
+			[&](unsigned int i) {
+				total_cost += stance_cost_kernel.computeTerrainCost(terrain_view,
+						stance_stencils.getStencil(yaw_keys[i], pattern), body_keys[i].x,
+						body_keys[i].y, 10, unknown_cost);
+			});
+	results.push_back(toJson(result));
+
+	// Checking the body collisions, i.e. the core of isFreeOfObstacle
+	environment::ObstacleGrid obstacle_grid;
+	obstacle_grid.reset(terrain.obstacle_keys);
+	SearchArea body_workspace = robot.getPredefinedBodyWorkspace();
+	std::vector<environment::FootprintMask> body_footprints;
+	for (unsigned int i = 0; i < num_queries; i++) {
+		if (yaw_keys[i] >= body_footprints.size())
+			body_footprints.resize(yaw_keys[i] + 1);
+		if (!body_footprints[yaw_keys[i]].isDefined()) {
+			double yaw;
+			terrain_map.getTerrainSpaceModel().keyToState(yaw, yaw_keys[i], false);
+			std::vector<environment::CellOffset> offsets;
+			environment::FootprintMask::rasterize(offsets, body_workspace, yaw,
+					std::max(terrain.resolution, body_workspace.resolution), terrain.resolution);
+			body_footprints[yaw_keys[i]].reset(offsets);
+		}
+	}
+	unsigned int num_collisions = 0;
+	runBenchmark(result, "obstacle/isFreeOfObstacle" + suffix.str(), num_queries,
+			[&](unsigned int i) {
+				num_collisions += obstacle_grid.isColliding(body_footprints[yaw_keys[i]],
+						body_keys[i].x, body_keys[i].y);
+			});
+	results.push_back(toJson(result));
+
+	// Printing the results that depend on the measured work, so it isn't optimized out
+	printf("  edges=%lu stance cost=%f collisions=%u\n",
+			(unsigned long) adjacency_map.size(), total_cost, num_collisions);
+}
+
+} //@namespace benchmark
+} //@namespace dwl
+
+
+int main(int argc, char** argv)
+{
+	using namespace dwl::benchmark;
+
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		bool has_value = i + 1 < argc;
+		if ((argument == "--robot") && has_value)
+			options.robot_file = argv[++i];
+		else if ((argument == "--primitives") && has_value)
+			options.primitives_file = argv[++i];
+		else if ((argument == "--output") && has_value)
+			options.output_file = argv[++i];
+		else if ((argument == "--baseline") && has_value)
+			options.baseline_file = argv[++i];
+		else if ((argument == "--tolerance") && has_value)
+			options.tolerance = atof(argv[++i]);
+		else if ((argument == "--threads") && has_value)
+			options.num_threads = atoi(argv[++i]);
+		else if (argument == "--quick")
+			options.is_quick = true;
+		else {
+			printf(RED "Unknown argument %s\n" COLOR_RESET, argument.c_str());
+			return 2;
+		}
+	}
+
+	// Loading the reference robot and body motor primitives
+	dwl::robot::Robot robot;
+	robot.read(options.robot_file);
+	robot.getBodyMotorPrimitive().read(options.primitives_file);
+
+	// Running the benchmarks of every terrain, size and resolution
+	std::vector<double> sizes = {4., 8.};
+	std::vector<double> resolutions = {0.04, 0.08};
+	if (options.is_quick) {
+		sizes = {4.};
+		resolutions = {0.08};
+	}
+
+	std::vector<std::string> results;
+	for (int type = 0; type < NUM_TERRAIN_TYPES; type++) {
+		for (std::size_t i = 0; i < sizes.size(); i++) {
+			for (std::size_t j = 0; j < resolutions.size(); j++) {
+				SyntheticTerrain terrain;
+				terrain.type = (TerrainType) type;
+				terrain.size = sizes[i];
+				terrain.resolution = resolutions[j];
+				runTerrainBenchmarks(results, terrain, robot, options);
+			}
+		}
+	}
+
+	// Writing the results, one benchmark per line
+	std::ostringstream json;
+	json << "{\"benchmarks\": [\n";
+	for (std::size_t i = 0; i < results.size(); i++)
+		json << "  " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+	json << "]}\n";
+
+	if (options.output_file.empty())
+		printf("%s", json.str().c_str());
+	else {
+		std::ofstream output(options.output_file.c_str());
+		output << json.str();
+	}
+
+	if (!options.baseline_file.empty()) {
+		unsigned int num_regressions =
+				compareWithBaseline(results, options.baseline_file, options.tolerance);
+		if (num_regressions > 0) {
+			printf(RED "%u benchmarks regressed\n" COLOR_RESET, num_regressions);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#ifndef DWL__ENVIRONMENT__BATCH_FEATURE__H
+#define DWL__ENVIRONMENT__BATCH_FEATURE__H
+
+#include <dwl/environment/DenseTerrainView.h>
+#include <dwl/robot/Robot.h>
+#include <dwl/utils/utils.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/**
+ * @brief Borrowed terrain information for evaluating a batch of body states. Nothing is copied,
+ * so the information is valid only during the evaluation of the batch
+ */
+struct FeatureTerrain
+{
+	FeatureTerrain() : height_map(NULL), terrain_view(NULL), resolution(0) {}
+
+	/** @brief Height map of the terrain, it's NULL if there isn't terrain information */
+	const HeightMap* height_map;
+
+	/** @brief Dense view of the terrain costs */
+	const DenseTerrainView* terrain_view;
+
+	/** @brief Resolution of the terrain */
+	double resolution;
+};
+
+
+/** @brief Body state of a batch of feature evaluations */
+struct FeatureState
+{
+	/** @brief Pose of the body */
+	Pose3d pose;
+
+	/** @brief Action of the body that reaches the pose */
+	Eigen::Vector3d body_action;
+};
+
+
+/**
+ * @class BatchFeature
+ * @brief Abstract class for computing the cost of a body feature over a batch of body states.
+ * The terrain information is borrowed for the whole batch, so the cost of a set of successors is
+ * computed with one virtual call and without copying the height map. The batch can be evaluated
+ * from several threads, so the derived classes have to be reentrant
+ */
+class BatchFeature
+{
+	public:
+		/** @brief Constructor function */
+		BatchFeature();
+
+		/** @brief Destructor function */
+		virtual ~BatchFeature();
+
+		/**
+		 * @brief Sets the robot information
+		 * @param robot::Robot* Pointer to the robot information
+		 */
+		virtual void reset(robot::Robot* robot);
+
+		/**
+		 * @brief Computes the cost of every state of the batch
+		 * @param std::vector<double>& Costs of the states, it's resized to the batch size
+		 * @param const std::vector<FeatureState>& Batch of body states
+		 * @param const FeatureTerrain& Borrowed terrain information
+		 */
+		virtual void computeCosts(std::vector<double>& costs,
+								  const std::vector<FeatureState>& states,
+								  const FeatureTerrain& terrain) = 0;
+
+		/**
+		 * @brief Sets the weight of the feature
+		 * @param double Weight of the feature
+		 */
+		void setWeight(double weight);
+
+		/**
+		 * @brief Gets the weight of the feature
+		 * @param double& Weight of the feature
+		 */
+		virtual void getWeight(double& weight);
+
+		/**
+		 * @brief Gets the name of the feature
+		 * @return The name of the feature
+		 */
+		virtual std::string getName();
+
+		/**
+		 * @brief Sets the footprint radius of the feature, i.e. the distance from the body pose
+		 * of the farthest terrain information that changes its cost
+		 * @param double Footprint radius (m), negative if it isn't known
+		 */
+		void setFootprintRadius(double radius);
+
+		/**
+		 * @brief Gets the footprint radius of the feature. The adjacency models repair the costs of
+		 * the states that are closer than this radius to a changed terrain cell
+		 * @return The footprint radius (m), negative if any terrain change can modify the cost
+		 */
+		virtual double getFootprintRadius();
+
+
+	protected:
+		/** @brief Name of the feature */
+		std::string name_;
+
+		/** @brief Weight of the feature */
+		double weight_;
+
+		/** @brief Footprint radius of the feature, negative if it isn't known */
+		double footprint_radius_;
+};
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef DWL__ENVIRONMENT__DENSE_TERRAIN_VIEW__H
+#define DWL__ENVIRONMENT__DENSE_TERRAIN_VIEW__H
+
+#include <dwl/environment/TerrainMap.h>
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/**
+ * @class DenseTerrainView
+ * @brief Read-only and cache-friendly view of the terrain information. The terrain cells are
+ * stored in a flat array indexed by their key, together with a validity bitmask, so the cost
+ * lookups are O(1) and don't require any allocation, tree or hash walk
+ */
+class DenseTerrainView
+{
+	public:
+		/** @brief Constructor function */
+		DenseTerrainView();
+
+		/** @brief Destructor function */
+		~DenseTerrainView();
+
+		/**
+		 * @brief Builds the view from the current terrain information
+		 * @param TerrainMap* Encapsulates all the terrain information
+		 */
+		void reset(TerrainMap* terrain);
+
+		/**
+		 * @brief Gets the index of the cell in the flat array
+		 * @param int Key of the x-axis
+		 * @param int Key of the y-axis
+		 * @return The index of the cell, or -1 if it's outside of the view
+		 */
+		int getIndex(int key_x, int key_y) const;
+
+		/**
+		 * @brief Indicates if there is terrain information in a certain cell
+		 * @param int Key of the x-axis
+		 * @param int Key of the y-axis
+		 * @return True if the cell belongs to the terrain information
+		 */
+		bool isValid(int key_x, int key_y) const;
+
+		/**
+		 * @brief Indicates if there is terrain information in a certain cell
+		 * @param const Key& Key of the cell
+		 * @return True if the cell belongs to the terrain information
+		 */
+		bool isValid(const Key& key) const;
+
+		/**
+		 * @brief Indicates if there is terrain information in a certain cell
+		 * @param int Index of the cell
+		 * @return True if the cell belongs to the terrain information
+		 */
+		bool isValid(int index) const;
+
+		/**
+		 * @brief Gets the cost of a cell given its index. The cell has to be valid
+		 * @param int Index of the cell
+		 * @return The terrain cost of the cell
+		 */
+		double getCost(int index) const;
+
+		/**
+		 * @brief Gets the cost of a certain cell
+		 * @param double& Terrain cost of the cell
+		 * @param int Key of the x-axis
+		 * @param int Key of the y-axis
+		 * @return True if the cell belongs to the terrain information
+		 */
+		bool getCost(double& cost, int key_x, int key_y) const;
+
+		/**
+		 * @brief Gets the region of cells whose information changed in the last reset. The region
+		 * is empty (i.e. the minimum key is bigger than the maximum key) if only the average cost
+		 * changed
+		 * @param int& Minimum key of the x-axis
+		 * @param int& Minimum key of the y-axis
+		 * @param int& Maximum key of the x-axis
+		 * @param int& Maximum key of the y-axis
+		 * @return False if the whole view changed, e.g. the bounding box of the terrain changed
+		 */
+		bool getDirtyRegion(int& min_key_x,
+							int& min_key_y,
+							int& max_key_x,
+							int& max_key_y) const;
+
+		/**
+		 * @brief Gets the bounding box of the view
+		 * @param int& Minimum key of the x-axis
+		 * @param int& Minimum key of the y-axis
+		 * @param int& Number of cells of the x-axis
+		 * @param int& Number of cells of the y-axis
+		 */
+		void getBounds(int& min_key_x,
+					   int& min_key_y,
+					   int& size_x,
+					   int& size_y) const;
+
+		/** @brief Gets the version of the view, it increases every time that the view changes */
+		unsigned int getVersion() const;
+
+		/** @brief Indicates if there is terrain information */
+		bool isTerrainInformation() const;
+
+		/** @brief Gets the average cost of the terrain */
+		double getAverageCost() const;
+
+		/**
+		 * @brief Gets the minimum cost of the terrain cells, it's a lower bound of any cost that is
+		 * computed from the cells
+		 */
+		double getMinimumCost() const;
+
+		/** @brief Gets the number of terrain cells */
+		std::size_t getNumberOfCells() const;
+
+
+	private:
+		/** @brief Flat array of the terrain costs */
+		std::vector<double> cost_;
+
+		/** @brief Validity bitmask of the cells */
+		std::vector<uint64_t> valid_mask_;
+
+		/** @brief Minimum key of the view */
+		int min_key_x_, min_key_y_;
+
+		/** @brief Size of the view (number of cells per axis) */
+		int size_x_, size_y_;
+
+		/** @brief Number of terrain cells */
+		std::size_t num_cells_;
+
+		/** @brief Average cost of the terrain */
+		double average_cost_;
+
+		/** @brief Minimum cost of the terrain cells */
+		double minimum_cost_;
+
+		/** @brief Terrain costs and validity bitmask before the last reset */
+		std::vector<double> previous_cost_;
+		std::vector<uint64_t> previous_valid_mask_;
+
+		/** @brief Region of the cells that changed in the last reset */
+		int dirty_min_x_, dirty_min_y_, dirty_max_x_, dirty_max_y_;
+
+		/** @brief Indicates if the whole view changed in the last reset */
+		bool is_fully_dirty_;
+
+		/** @brief Version of the view */
+		unsigned int version_;
+
+		/** @brief Indicates if there is terrain information */
+		bool is_terrain_information_;
+};
+
+
+inline int DenseTerrainView::getIndex(int key_x, int key_y) const
+{
+	int x = key_x - min_key_x_;
+	int y = key_y - min_key_y_;
+	if (((unsigned int) x >= (unsigned int) size_x_) ||
+			((unsigned int) y >= (unsigned int) size_y_))
+		return -1;
+
+	return y * size_x_ + x;
+}
+
+
+inline bool DenseTerrainView::isValid(int key_x, int key_y) const
+{
+	int index = getIndex(key_x, key_y);
+	if (index < 0)
+		return false;
+
+	return isValid(index);
+}
+
+
+inline bool DenseTerrainView::isValid(const Key& key) const
+{
+	return isValid((int) key.x, (int) key.y);
+}
+
+
+inline bool DenseTerrainView::isValid(int index) const
+{
+	return (valid_mask_[index >> 6] >> (index & 63)) & 1;
+}
+
+
+inline double DenseTerrainView::getCost(int index) const
+{
+	return cost_[index];
+}
+
+
+inline bool DenseTerrainView::getCost(double& cost, int key_x, int key_y) const
+{
+	int index = getIndex(key_x, key_y);
+	if ((index < 0) || !isValid(index))
+		return false;
+
+	cost = cost_[index];
+	return true;
+}
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
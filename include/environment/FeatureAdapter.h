@@ -0,0 +1,69 @@
+#ifndef DWL__ENVIRONMENT__FEATURE_ADAPTER__H
+#define DWL__ENVIRONMENT__FEATURE_ADAPTER__H
+
+#include <dwl/environment/BatchFeature.h>
+#include <dwl/environment/Feature.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/**
+ * @class FeatureAdapter
+ * @brief Evaluates a single-state Feature as a batch feature. The height map is copied once per
+ * batch instead of once per state, which is the best that can be done with the Feature interface.
+ * The adapter doesn't own the feature
+ */
+class FeatureAdapter : public BatchFeature
+{
+	public:
+		/**
+		 * @brief Constructor function
+		 * @param Feature* Pointer to the adapted feature
+		 */
+		FeatureAdapter(Feature* feature);
+
+		/** @brief Destructor function */
+		~FeatureAdapter();
+
+		/**
+		 * @brief Sets the robot information of the adapted feature
+		 * @param robot::Robot* Pointer to the robot information
+		 */
+		void reset(robot::Robot* robot);
+
+		/**
+		 * @brief Computes the cost of every state of the batch with the adapted feature
+		 * @param std::vector<double>& Costs of the states, it's resized to the batch size
+		 * @param const std::vector<FeatureState>& Batch of body states
+		 * @param const FeatureTerrain& Borrowed terrain information
+		 */
+		void computeCosts(std::vector<double>& costs,
+						  const std::vector<FeatureState>& states,
+						  const FeatureTerrain& terrain);
+
+		/**
+		 * @brief Gets the weight of the adapted feature
+		 * @param double& Weight of the feature
+		 */
+		void getWeight(double& weight);
+
+		/**
+		 * @brief Gets the name of the adapted feature
+		 * @return The name of the feature
+		 */
+		std::string getName();
+
+
+	private:
+		/** @brief Pointer to the adapted feature */
+		Feature* feature_;
+};
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef DWL__ENVIRONMENT__FOOTPRINT_MASK__H
+#define DWL__ENVIRONMENT__FOOTPRINT_MASK__H
+
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/** @brief Integer offset of a cell w.r.t. an anchor cell */
+struct CellOffset
+{
+	int dx;
+	int dy;
+};
+
+/** @brief Row of a footprint mask. The bits of the row are relative to the dx column */
+struct FootprintRow
+{
+	int dy;
+	int dx;
+	unsigned int first_word;
+	unsigned int num_words;
+};
+
+
+/**
+ * @class FootprintMask
+ * @brief Bit-packed mask of the cells covered by an area (e.g. the body workspace) for a certain
+ * orientation. Every row of the mask is packed in 64-bit words, so it can be tested against an
+ * occupancy grid with word-wide AND operations
+ */
+class FootprintMask
+{
+	public:
+		/** @brief Constructor function */
+		FootprintMask();
+
+		/** @brief Destructor function */
+		~FootprintMask();
+
+		/**
+		 * @brief Computes the cell offsets covered by a rotated area. The area is sampled in the
+		 * same way than the search loops of the adjacency models, i.e. with a step size from the
+		 * minimum to the maximum bound, and the samples are rotated around the anchor cell
+		 * @param std::vector<CellOffset>& Sorted (by row) and unique cell offsets
+		 * @param const SearchArea& Area w.r.t. the anchor
+		 * @param double Orientation of the area
+		 * @param double Sampling step of the area
+		 * @param double Resolution of the cells
+		 */
+		static void rasterize(std::vector<CellOffset>& offsets,
+							  const SearchArea& area,
+							  double yaw,
+							  double step,
+							  double resolution);
+
+		/**
+		 * @brief Builds the mask from a set of cell offsets
+		 * @param const std::vector<CellOffset>& Sorted (by row) and unique cell offsets
+		 */
+		void reset(const std::vector<CellOffset>& offsets);
+
+		/** @brief Indicates if the mask was built */
+		bool isDefined() const;
+
+		/** @brief Gets the rows of the mask */
+		const std::vector<FootprintRow>& getRows() const;
+
+		/** @brief Gets the packed words of the mask */
+		const std::vector<uint64_t>& getWords() const;
+
+		/**
+		 * @brief Gets the squared radius (in cells) of the circumscribed circle of the mask, i.e.
+		 * the cells farther than it don't belong to the mask
+		 */
+		uint32_t getCircumscribedSquaredRadius() const;
+
+		/**
+		 * @brief Gets the squared radius (in cells) of the inscribed circle of the mask, i.e. the
+		 * cells closer than it belong to the mask
+		 */
+		uint32_t getInscribedSquaredRadius() const;
+
+
+	private:
+		/** @brief Rows of the mask */
+		std::vector<FootprintRow> rows_;
+
+		/** @brief Packed words of all the rows */
+		std::vector<uint64_t> words_;
+
+		/** @brief Squared radius of the circumscribed circle */
+		uint32_t circumscribed_squared_radius_;
+
+		/** @brief Squared radius of the inscribed circle */
+		uint32_t inscribed_squared_radius_;
+
+		/** @brief Indicates if the mask was built */
+		bool is_defined_;
+};
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
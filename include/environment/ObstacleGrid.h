@@ -0,0 +1,219 @@
+#ifndef DWL__ENVIRONMENT__OBSTACLE_GRID__H
+#define DWL__ENVIRONMENT__OBSTACLE_GRID__H
+
+#include <dwl/environment/TerrainMap.h>
+#include <dwl/environment/FootprintMask.h>
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/**
+ * @class ObstacleGrid
+ * @brief Bit-packed occupancy grid of the obstacle information. Each row of the grid is packed in
+ * 64-bit words, so a footprint collision check is a few word-wide AND operations. The grid also
+ * keeps the squared Euclidean distance transform of the occupied cells, which decides most of the
+ * collision checks with the inscribed and circumscribed circles of the footprint
+ */
+class ObstacleGrid
+{
+	public:
+		/** @brief Constructor function */
+		ObstacleGrid();
+
+		/** @brief Destructor function */
+		~ObstacleGrid();
+
+		/**
+		 * @brief Builds the occupancy grid from the current obstacle information
+		 * @param TerrainMap* Encapsulates all the terrain information
+		 */
+		void reset(TerrainMap* terrain);
+
+		/**
+		 * @brief Builds the occupancy grid from the keys of the occupied cells
+		 * @param const std::vector<Key>& Keys of the occupied cells
+		 */
+		void reset(const std::vector<Key>& obstacle_keys);
+
+		/**
+		 * @brief Indicates if a cell is occupied
+		 * @param int Key of the x-axis
+		 * @param int Key of the y-axis
+		 * @return True if there is an obstacle in the cell
+		 */
+		bool isOccupied(int key_x, int key_y) const;
+
+		/**
+		 * @brief Gets the squared distance (in cells) from a cell to the closest occupied cell
+		 * @param uint32_t& Squared distance, it's a lower bound outside of the grid
+		 * @param int Key of the x-axis
+		 * @param int Key of the y-axis
+		 * @return True if the distance is exact, i.e. the cell is inside the grid
+		 */
+		bool getSquaredDistance(uint32_t& squared_distance,
+								int key_x,
+								int key_y) const;
+
+		/**
+		 * @brief Indicates if a footprint collides with an obstacle
+		 * @param const FootprintMask& Footprint mask
+		 * @param int Key of the x-axis of the anchor cell
+		 * @param int Key of the y-axis of the anchor cell
+		 * @return True if any cell of the footprint is occupied
+		 */
+		bool isColliding(const FootprintMask& mask,
+						 int key_x,
+						 int key_y) const;
+
+		/** @brief Indicates if there is obstacle information */
+		bool isObstacleInformation() const;
+
+
+	private:
+		/**
+		 * @brief Gets 64 consecutive cells of a row of the grid, the cells outside the grid are free
+		 * @param int Row of the grid
+		 * @param int First column w.r.t. the grid
+		 * @return The occupancy bits
+		 */
+		uint64_t getRowBits(int row,
+							int x) const;
+
+		/** @brief Computes the squared Euclidean distance transform of the occupied cells */
+		void computeDistanceTransform();
+
+		/**
+		 * @brief Computes the 1D squared distance transform of a sampled function (Felzenszwalb
+		 * and Huttenlocher)
+		 * @param double* Sampled function, it's replaced by its distance transform
+		 * @param int Number of samples
+		 * @param std::vector<int>& Buffer of the parabola vertices
+		 * @param std::vector<double>& Buffer of the parabola boundaries
+		 * @param std::vector<double>& Buffer of the transform
+		 */
+		static void computeDistanceTransform(double* f,
+											 int n,
+											 std::vector<int>& vertices,
+											 std::vector<double>& boundaries,
+											 std::vector<double>& transform);
+
+		/** @brief Packed occupancy words (one padding word per row) */
+		std::vector<uint64_t> words_;
+
+		/** @brief Squared distance to the closest occupied cell of every cell of the grid */
+		std::vector<uint32_t> squared_distance_;
+
+		/** @brief Minimum key of the grid */
+		int min_key_x_, min_key_y_;
+
+		/** @brief Size of the grid (number of cells per axis) */
+		int size_x_, size_y_;
+
+		/** @brief Number of words per row */
+		int words_per_row_;
+
+		/** @brief Indicates if there is obstacle information */
+		bool is_obstacle_information_;
+};
+
+
+inline uint64_t ObstacleGrid::getRowBits(int row,
+										 int x) const
+{
+	if ((x >= size_x_) || (x <= -64))
+		return 0;
+
+	if (x < 0)
+		return getRowBits(row, 0) << (-x);
+
+	const uint64_t* row_words = &words_[row * words_per_row_];
+	int word = x >> 6;
+	int bit = x & 63;
+	if (bit == 0)
+		return row_words[word];
+
+	return (row_words[word] >> bit) | (row_words[word + 1] << (64 - bit));
+}
+
+
+inline bool ObstacleGrid::isOccupied(int key_x, int key_y) const
+{
+	int x = key_x - min_key_x_;
+	int y = key_y - min_key_y_;
+	if (((unsigned int) x >= (unsigned int) size_x_) ||
+			((unsigned int) y >= (unsigned int) size_y_))
+		return false;
+
+	return (words_[y * words_per_row_ + (x >> 6)] >> (x & 63)) & 1;
+}
+
+
+inline bool ObstacleGrid::getSquaredDistance(uint32_t& squared_distance,
+											 int key_x,
+											 int key_y) const
+{
+	if (squared_distance_.empty()) {
+		squared_distance = std::numeric_limits<uint32_t>::max();
+		return false;
+	}
+
+	int x = key_x - min_key_x_;
+	int y = key_y - min_key_y_;
+	if (((unsigned int) x < (unsigned int) size_x_) &&
+			((unsigned int) y < (unsigned int) size_y_)) {
+		squared_distance = squared_distance_[y * size_x_ + x];
+		return true;
+	}
+
+	// The occupied cells are inside the grid, so the distance to the grid is a lower bound
+	uint64_t dx = (x < 0) ? -x : std::max(x - size_x_ + 1, 0);
+	uint64_t dy = (y < 0) ? -y : std::max(y - size_y_ + 1, 0);
+	squared_distance = std::min(dx * dx + dy * dy,
+			(uint64_t) std::numeric_limits<uint32_t>::max());
+	return false;
+}
+
+
+inline bool ObstacleGrid::isColliding(const FootprintMask& mask,
+									  int key_x,
+									  int key_y) const
+{
+	// Deciding the check with the inscribed and circumscribed circles of the footprint
+	uint32_t squared_distance;
+	bool is_exact = getSquaredDistance(squared_distance, key_x, key_y);
+	if (squared_distance > mask.getCircumscribedSquaredRadius())
+		return false;
+	if (is_exact && (squared_distance < mask.getInscribedSquaredRadius()))
+		return true;
+
+	const std::vector<FootprintRow>& rows = mask.getRows();
+	const std::vector<uint64_t>& mask_words = mask.getWords();
+
+	unsigned int num_rows = rows.size();
+	for (unsigned int i = 0; i < num_rows; i++) {
+		int y = key_y + rows[i].dy - min_key_y_;
+		if ((unsigned int) y >= (unsigned int) size_y_)
+			continue;
+
+		int x = key_x + rows[i].dx - min_key_x_;
+		for (unsigned int k = 0; k < rows[i].num_words; k++) {
+			if (getRowBits(y, x + 64 * k) & mask_words[rows[i].first_word + k])
+				return true;
+		}
+	}
+
+	return false;
+}
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
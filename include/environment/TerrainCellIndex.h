@@ -0,0 +1,98 @@
+#ifndef DWL__ENVIRONMENT__TERRAIN_CELL_INDEX__H
+#define DWL__ENVIRONMENT__TERRAIN_CELL_INDEX__H
+
+#include <dwl/environment/DenseTerrainView.h>
+#include <dwl/utils/utils.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/**
+ * @class TerrainCellIndex
+ * @brief Uniform bucket grid over the cells of a dense terrain view. Every bucket counts its
+ * terrain cells, so the closest cell to a query is found by visiting the buckets in rings around
+ * the query, and stopping once the ring is farther than the best cell. The cost of a query
+ * depends on the distance to the terrain information instead of the number of terrain cells
+ */
+class TerrainCellIndex
+{
+	public:
+		/** @brief Constructor function */
+		TerrainCellIndex();
+
+		/** @brief Destructor function */
+		~TerrainCellIndex();
+
+		/**
+		 * @brief Builds the index from the dense view of the terrain
+		 * @param const DenseTerrainView& Dense view of the terrain
+		 */
+		void reset(const DenseTerrainView& terrain_view);
+
+		/**
+		 * @brief Updates the buckets that overlap a region of changed cells. The bounding box of
+		 * the view must be the same than the last reset
+		 * @param const DenseTerrainView& Dense view of the terrain
+		 * @param int Minimum key of the x-axis
+		 * @param int Minimum key of the y-axis
+		 * @param int Maximum key of the x-axis
+		 * @param int Maximum key of the y-axis
+		 */
+		void update(const DenseTerrainView& terrain_view,
+					int min_key_x,
+					int min_key_y,
+					int max_key_x,
+					int max_key_y);
+
+		/**
+		 * @brief Finds the closest terrain cell to a position expressed in (continuous) key units.
+		 * The ties are solved in favor of the lowest (y,x) key
+		 * @param int& Key of the x-axis of the closest cell
+		 * @param int& Key of the y-axis of the closest cell
+		 * @param const DenseTerrainView& Dense view of the terrain
+		 * @param double Position of the x-axis in key units
+		 * @param double Position of the y-axis in key units
+		 * @return False if there isn't any terrain cell
+		 */
+		bool findClosest(int& key_x,
+						 int& key_y,
+						 const DenseTerrainView& terrain_view,
+						 double query_x,
+						 double query_y) const;
+
+
+	private:
+		/**
+		 * @brief Counts the terrain cells of a bucket
+		 * @param const DenseTerrainView& Dense view of the terrain
+		 * @param int Bucket of the x-axis
+		 * @param int Bucket of the y-axis
+		 */
+		void countBucket(const DenseTerrainView& terrain_view,
+						 int bucket_x,
+						 int bucket_y);
+
+		/** @brief Number of terrain cells per bucket */
+		std::vector<unsigned int> count_;
+
+		/** @brief Minimum key of the indexed view */
+		int min_key_x_, min_key_y_;
+
+		/** @brief Number of cells per axis of the indexed view */
+		int size_x_, size_y_;
+
+		/** @brief Number of buckets per axis */
+		int num_buckets_x_, num_buckets_y_;
+
+		/** @brief Number of cells per bucket side */
+		static const int BUCKET_SIZE = 16;
+};
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef DWL__ENVIRONMENT__TERRAIN_SNAPSHOT__H
+#define DWL__ENVIRONMENT__TERRAIN_SNAPSHOT__H
+
+#include <dwl/environment/TerrainMap.h>
+#include <dwl/environment/DenseTerrainView.h>
+#include <dwl/environment/ObstacleGrid.h>
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/**
+ * @class TerrainSnapshot
+ * @brief Copy of the terrain and obstacle information that is used by the adjacency models, i.e.
+ * the dense view of the terrain, the obstacle grid, the height map and the terrain vertices. A
+ * snapshot is built once from the terrain map and it isn't modified after it's published, so it's
+ * read by the planners without locking while the terrain map keeps integrating new cells
+ */
+class TerrainSnapshot
+{
+	public:
+		/** @brief Constructor function */
+		TerrainSnapshot();
+
+		/** @brief Destructor function */
+		~TerrainSnapshot();
+
+		/**
+		 * @brief Continues the previous version of the snapshot, i.e. it copies the dense view, the
+		 * version and the changed region. The rest of the information is rebuilt by the reset
+		 * @param const TerrainSnapshot& Previous version of the snapshot
+		 */
+		void setPreviousVersion(const TerrainSnapshot& previous);
+
+		/**
+		 * @brief Builds the snapshot from the current terrain information. The snapshot has to
+		 * continue the previous version, so the changed cells are detected w.r.t. that version
+		 * @param TerrainMap* Encapsulates all the terrain information
+		 */
+		void reset(TerrainMap* terrain);
+
+		/**
+		 * @brief Indicates if the snapshot doesn't describe anymore the terrain information. It's an
+		 * O(1) check of the presence of information, the number of terrain and obstacle cells and
+		 * the average terrain cost, so it detects the integrated, removed and re-costed cells
+		 * without walking the maps. A change that keeps all of them has to be notified explicitly
+		 * @param TerrainMap* Encapsulates all the terrain information
+		 * @return True if it's required to build a new snapshot, false otherwise
+		 */
+		bool isOutdated(TerrainMap* terrain) const;
+
+		/**
+		 * @brief Gets the region of cells whose information changed w.r.t. the previous version
+		 * of the view. It doesn't depend on the snapshots that didn't change the view
+		 * @param int& Minimum key of the x-axis
+		 * @param int& Minimum key of the y-axis
+		 * @param int& Maximum key of the x-axis
+		 * @param int& Maximum key of the y-axis
+		 * @return False if the whole view changed
+		 */
+		bool getDirtyRegion(int& min_key_x,
+							int& min_key_y,
+							int& max_key_x,
+							int& max_key_y) const;
+
+		/** @brief Gets the dense view of the terrain */
+		const DenseTerrainView& getTerrainView() const;
+
+		/** @brief Gets the occupancy grid of the obstacles */
+		const ObstacleGrid& getObstacleGrid() const;
+
+		/** @brief Gets the height map of the terrain */
+		const HeightMap& getHeightMap() const;
+
+		/** @brief Gets the terrain vertices in the order of the terrain map */
+		const std::vector<Vertex>& getTerrainVertices() const;
+
+		/** @brief Gets the resolution of the terrain map */
+		double getResolution() const;
+
+		/** @brief Gets the resolution of the obstacle map */
+		double getObstacleResolution() const;
+
+		/** @brief Gets the version of the snapshot, it increases with every published snapshot */
+		uint64_t getVersion() const;
+
+
+	private:
+		/** @brief Dense view of the terrain */
+		DenseTerrainView terrain_view_;
+
+		/** @brief Occupancy grid of the obstacles */
+		ObstacleGrid obstacle_grid_;
+
+		/** @brief Height map of the terrain */
+		HeightMap height_map_;
+
+		/** @brief Terrain vertices in the order of the terrain map */
+		std::vector<Vertex> terrain_vertices_;
+
+		/** @brief Number of cells of the obstacle map */
+		std::size_t num_obstacle_cells_;
+
+		/** @brief Resolution of the terrain and obstacle maps */
+		double resolution_, obstacle_resolution_;
+
+		/** @brief Region of the cells that changed in the last version of the view */
+		int dirty_min_x_, dirty_min_y_, dirty_max_x_, dirty_max_y_;
+
+		/** @brief Indicates if the whole view changed in the last version of the view */
+		bool is_fully_dirty_;
+
+		/** @brief Version of the snapshot */
+		uint64_t version_;
+};
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
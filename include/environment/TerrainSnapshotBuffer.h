@@ -0,0 +1,64 @@
+#ifndef DWL__ENVIRONMENT__TERRAIN_SNAPSHOT_BUFFER__H
+#define DWL__ENVIRONMENT__TERRAIN_SNAPSHOT_BUFFER__H
+
+#include <dwl/environment/TerrainSnapshot.h>
+#include <memory>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/**
+ * @class TerrainSnapshotBuffer
+ * @brief Publishes the versions of the terrain information in RCU style. The mapping thread builds
+ * the next snapshot in a back buffer, and then it swaps the published pointer; the planners pin
+ * the published snapshot for the duration of a query, so they never see a half-integrated map and
+ * they never stop the mapping. A pinned snapshot is released when its last reference is dropped.
+ * The back buffer is the previous snapshot once no planner pins it, so the published snapshots
+ * reuse their memory
+ */
+class TerrainSnapshotBuffer
+{
+	public:
+		/** @brief Constructor function */
+		TerrainSnapshotBuffer();
+
+		/** @brief Destructor function */
+		~TerrainSnapshotBuffer();
+
+		/**
+		 * @brief Publishes a new snapshot of the terrain information, it has to be called always
+		 * from the thread that modifies the terrain map
+		 * @param TerrainMap* Encapsulates all the terrain information
+		 */
+		void publish(TerrainMap* terrain);
+
+		/**
+		 * @brief Gets the last published snapshot, it can be called from any thread. The snapshot
+		 * isn't modified while the returned pointer is kept
+		 * @return The last snapshot, or a null pointer if nothing was published
+		 */
+		std::shared_ptr<const TerrainSnapshot> acquire() const;
+
+		/**
+		 * @brief Gets the version of the last published snapshot
+		 * @return The version of the last snapshot, zero if nothing was published
+		 */
+		uint64_t getVersion() const;
+
+
+	private:
+		/** @brief Last published snapshot, it's only accessed with the atomic operations */
+		std::shared_ptr<const TerrainSnapshot> current_;
+
+		/** @brief Back buffer, i.e. the previously published snapshot */
+		std::shared_ptr<TerrainSnapshot> back_;
+};
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef DWL__ENVIRONMENT__TERRAIN_SNAPSHOT_READER__H
+#define DWL__ENVIRONMENT__TERRAIN_SNAPSHOT_READER__H
+
+#include <dwl/environment/TerrainSnapshotBuffer.h>
+#include <memory>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/**
+ * @class TerrainSnapshotReader
+ * @brief Keeps the terrain snapshot that is read by the queries of an adjacency model. The
+ * snapshots are acquired from a buffer that is published by a mapping thread, or they are
+ * published from the terrain map when its change is detected or notified, or the update is
+ * forced. A pinned snapshot is kept until it's released, and the changed region is reported
+ * w.r.t. the previous version of the dense view
+ */
+class TerrainSnapshotReader
+{
+	public:
+		/** @brief Constructor function */
+		TerrainSnapshotReader();
+
+		/** @brief Destructor function */
+		~TerrainSnapshotReader();
+
+		/**
+		 * @brief Sets the buffer of snapshots that is published by a mapping thread. The current
+		 * snapshot is dropped, since the versions of the views of different buffers aren't related
+		 * @param TerrainSnapshotBuffer* Buffer of terrain snapshots, NULL for publishing the
+		 * snapshots from the terrain map
+		 */
+		void setSharedSnapshots(TerrainSnapshotBuffer* snapshots);
+
+		/** @brief Drops the current snapshot and releases it if it's pinned */
+		void clear();
+
+		/**
+		 * @brief Updates the current snapshot with the last one, unless it's pinned. It doesn't
+		 * allocate if there isn't a new snapshot
+		 * @param TerrainMap* Encapsulates all the terrain information
+		 * @param bool Indicates if the terrain map is published even if its change wasn't detected
+		 * or notified, it's ignored if the snapshots are published by a mapping thread
+		 * @return True if the version of the dense view changed
+		 */
+		bool update(TerrainMap* terrain,
+					bool is_forced);
+
+		/**
+		 * @brief Gets the region of cells that changed in the last update that changed the view
+		 * @param int& Minimum key of the x-axis
+		 * @param int& Minimum key of the y-axis
+		 * @param int& Maximum key of the x-axis
+		 * @param int& Maximum key of the y-axis
+		 * @return False if the changed region isn't known, e.g. the whole view changed or some
+		 * versions of the view were skipped
+		 */
+		bool getDirtyRegion(int& min_key_x,
+							int& min_key_y,
+							int& max_key_x,
+							int& max_key_y) const;
+
+		/** @brief Pins the current snapshot, so the updates keep it until it's released */
+		void pin();
+
+		/** @brief Releases the pinned snapshot, the next update reads the last version */
+		void release();
+
+		/**
+		 * @brief Notifies that the terrain map changed, so the next update publishes it even if
+		 * TerrainSnapshot::isOutdated doesn't detect the change. It's ignored if the snapshots are
+		 * published by a mapping thread
+		 */
+		void notifyChanged();
+
+		/** @brief Gets the current snapshot, it has to be updated before */
+		const TerrainSnapshot& getSnapshot() const;
+
+
+	private:
+		/** @brief Gets the snapshot without terrain information, it's shared by every reader */
+		static const std::shared_ptr<const TerrainSnapshot>& getEmptySnapshot();
+
+		/** @brief Buffer of terrain snapshots published by a mapping thread, if any */
+		TerrainSnapshotBuffer* shared_snapshots_;
+
+		/** @brief Buffer of terrain snapshots published from the terrain map */
+		TerrainSnapshotBuffer terrain_snapshots_;
+
+		/** @brief Current snapshot */
+		std::shared_ptr<const TerrainSnapshot> snapshot_;
+
+		/** @brief Indicates if the current snapshot is pinned */
+		bool is_pinned_;
+
+		/** @brief Indicates if the terrain map changed since its last published snapshot */
+		bool is_terrain_changed_;
+
+		/** @brief Region of the cells that changed in the last update that changed the view */
+		int dirty_min_x_, dirty_min_y_, dirty_max_x_, dirty_max_y_;
+
+		/** @brief Indicates if the changed region of the last update is known */
+		bool is_dirty_region_;
+};
+
+} //@namespace environment
+} //@namespace dwl
+
+#endif
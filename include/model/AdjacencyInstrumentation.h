@@ -0,0 +1,272 @@
+#ifndef DWL__MODEL__ADJACENCY_INSTRUMENTATION__H
+#define DWL__MODEL__ADJACENCY_INSTRUMENTATION__H
+
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+
+/**
+ * The instrumentation of the adjacency models is compiled only if DWL_ADJACENCY_INSTRUMENTATION
+ * is defined, otherwise the instrumentation macros are empty and the counters stay at zero
+ */
+#ifdef DWL_ADJACENCY_INSTRUMENTATION
+#define DWL_INSTRUMENTATION_CONCAT_(a, b) a##b
+#define DWL_INSTRUMENTATION_CONCAT(a, b) DWL_INSTRUMENTATION_CONCAT_(a, b)
+#define DWL_INSTRUMENT_STAGE(instrumentation, stage) \
+	dwl::model::StageTimer DWL_INSTRUMENTATION_CONCAT(stage_timer_, __LINE__)(instrumentation, \
+			dwl::model::AdjacencyInstrumentation::stage)
+#define DWL_INSTRUMENT_FEATURE(instrumentation, feature) \
+	dwl::model::StageTimer DWL_INSTRUMENTATION_CONCAT(feature_timer_, __LINE__)(instrumentation, \
+			dwl::model::AdjacencyInstrumentation::NUM_STAGES + (feature))
+#define DWL_INSTRUMENT_COUNT(instrumentation, counter, value) \
+	(instrumentation).count(dwl::model::AdjacencyInstrumentation::counter, value)
+#else
+#define DWL_INSTRUMENT_STAGE(instrumentation, stage) ((void) 0)
+#define DWL_INSTRUMENT_FEATURE(instrumentation, feature) ((void) 0)
+#define DWL_INSTRUMENT_COUNT(instrumentation, counter, value) ((void) 0)
+#endif
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/** @brief Statistics of a stage of the adjacency models */
+struct StageStatistics
+{
+	/** @brief Number of buckets of the cycle histogram */
+	static const unsigned int NUM_BUCKETS = 32;
+
+	StageStatistics() : calls(0), sampled_calls(0), cycles(0)
+	{
+		for (unsigned int i = 0; i < NUM_BUCKETS; i++)
+			histogram[i] = 0;
+	}
+
+	/** @brief Number of calls */
+	uint64_t calls;
+
+	/** @brief Number of timed calls, i.e. one every sampling period */
+	uint64_t sampled_calls;
+
+	/** @brief Total number of cycles of the timed calls */
+	uint64_t cycles;
+
+	/** @brief Number of timed calls whose cycles are in [2^i, 2^(i+1)) */
+	uint64_t histogram[NUM_BUCKETS];
+};
+
+
+/**
+ * @class AdjacencyInstrumentation
+ * @brief Counters and per-stage cycle histograms of the adjacency models. The recording is done
+ * through the DWL_INSTRUMENT_* macros, which are empty if DWL_ADJACENCY_INSTRUMENTATION isn't
+ * defined. Every call of a stage is counted, but only one call every sampling period is timed,
+ * since reading the cycle counter costs as much as the cheapest stages. It isn't thread-safe, so
+ * every worker thread records in its own instance, which is merged after the threads are joined
+ */
+class AdjacencyInstrumentation
+{
+	public:
+		/** @brief Timed stages of the adjacency models */
+		enum Stage {ADJACENCY_MAP, SUCCESSORS, SEARCH_NEIGHBORS, OBSTACLE_CHECK, STANCE_COST,
+			FEATURE_COST, NUM_STAGES};
+
+		/** @brief Counters of the adjacency models */
+		enum Counter {SAMPLED_CELLS, FIELD_HITS, CACHE_HITS, CACHE_MISSES, REJECTED_PRIMITIVES,
+			LAZY_EDGES, EVALUATED_EDGES, NUM_COUNTERS};
+
+		/** @brief Constructor function */
+		AdjacencyInstrumentation();
+
+		/** @brief Destructor function */
+		~AdjacencyInstrumentation();
+
+		/** @brief Resets all the counters and histograms, the feature names are kept */
+		void reset();
+
+		/**
+		 * @brief Adds the counters and histograms of other instrumentation
+		 * @param const AdjacencyInstrumentation& Other instrumentation
+		 */
+		void merge(const AdjacencyInstrumentation& instrumentation);
+
+		/**
+		 * @brief Sets the name of a body feature, the features are timed by their index
+		 * @param unsigned int Index of the feature
+		 * @param std::string Name of the feature
+		 */
+		void setFeatureName(unsigned int feature,
+							std::string name);
+
+		/**
+		 * @brief Sets the sampling period of the stage timers
+		 * @param unsigned int Sampling period, it's rounded up to a power of two
+		 */
+		void setSamplingPeriod(unsigned int period);
+
+		/** @brief Gets the sampling period of the stage timers */
+		unsigned int getSamplingPeriod() const;
+
+		/**
+		 * @brief Increases a counter
+		 * @param Counter Counter
+		 * @param uint64_t Increment
+		 */
+		void count(Counter counter,
+				   uint64_t value);
+
+		/**
+		 * @brief Counts a call of a stage or feature
+		 * @param unsigned int Stage, or the number of stages plus the index of the feature
+		 * @return The statistics of the stage if the call has to be timed, NULL otherwise
+		 */
+		StageStatistics* beginCall(unsigned int stage);
+
+		/**
+		 * @brief Records the cycles of a timed call
+		 * @param StageStatistics* Statistics of the stage
+		 * @param uint64_t Number of cycles of the call
+		 */
+		static void endCall(StageStatistics* statistics,
+							uint64_t cycles);
+
+		/**
+		 * @brief Gets the value of a counter
+		 * @param Counter Counter
+		 * @return The value of the counter
+		 */
+		uint64_t getCounter(Counter counter) const;
+
+		/**
+		 * @brief Gets the statistics of a stage
+		 * @param Stage Stage
+		 * @return The statistics of the stage
+		 */
+		const StageStatistics& getStage(Stage stage) const;
+
+		/** @brief Gets the statistics of the body features */
+		const std::vector<StageStatistics>& getFeatures() const;
+
+		/** @brief Exports the counters and histograms to JSON */
+		std::string toJson() const;
+
+		/** @brief Indicates if the instrumentation was compiled */
+		static bool isEnabled();
+
+		/** @brief Gets the current cycle counter, or the nanoseconds in non-x86 platforms */
+		static uint64_t getCycles();
+
+
+	private:
+		/** @brief Counters */
+		uint64_t counters_[NUM_COUNTERS];
+
+		/** @brief Statistics of the stages */
+		StageStatistics stages_[NUM_STAGES];
+
+		/** @brief Statistics of the body features */
+		std::vector<StageStatistics> features_;
+
+		/** @brief Names of the body features */
+		std::vector<std::string> feature_names_;
+
+		/** @brief Sampling period minus one of the stage timers */
+		uint64_t sampling_mask_;
+};
+
+
+/**
+ * @class StageTimer
+ * @brief Records the cycles of a scope as a call of a stage or feature
+ */
+class StageTimer
+{
+	public:
+		/**
+		 * @brief Constructor function, it starts the timer
+		 * @param AdjacencyInstrumentation& Instrumentation
+		 * @param unsigned int Stage, or the number of stages plus the index of the feature
+		 */
+		StageTimer(AdjacencyInstrumentation& instrumentation,
+				   unsigned int stage) : statistics_(instrumentation.beginCall(stage)),
+				   start_(statistics_ != NULL ? AdjacencyInstrumentation::getCycles() : 0) {}
+
+		/** @brief Destructor function, it records the cycles of the scope if it's timed */
+		~StageTimer()
+		{
+			if (statistics_ != NULL)
+				AdjacencyInstrumentation::endCall(statistics_,
+						AdjacencyInstrumentation::getCycles() - start_);
+		}
+
+
+	private:
+		/** @brief Statistics of the timed stage, NULL if the call isn't timed */
+		StageStatistics* statistics_;
+
+		/** @brief Cycles at the beginning of the scope */
+		uint64_t start_;
+};
+
+
+inline void AdjacencyInstrumentation::count(Counter counter,
+											uint64_t value)
+{
+	counters_[counter] += value;
+}
+
+
+inline StageStatistics* AdjacencyInstrumentation::beginCall(unsigned int stage)
+{
+	StageStatistics* statistics;
+	if (stage < NUM_STAGES)
+		statistics = &stages_[stage];
+	else {
+		unsigned int feature = stage - NUM_STAGES;
+		if (feature >= features_.size())
+			features_.resize(feature + 1);
+		statistics = &features_[feature];
+	}
+
+	return ((statistics->calls++ & sampling_mask_) == 0) ? statistics : NULL;
+}
+
+
+inline void AdjacencyInstrumentation::endCall(StageStatistics* statistics,
+											  uint64_t cycles)
+{
+	// The bucket is the position of the most significant bit
+	unsigned int bucket = 63 - __builtin_clzll(cycles | 1);
+	if (bucket >= StageStatistics::NUM_BUCKETS)
+		bucket = StageStatistics::NUM_BUCKETS - 1;
+
+	statistics->sampled_calls++;
+	statistics->cycles += cycles;
+	statistics->histogram[bucket]++;
+}
+
+
+inline uint64_t AdjacencyInstrumentation::getCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef DWL__MODEL__BODY_COST_CACHE__H
+#define DWL__MODEL__BODY_COST_CACHE__H
+
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+#include <mutex>
+#include <atomic>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/** @brief Counters of the body cost cache */
+struct BodyCostCacheStatistics
+{
+	BodyCostCacheStatistics() : hits(0), misses(0), evictions(0) {}
+
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long evictions;
+};
+
+
+/**
+ * @class BodyCostCache
+ * @brief Bounded and sharded cache of the terrain (stance) cost of the body states. The entries
+ * are keyed by the body cell, yaw bin and stance pattern of the state. They are invalidated
+ * either by a version stamp (i.e. all of them at once) or by the region of the terrain that
+ * changed. Each shard is a set-associative table protected by its own mutex, so the cache can be
+ * shared by concurrent expansions
+ */
+class BodyCostCache
+{
+	public:
+		/**
+		 * @brief Constructor function
+		 * @param std::size_t Maximum number of entries
+		 */
+		BodyCostCache(std::size_t capacity = 65536);
+
+		/** @brief Destructor function */
+		~BodyCostCache();
+
+		/**
+		 * @brief Sets the maximum number of entries. It removes all the entries
+		 * @param std::size_t Maximum number of entries
+		 */
+		void setCapacity(std::size_t capacity);
+
+		/**
+		 * @brief Gets the key of an entry
+		 * @param int Key of the x-axis of the body cell
+		 * @param int Key of the y-axis of the body cell
+		 * @param unsigned short int Key of the yaw
+		 * @param int Stance pattern
+		 * @return The key of the entry
+		 */
+		static uint64_t getKey(int key_x,
+							   int key_y,
+							   unsigned short int key_yaw,
+							   int pattern);
+
+		/**
+		 * @brief Finds the terrain cost of a state
+		 * @param double& Terrain cost
+		 * @param uint64_t Key of the entry
+		 * @param double Current stance cost of a foot without terrain information
+		 * @return True if there is a valid entry
+		 */
+		bool find(double& cost,
+				  uint64_t key,
+				  double unknown_cost);
+
+		/**
+		 * @brief Finds the terrain cost of a state
+		 * @param double& Terrain cost
+		 * @param bool& Indicates if the cost depends on the stance cost of the unknown feet
+		 * @param uint64_t Key of the entry
+		 * @param double Current stance cost of a foot without terrain information
+		 * @return True if there is a valid entry
+		 */
+		bool find(double& cost,
+				  bool& is_unknown_cost,
+				  uint64_t key,
+				  double unknown_cost);
+
+		/**
+		 * @brief Inserts the terrain cost of a state
+		 * @param uint64_t Key of the entry
+		 * @param double Terrain cost
+		 * @param bool Indicates if the cost depends on the stance cost of the unknown feet
+		 * @param double Stance cost of a foot without terrain information
+		 */
+		void insert(uint64_t key,
+					double cost,
+					bool is_unknown_cost,
+					double unknown_cost);
+
+		/**
+		 * @brief Invalidates the entries whose body cell is inside a region
+		 * @param int Minimum key of the x-axis
+		 * @param int Minimum key of the y-axis
+		 * @param int Maximum key of the x-axis
+		 * @param int Maximum key of the y-axis
+		 */
+		void invalidate(int min_key_x,
+						int min_key_y,
+						int max_key_x,
+						int max_key_y);
+
+		/** @brief Invalidates all the entries by increasing the version stamp */
+		void invalidateAll();
+
+		/** @brief Gets the hit, miss and eviction counters */
+		BodyCostCacheStatistics getStatistics();
+
+		/** @brief Resets the hit, miss and eviction counters */
+		void resetStatistics();
+
+
+	private:
+		/** @brief Entry of the cache */
+		struct Entry
+		{
+			uint64_t key;
+			double cost;
+			double unknown_cost;
+			unsigned int version;
+			unsigned int tick;
+			bool is_unknown_cost;
+		};
+
+		/** @brief Shard of the cache */
+		struct Shard
+		{
+			std::mutex mutex;
+			std::vector<Entry> entries;
+			unsigned int tick;
+			BodyCostCacheStatistics statistics;
+		};
+
+		/**
+		 * @brief Gets the shard and the first entry of the bucket of a key
+		 * @param Shard*& Shard of the key
+		 * @param uint64_t Key of the entry
+		 * @return The index of the first entry of the bucket
+		 */
+		std::size_t getBucket(Shard*& shard,
+							  uint64_t key);
+
+		/** @brief Number of shards */
+		static const unsigned int NUM_SHARDS = 16;
+
+		/** @brief Number of entries per bucket */
+		static const unsigned int BUCKET_SIZE = 4;
+
+		/** @brief Shards of the cache */
+		Shard shards_[NUM_SHARDS];
+
+		/** @brief Number of buckets per shard */
+		std::size_t num_buckets_;
+
+		/** @brief Current version stamp, the version zero indicates an empty entry */
+		std::atomic<unsigned int> version_;
+};
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
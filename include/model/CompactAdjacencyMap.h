@@ -0,0 +1,206 @@
+#ifndef DWL__MODEL__COMPACT_ADJACENCY_MAP__H
+#define DWL__MODEL__COMPACT_ADJACENCY_MAP__H
+
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+#include <algorithm>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/**
+ * @class CompactAdjacencyMap
+ * @brief Adjacency map in a compressed sparse row (CSR) format. The source and target vertices
+ * are kept in a sorted vertex table, and the edges of every source are packed contiguously as
+ * 32-bit column indices into the table (i.e. the rows of the targets) and float weights. A row
+ * is found by a binary search over the table. It's an immutable graph, so it's built once from
+ * the edges of the adjacency model
+ */
+class CompactAdjacencyMap
+{
+	public:
+		/** @brief Constructor function */
+		CompactAdjacencyMap();
+
+		/** @brief Destructor function */
+		~CompactAdjacencyMap();
+
+		/** @brief Removes all the vertices and edges */
+		void clear();
+
+		/**
+		 * @brief Builds the compact map from lists of (source vertex, edge) pairs. The edges of
+		 * every source keep the order of the lists
+		 * @param const std::vector<const std::vector<std::pair<Vertex, Edge> >*>& Lists of edges
+		 */
+		void build(const std::vector<const std::vector<std::pair<Vertex, Edge> >*>& edge_lists);
+
+		/**
+		 * @brief Builds the compact map from an adjacency map
+		 * @param const AdjacencyMap& Adjacency map
+		 */
+		void build(const AdjacencyMap& adjacency_map);
+
+		/**
+		 * @brief Converts the compact map to an adjacency map
+		 * @param AdjacencyMap& Adjacency map
+		 */
+		void toAdjacencyMap(AdjacencyMap& adjacency_map) const;
+
+		/**
+		 * @brief Gets the row of a vertex, the rows of the vertices without outgoing edges are
+		 * empty
+		 * @param Vertex Vertex
+		 * @return The row of the vertex, or -1 if the vertex isn't a source or target of any edge
+		 */
+		int getRow(Vertex vertex) const;
+
+		/**
+		 * @brief Gets the edges of a source vertex
+		 * @param std::vector<Edge>& Edges of the vertex
+		 * @param Vertex Source vertex
+		 */
+		void getEdges(std::vector<Edge>& edges,
+					  Vertex vertex) const;
+
+		/** @brief Gets the number of vertices (rows), i.e. the sources and targets of the edges */
+		unsigned int getNumberOfVertices() const;
+
+		/** @brief Gets the number of edges */
+		unsigned int getNumberOfEdges() const;
+
+		/**
+		 * @brief Gets the vertex of a row
+		 * @param unsigned int Row
+		 * @return The vertex
+		 */
+		Vertex getVertex(unsigned int row) const;
+
+		/**
+		 * @brief Gets the index of the first edge of a row
+		 * @param unsigned int Row
+		 * @return The index of the first edge
+		 */
+		unsigned int getRowBegin(unsigned int row) const;
+
+		/**
+		 * @brief Gets the index after the last edge of a row
+		 * @param unsigned int Row
+		 * @return The index after the last edge
+		 */
+		unsigned int getRowEnd(unsigned int row) const;
+
+		/**
+		 * @brief Gets the target vertex of an edge
+		 * @param unsigned int Index of the edge
+		 * @return The target vertex
+		 */
+		Vertex getTarget(unsigned int edge) const;
+
+		/**
+		 * @brief Gets the row of the target vertex of an edge, i.e. its column
+		 * @param unsigned int Index of the edge
+		 * @return The row of the target vertex
+		 */
+		unsigned int getTargetRow(unsigned int edge) const;
+
+		/**
+		 * @brief Gets the weight of an edge
+		 * @param unsigned int Index of the edge
+		 * @return The weight
+		 */
+		Weight getWeight(unsigned int edge) const;
+
+		/** @brief Gets the memory (in bytes) used by the compact map */
+		std::size_t getMemoryUsage() const;
+
+
+	private:
+		/**
+		 * @brief Sorts and removes the duplicates of the vertex table, and checks that the rows
+		 * and edges can be indexed with 32 bits
+		 * @param std::size_t Number of edges
+		 * @return False if the map is too big, then it's cleared
+		 */
+		bool buildVertexTable(std::size_t num_edges);
+
+		/** @brief Sorted source and target vertices */
+		std::vector<Vertex> vertices_;
+
+		/** @brief Index of the first edge of every row, plus the number of edges */
+		std::vector<uint32_t> offsets_;
+
+		/** @brief Rows of the target vertices of the edges (columns) */
+		std::vector<uint32_t> targets_;
+
+		/** @brief Weights of the edges */
+		std::vector<float> weights_;
+};
+
+
+inline int CompactAdjacencyMap::getRow(Vertex vertex) const
+{
+	std::vector<Vertex>::const_iterator vertex_iter =
+			std::lower_bound(vertices_.begin(), vertices_.end(), vertex);
+	if ((vertex_iter == vertices_.end()) || (*vertex_iter != vertex))
+		return -1;
+
+	return vertex_iter - vertices_.begin();
+}
+
+
+inline unsigned int CompactAdjacencyMap::getNumberOfVertices() const
+{
+	return vertices_.size();
+}
+
+
+inline unsigned int CompactAdjacencyMap::getNumberOfEdges() const
+{
+	return targets_.size();
+}
+
+
+inline Vertex CompactAdjacencyMap::getVertex(unsigned int row) const
+{
+	return vertices_[row];
+}
+
+
+inline unsigned int CompactAdjacencyMap::getRowBegin(unsigned int row) const
+{
+	return offsets_[row];
+}
+
+
+inline unsigned int CompactAdjacencyMap::getRowEnd(unsigned int row) const
+{
+	return offsets_[row + 1];
+}
+
+
+inline Vertex CompactAdjacencyMap::getTarget(unsigned int edge) const
+{
+	return vertices_[targets_[edge]];
+}
+
+
+inline unsigned int CompactAdjacencyMap::getTargetRow(unsigned int edge) const
+{
+	return targets_[edge];
+}
+
+
+inline Weight CompactAdjacencyMap::getWeight(unsigned int edge) const
+{
+	return weights_[edge];
+}
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
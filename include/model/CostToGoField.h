@@ -0,0 +1,149 @@
+#ifndef DWL__MODEL__COST_TO_GO_FIELD__H
+#define DWL__MODEL__COST_TO_GO_FIELD__H
+
+#include <dwl/environment/TerrainMap.h>
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+#include <atomic>
+#include <limits>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/**
+ * @class CostToGoField
+ * @brief Dense 2D field of the cost-to-go of a goal over the graph of the grid-based body adjacency,
+ * i.e. the output of computeAdjacencyMap. The field is computed with a backward Dijkstra from the
+ * goal, which is parallelized with delta-stepping: the vertices are settled in buckets of costs, and
+ * the edges of a bucket are relaxed concurrently with an atomic minimum of the costs. The vertices
+ * are merged by terrain cell (i.e. the yaw is ignored), so the cost of a state vertex is read in O(1)
+ * and it can be used as an informed heuristic of the lattice-based body adjacency
+ */
+class CostToGoField
+{
+	public:
+		/** @brief Constructor function */
+		CostToGoField();
+
+		/** @brief Destructor function */
+		~CostToGoField();
+
+		/**
+		 * @brief Computes the field of a goal, the weights of the edges have to be non-negative
+		 * @param const AdjacencyMap& Adjacency map of the grid-based body adjacency
+		 * @param Vertex Goal state vertex
+		 * @param TerrainMap* Encapsulates all the terrain information, it describes the space of
+		 * the state vertices
+		 * @return False if the goal isn't a vertex of the adjacency map
+		 */
+		bool compute(const AdjacencyMap& adjacency_map,
+					 Vertex goal,
+					 environment::TerrainMap* terrain);
+
+		/**
+		 * @brief Sets the number of threads of the computation of the field. The threads are
+		 * created once per computation and they relax every large frontier concurrently
+		 * @param unsigned int Number of threads, zero for using all the hardware threads
+		 */
+		void setNumberOfThreads(unsigned int num_threads);
+
+		/**
+		 * @brief Sets the width of the cost buckets of the delta-stepping. The buckets are reused
+		 * cyclically, so the width is bounded by the largest weight of the edges over the maximum
+		 * number of buckets
+		 * @param double Width of the buckets, zero for using the average weight of the edges
+		 */
+		void setBucketWidth(double bucket_width);
+
+		/**
+		 * @brief Gets the cost-to-go of a state vertex
+		 * @param double& Cost-to-go
+		 * @param Vertex State vertex
+		 * @return False if the goal can't be reached from the vertex
+		 */
+		bool getCost(double& cost,
+					 Vertex state_vertex) const;
+
+		/**
+		 * @brief Gets the cost-to-go of a terrain cell
+		 * @param double& Cost-to-go
+		 * @param int Key of the x-axis of the cell
+		 * @param int Key of the y-axis of the cell
+		 * @return False if the goal can't be reached from the cell
+		 */
+		bool getCost(double& cost,
+					 int key_x,
+					 int key_y) const;
+
+		/** @brief Indicates if the field was computed */
+		bool isComputed() const;
+
+		/** @brief Gets the goal state vertex of the field */
+		Vertex getGoal() const;
+
+
+	private:
+		/**
+		 * @brief Relaxes the incoming edges of a range of vertices of the frontier
+		 * @param std::atomic<uint64_t>* Costs of the vertices, as the bits of non-negative doubles
+		 * @param const std::vector<unsigned int>& Frontier, i.e. vertices of the current bucket
+		 * @param std::size_t First vertex of the range
+		 * @param std::size_t Last vertex of the range (not included)
+		 * @param std::vector<unsigned int>& Vertices whose cost decreased
+		 */
+		void relaxVertices(std::atomic<uint64_t>* costs,
+						   const std::vector<unsigned int>& frontier,
+						   std::size_t first,
+						   std::size_t end,
+						   std::vector<unsigned int>& relaxed) const;
+
+		/** @brief Encapsulates all the terrain information */
+		environment::TerrainMap* terrain_;
+
+		/** @brief Incoming edges of every cell in CSR format, i.e. the reverse graph */
+		std::vector<unsigned int> offsets_;
+		std::vector<unsigned int> sources_;
+		std::vector<double> weights_;
+
+		/** @brief Cost-to-go of every cell of the field */
+		std::vector<double> cost_;
+
+		/** @brief Bounding box of the field */
+		int min_key_x_, min_key_y_, size_x_, size_y_;
+
+		/** @brief Goal state vertex */
+		Vertex goal_;
+
+		/** @brief Number of threads */
+		unsigned int num_threads_;
+
+		/** @brief Width of the cost buckets, zero for the average weight of the edges */
+		double bucket_width_;
+
+		/** @brief Indicates if the field was computed */
+		bool is_computed_;
+};
+
+
+inline bool CostToGoField::getCost(double& cost,
+								   int key_x,
+								   int key_y) const
+{
+	int x = key_x - min_key_x_;
+	int y = key_y - min_key_y_;
+	if (((unsigned int) x >= (unsigned int) size_x_) ||
+			((unsigned int) y >= (unsigned int) size_y_))
+		return false;
+
+	cost = cost_[y * size_x_ + x];
+	return cost != std::numeric_limits<double>::max();
+}
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
@@ -2,9 +2,24 @@
 #define DWL__MODEL__GRID_BASED_BODY_ADJACENCY__H
 
 #include <dwl/model/AdjacencyModel.h>
+#include <dwl/model/StanceStencils.h>
+#include <dwl/model/NeighborStencil.h>
+#include <dwl/model/StanceCostKernel.h>
+#include <dwl/model/StanceCostField.h>
+#include <dwl/model/BodyCostCache.h>
+#include <dwl/model/CompactAdjacencyMap.h>
+#include <dwl/model/QueryArena.h>
+#include <dwl/model/AdjacencyInstrumentation.h>
 #include <dwl/robot/Robot.h>
 #include <dwl/environment/TerrainMap.h>
+#include <dwl/environment/DenseTerrainView.h>
+#include <dwl/environment/TerrainSnapshotReader.h>
+#include <dwl/environment/TerrainCellIndex.h>
 #include <dwl/environment/Feature.h>
+#include <dwl/environment/BatchFeature.h>
+#include <dwl/environment/FeatureAdapter.h>
+#include <thread>
+#include <atomic>
 
 
 namespace dwl
@@ -13,6 +28,42 @@ namespace dwl
 namespace model
 {
 
+/**
+ * @brief Change of an edge of the adjacency map. The weight of a missing edge (i.e. an added or
+ * removed edge) is the maximum weight
+ */
+struct EdgeChange
+{
+	EdgeChange() : source(0), target(0), old_weight(0), new_weight(0) {}
+	EdgeChange(Vertex _source, Vertex _target, Weight _old_weight, Weight _new_weight) :
+		source(_source), target(_target), old_weight(_old_weight), new_weight(_new_weight) {}
+
+	Vertex source;
+	Vertex target;
+	Weight old_weight;
+	Weight new_weight;
+};
+
+
+/** @brief Orders the edge changes by source and target vertex */
+inline bool edge_change_less(const EdgeChange& a, const EdgeChange& b)
+{
+	return (a.source < b.source) || ((a.source == b.source) && (a.target < b.target));
+}
+
+
+/**
+ * @brief Reusable buffers of the chunks of terrain vertices of a thread. They are cleared for
+ * every chunk and keep their capacity, so the warm builds of the adjacency map don't allocate them
+ */
+struct ChunkBuffers
+{
+	std::vector<environment::FeatureState> feature_states;
+	std::vector<double> feature_costs;
+	std::vector<Vertex> neighbor_actions;
+};
+
+
 /**
  * @class GridBasedBodyAdjacency
  * @brief Class for building a grid-based body adjacency map of the environment. This class derives from
@@ -45,6 +96,47 @@ class GridBasedBodyAdjacency : public AdjacencyModel
 								 Vertex source,
 								 Vertex target);
 
+		/**
+		 * @brief Computes the whole adjacency map in a compressed sparse row format
+		 * @param CompactAdjacencyMap& Compact adjacency map
+		 * @param Vertex Source vertex
+		 * @param Vertex Target vertex
+		 */
+		void computeAdjacencyMap(CompactAdjacencyMap& adjacency_map,
+								 Vertex source,
+								 Vertex target);
+
+		/**
+		 * @brief Updates the adjacency map after a change of some terrain cells. Only the incoming
+		 * edges of the states whose stance areas, neighboring areas or feature footprints overlap
+		 * the changed cells are computed again. If a body feature doesn't define its footprint
+		 * radius, the edges of every state are computed again. The adjacency map has to be computed
+		 * before with computeAdjacencyMap
+		 * @param AdjacencyMap& Adjacency map
+		 * @param const std::vector<Vertex>& Terrain vertices that changed (i.e. added, removed or
+		 * with a new cost)
+		 * @param std::vector<EdgeChange>& Edges that were added, removed or changed their weight
+		 */
+		void updateAdjacencyMap(AdjacencyMap& adjacency_map,
+								const std::vector<Vertex>& changed_cells,
+								std::vector<EdgeChange>& changed_edges);
+
+		/**
+		 * @brief Sets the number of threads used for computing the whole adjacency map. The
+		 * terrain vertices are partitioned in chunks, and the edges of every chunk are merged in
+		 * order, so the adjacency map is the same than the serial one. It's computed by one thread
+		 * if a single-state body feature was added, since those features aren't reentrant
+		 * @param unsigned int Number of threads, zero uses the hardware concurrency
+		 */
+		void setNumberOfThreads(unsigned int num_threads);
+
+		/**
+		 * @brief Sets the number of neighboring directions of the grid. A previous adjacency map has
+		 * to be computed again before updating it
+		 * @param unsigned int Number of directions, i.e. 8 (default), 16 or 32
+		 */
+		void setNeighborConnectivity(unsigned int connectivity);
+
 		/**
 		 * @brief Gets the successors of the current vertex
 		 * @param std::list<Edge>& List of successors
@@ -53,8 +145,155 @@ class GridBasedBodyAdjacency : public AdjacencyModel
 		void getSuccessors(std::list<Edge>& successors,
 						   Vertex state_vertex);
 
+		/**
+		 * @brief Gets the successors of the current vertex in a reusable buffer. The buffer is
+		 * cleared, and it doesn't allocate memory once it reached its capacity
+		 * @param std::vector<Edge>& Buffer of successors
+		 * @param Vertex Current state vertex
+		 */
+		void getSuccessors(std::vector<Edge>& successors,
+						   Vertex state_vertex);
+
+		/**
+		 * @brief Gets the cache of the body costs, which exposes its hit, miss and eviction
+		 * counters
+		 * @return The body cost cache
+		 */
+		BodyCostCache& getBodyCostCache();
+
+		/**
+		 * @brief Adds a single-state body feature, which is evaluated in batches through an
+		 * adapter. The feature isn't owned by the adjacency model, and the whole adjacency map is
+		 * computed by one thread while it's added
+		 * @param environment::Feature* Pointer to the body feature
+		 * @param double Footprint radius (m) of the feature, negative if it isn't known (then
+		 * updateAdjacencyMap recomputes every state)
+		 */
+		void addFeature(environment::Feature* feature,
+						double footprint_radius = -1.);
+
+		/**
+		 * @brief Adds a batch body feature. The feature isn't owned by the adjacency model, and it
+		 * has to be reentrant if the adjacency map is computed by several threads
+		 * @param environment::BatchFeature* Pointer to the batch feature
+		 */
+		void addFeature(environment::BatchFeature* feature);
+
+		/**
+		 * @brief Reads the terrain information from the snapshots published by a mapping thread,
+		 * instead of the terrain map, so the map integration doesn't stop while planning. The
+		 * terrain map is still used for its space discretization, which has to stay constant
+		 * @param environment::TerrainSnapshotBuffer* Buffer of terrain snapshots, NULL for
+		 * publishing the snapshots from the terrain map
+		 */
+		void setTerrainSnapshots(environment::TerrainSnapshotBuffer* snapshots);
+
+		/**
+		 * @brief Pins the last terrain snapshot, so the next queries read the same version of the
+		 * terrain information until it's released
+		 */
+		void pinTerrainSnapshot();
+
+		/** @brief Releases the pinned terrain snapshot, the next queries read the last version */
+		void releaseTerrainSnapshot();
+
+		/**
+		 * @brief Notifies that the terrain or obstacle information of the terrain map changed, so
+		 * the next query publishes a new snapshot of it. The queries already publish a new snapshot
+		 * if the number of terrain or obstacle cells or the average terrain cost changed, so it's
+		 * only required for the changes that keep all of them. It's ignored if the snapshots are
+		 * published by a mapping thread
+		 */
+		void notifyTerrainChanged();
+
+		/**
+		 * @brief Gets the instrumentation of the adjacency model, i.e. the per-stage counters and
+		 * cycle histograms. It's recorded only if DWL_ADJACENCY_INSTRUMENTATION is defined
+		 * @return The instrumentation
+		 */
+		AdjacencyInstrumentation& getInstrumentation();
+
 
 	private:
+		/**
+		 * @brief Updates the terrain snapshot and its dense view of the terrain, and invalidates the
+		 * cached body costs affected by the terrain changes. The pinned snapshot is kept
+		 * @param bool Indicates if the terrain map is published even if its change wasn't detected
+		 * or notified, it's ignored if the snapshots are published by a mapping thread
+		 */
+		void updateTerrainView(bool is_forced);
+
+		/**
+		 * @brief Computes the edges of the whole adjacency map, i.e. the snapping edges of the
+		 * source and target vertex and the edges of every chunk of terrain vertices
+		 * @param Vertex Source vertex
+		 * @param Vertex Target vertex
+		 * @return False if there isn't terrain information
+		 */
+		bool computeAdjacencyEdges(Vertex source,
+								   Vertex target);
+
+		/**
+		 * @brief Updates the incoming edges of the states affected by the changed terrain cells.
+		 * Its temporaries are taken from the arena of the queries
+		 * @param AdjacencyMap& Adjacency map
+		 * @param const std::vector<Vertex>& Terrain vertices that changed
+		 * @param std::vector<EdgeChange>& Edges that were added, removed or changed their weight
+		 */
+		void updateAdjacencyEdges(AdjacencyMap& adjacency_map,
+								  const std::vector<Vertex>& changed_cells,
+								  std::vector<EdgeChange>& changed_edges);
+
+		/**
+		 * @brief Computes the edges of a chunk of terrain vertices, i.e. the pairs of neighbor
+		 * vertex and edge to the state vertex of every terrain vertex
+		 * @param std::vector<std::pair<Vertex, Edge> >& Edges of the chunk
+		 * @param std::vector<uint32_t>& Packed keys of the states with unknown feet
+		 * @param unsigned int Index of the chunk
+		 * @param double Orientation of the body
+		 * @param StanceCostKernel& Stance cost kernel of the thread
+		 * @param QueryArena& Arena of the temporaries of the thread
+		 * @param ChunkBuffers& Reusable buffers of the thread
+		 * @param AdjacencyInstrumentation& Instrumentation of the thread
+		 */
+		void computeChunkEdges(std::vector<std::pair<Vertex, Edge> >& edges,
+							   std::vector<uint32_t>& unknown_cost_cells,
+							   unsigned int chunk,
+							   double yaw,
+							   StanceCostKernel& kernel,
+							   QueryArena& arena,
+							   ChunkBuffers& buffers,
+							   AdjacencyInstrumentation& instrumentation);
+
+		/**
+		 * @brief Applies a change of an edge to the adjacency map, the edge is added or removed if
+		 * its old or new weight is the maximum weight
+		 * @param AdjacencyMap& Adjacency map
+		 * @param const EdgeChange& Change of the edge
+		 */
+		void applyEdgeChange(AdjacencyMap& adjacency_map,
+							 const EdgeChange& change);
+
+		/**
+		 * @brief Indicates if the closest terrain vertex of a vertex could change after a change of
+		 * some terrain cells, i.e. a changed cell is within the distance to the closest vertex
+		 * @param const std::vector<Vertex>& Terrain vertices that changed
+		 * @param Vertex Snapped vertex
+		 * @param Vertex Closest terrain vertex of the snapped vertex
+		 * @return True if the vertex has to be snapped again
+		 */
+		bool isSnappingAffected(const std::vector<Vertex>& changed_cells,
+								Vertex vertex,
+								Vertex closest_vertex);
+
+		/**
+		 * @brief Sets the snapping edges of the source and target vertex of the adjacency map
+		 * @param Vertex The closest vertex to the source
+		 * @param Vertex The closest vertex to the target
+		 */
+		void setSnappingEdges(Vertex closest_source,
+							  Vertex closest_target);
+
 		/**
 		  * @brief Gets the closest start and goal vertex if it is not belong to
 		  * the terrain information
@@ -68,6 +307,25 @@ class GridBasedBodyAdjacency : public AdjacencyModel
 											 Vertex source,
 											 Vertex target);
 
+		/**
+		 * @brief Gets the closest terrain vertex, which is the same vertex if it belongs to the
+		 * terrain information
+		 * @param Vertex& The closest terrain vertex
+		 * @param Vertex Vertex
+		 */
+		void getTheClosestTerrainVertex(Vertex& closest_vertex,
+										Vertex vertex);
+
+		/**
+		 * @brief Gets the state vertex of a terrain cell given a body orientation
+		 * @param Vertex& State vertex
+		 * @param const Key& Key of the terrain cell
+		 * @param double Orientation of the body
+		 */
+		void getStateVertex(Vertex& state_vertex,
+							const Key& terrain_key,
+							double yaw);
+
 		/**
 		 * @brief Searches the neighbors of a current vertex
 		 * @param std::vector<Vertex>& The set of states neighbors
@@ -77,12 +335,68 @@ class GridBasedBodyAdjacency : public AdjacencyModel
 							 Vertex state_vertex);
 
 		/**
-		 * @brief Computes the body cost of a current vertex
+		 * @brief Computes the terrain (stance) cost of a current vertex using a certain stance
+		 * cost kernel, the cost of the body features is added later for the whole batch
+		 * @param double& Terrain cost
+		 * @param bool& Indicates if the cost depends on the stance cost of the unknown feet
 		 * @param Vertex Current state vertex
+		 * @param StanceCostKernel& Stance cost kernel
+		 * @param AdjacencyInstrumentation& Instrumentation of the thread
 		 */
-		void computeBodyCost(double& cost,
+		void computeStanceCost(double& cost,
+							   bool& is_unknown_cost,
+							   Vertex state_vertex,
+							   StanceCostKernel& kernel,
+							   AdjacencyInstrumentation& instrumentation);
+
+		/**
+		 * @brief Gets the feature state of a current vertex with the default body action
+		 * @param environment::FeatureState& Feature state
+		 * @param Vertex Current state vertex
+		 */
+		void getFeatureState(environment::FeatureState& feature_state,
 							 Vertex state_vertex);
 
+		/**
+		 * @brief Adds the weighted cost of the body features to a batch of body costs
+		 * @param double* Body costs of the batch, one per body state
+		 * @param const std::vector<environment::FeatureState>& Batch of body states
+		 * @param std::vector<double>& Buffer of the feature costs
+		 * @param AdjacencyInstrumentation& Instrumentation of the thread
+		 */
+		void computeFeatureCosts(double* costs,
+								 const std::vector<environment::FeatureState>& states,
+								 std::vector<double>& feature_costs,
+								 AdjacencyInstrumentation& instrumentation);
+
+		/**
+		 * @brief Gets the stance stencil of the default stance areas for a certain yaw bin
+		 * @param unsigned short int Key of the yaw
+		 * @return The stance stencil
+		 */
+		const StanceStencil& getStanceStencil(unsigned short int key_yaw);
+
+		/**
+		 * @brief Computes the stance cost field of the default stance areas for a certain yaw
+		 * bin, if it doesn't describe the current terrain view
+		 * @param unsigned short int Key of the yaw
+		 */
+		void updateStanceCostField(unsigned short int key_yaw);
+
+		/**
+		 * @brief Gets the terrain cost of a body cell from the stance cost field of the default
+		 * stance areas, if the field describes the current terrain view
+		 * @param double& Terrain cost
+		 * @param bool& Indicates if the cost depends on the stance cost of the unknown feet
+		 * @param unsigned short int Key of the yaw
+		 * @param const Key& Key of the body cell
+		 * @return False if there isn't an updated field
+		 */
+		bool getFieldCost(double& cost,
+						  bool& is_unknown_cost,
+						  unsigned short int key_yaw,
+						  const Key& terrain_key);
+
 		/** @brief Asks if it is requested a stance adjacency */
 		bool isStanceAdjacency();
 
@@ -93,8 +407,20 @@ class GridBasedBodyAdjacency : public AdjacencyModel
 		/** @brief Pointer of the TerrainMap object which describes the terrain */
 		environment::TerrainMap* terrain_;
 
-		/** @brief Vector of pointers to the Feature class */
-		std::vector<environment::Feature*> features_;
+		/** @brief Terrain snapshot that is read by the queries */
+		environment::TerrainSnapshotReader snapshot_reader_;
+
+		/** @brief Dense and read-only view of the terrain information of the terrain snapshot */
+		const environment::DenseTerrainView* terrain_view_;
+
+		/** @brief Spatial index of the terrain cells for the closest vertex queries */
+		environment::TerrainCellIndex terrain_index_;
+
+		/** @brief Vector of pointers to the body features */
+		std::vector<environment::BatchFeature*> features_;
+
+		/** @brief Adapters of the single-state body features */
+		std::vector<environment::FeatureAdapter*> feature_adapters_;
 
 		/** @brief Indicates it was requested a stance or terrain adjacency */
 		bool is_stance_adjacency_;
@@ -105,11 +431,94 @@ class GridBasedBodyAdjacency : public AdjacencyModel
 		/** @brief Definition of the neighboring area (number of neighbors per size) */
 		int neighboring_definition_;
 
+		/** @brief Neighbor offsets sorted by radius and direction */
+		NeighborStencil neighbor_stencil_;
+
+		/** @brief Stance-sampling stencils per yaw bin and stance pattern */
+		StanceStencils stance_stencils_;
+
+		/** @brief Kernel for computing the stance cost */
+		StanceCostKernel stance_cost_kernel_;
+
+		/** @brief Stance cost fields per yaw bin and stance pattern */
+		std::vector<StanceCostField> stance_cost_fields_;
+
+		/** @brief Cache of the terrain cost of the body states */
+		BodyCostCache body_cost_cache_;
+
+		/** @brief Reusable buffer of successors for the list interface */
+		std::vector<Edge> successor_buffer_;
+
+		/** @brief Reusable buffer of neighbor states */
+		std::vector<Vertex> neighbor_buffer_;
+
+		/** @brief Reusable buffers of the body feature batch of the successors */
+		std::vector<environment::FeatureState> feature_state_buffer_;
+		std::vector<double> body_cost_buffer_;
+		std::vector<double> feature_cost_buffer_;
+
+		/** @brief Stance pattern of the default stance areas */
+		int stance_pattern_;
+
 		/** @brief Number of top cost for computing the stance cost */
 		int number_top_cost_;
 
 		/** @brief Uncertainty factor which is applied in non-perceived environment */
 		double uncertainty_factor_; // For unknown (non-perceive) areas
+
+		/** @brief Number of threads for computing the whole adjacency map */
+		unsigned int num_threads_;
+
+		/** @brief Stance cost kernels of the worker threads */
+		std::vector<StanceCostKernel> thread_kernels_;
+
+		/** @brief Arena of the temporaries of the queries, it's reset at the end of every query */
+		QueryArena arena_;
+
+		/** @brief Arenas of the temporaries of the worker threads */
+		std::vector<QueryArena*> thread_arenas_;
+
+		/** @brief Reusable buffers of the chunks of every thread, they keep their capacity */
+		std::vector<ChunkBuffers> thread_buffers_;
+
+		/** @brief Per-stage counters and cycle histograms */
+		AdjacencyInstrumentation instrumentation_;
+
+		/** @brief Instrumentation of the worker threads, it's merged after every build */
+		std::vector<AdjacencyInstrumentation> thread_instrumentation_;
+
+		/** @brief Edges that connect the source and target vertex with the terrain */
+		std::vector<std::pair<Vertex, Edge> > snapping_edges_;
+
+		/** @brief Edge buffers of every chunk of terrain vertices */
+		std::vector<std::vector<std::pair<Vertex, Edge> > > chunk_edges_;
+
+		/** @brief Number of chunks of the adjacency map that is being computed */
+		unsigned int num_chunks_;
+
+		/** @brief Packed keys of the states with unknown feet of every chunk */
+		std::vector<std::vector<uint32_t> > chunk_unknown_cost_cells_;
+
+		/** @brief Yaw bin of the last computed adjacency map, -1 if it wasn't computed */
+		int adjacency_key_yaw_;
+
+		/** @brief Average terrain cost of the last computed or updated adjacency map */
+		double adjacency_average_cost_;
+
+		/** @brief Source and target vertex of the last computed adjacency map */
+		Vertex adjacency_source_, adjacency_target_;
+
+		/** @brief Closest terrain vertices of the source and target vertex of the adjacency map */
+		Vertex adjacency_closest_source_, adjacency_closest_target_;
+
+		/**
+		 * @brief Sorted and packed keys of the states whose cost depends on the average terrain
+		 * cost, i.e. the states with unknown feet
+		 */
+		std::vector<uint32_t> unknown_cost_cells_;
+
+		/** @brief Number of terrain vertices per chunk */
+		static const unsigned int CHUNK_SIZE = 1024;
 };
 
 } //@namespace model
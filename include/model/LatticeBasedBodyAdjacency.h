@@ -2,9 +2,18 @@
 #define DWL__MODEL__LATTICE_BASED_BODY_ADJACENCY__H
 
 #include <dwl/model/AdjacencyModel.h>
+#include <dwl/model/StanceStencils.h>
+#include <dwl/model/StanceCostKernel.h>
+#include <dwl/model/BodyCostCache.h>
+#include <dwl/model/AdjacencyInstrumentation.h>
 #include <dwl/robot/Robot.h>
 #include <dwl/environment/TerrainMap.h>
+#include <dwl/environment/DenseTerrainView.h>
+#include <dwl/environment/ObstacleGrid.h>
+#include <dwl/environment/TerrainSnapshotReader.h>
 #include <dwl/environment/Feature.h>
+#include <dwl/environment/BatchFeature.h>
+#include <dwl/environment/FeatureAdapter.h>
 
 
 
@@ -14,6 +23,36 @@ namespace dwl
 namespace model
 {
 
+/**
+ * @brief Successor of a body motor primitive for a certain start yaw bin. The primitives are
+ * translation-invariant, so the successor is described by integer key deltas w.r.t. the start cell
+ */
+struct PrimitiveSuccessor
+{
+	PrimitiveSuccessor() : dx(0), dy(0), key_yaw(0), yaw(0), cost(0), parallel_index(0),
+			parallel_cost(0) {}
+
+	/** @brief Key deltas of the successor cell w.r.t. the start cell */
+	int dx, dy;
+
+	/** @brief Key and orientation of the end yaw bin */
+	unsigned short int key_yaw;
+	double yaw;
+
+	/** @brief Displacement (x,y,yaw) of the primitive in the world frame */
+	Eigen::Vector3d action;
+
+	/** @brief Cost of the primitive */
+	double cost;
+
+	/** @brief Index of the first primitive that reaches the same successor */
+	unsigned int parallel_index;
+
+	/** @brief Minimum cost of the primitives that reach the same successor */
+	double parallel_cost;
+};
+
+
 /**
  * @class LatticeBasedBodyAdjacency
  * @brief Class for building a lattice-based adjacency map of the environment. This class derives
@@ -45,8 +84,106 @@ class LatticeBasedBodyAdjacency : public AdjacencyModel
 		void getSuccessors(std::list<Edge>& successors,
 						   Vertex state_vertex);
 
+		/**
+		 * @brief Gets the successors of the current vertex in a reusable buffer. The buffer is
+		 * cleared, and it doesn't allocate memory once it reached its capacity
+		 * @param std::vector<Edge>& Buffer of successors
+		 * @param Vertex Current state vertex
+		 */
+		void getSuccessors(std::vector<Edge>& successors,
+						   Vertex state_vertex);
+
+		/**
+		 * @brief Sets the lazy evaluation of the successors (Lazy Weighted A*). The successors are
+		 * emitted with an admissible lower bound of their cost, i.e. the primitive cost plus the
+		 * minimum terrain cost, and without the obstacle check. The search gets the exact cost
+		 * with evaluateEdge when it pops the edge. The primitives that reach the same successor
+		 * are emitted as one edge, and the body features have to be non-negative
+		 * @param bool True for evaluating the successors lazily
+		 */
+		void setLazyEvaluation(bool is_lazy);
+
+		/** @brief Indicates if the successors are evaluated lazily */
+		bool isLazyEvaluation() const;
+
+		/**
+		 * @brief Evaluates the exact cost of an edge that was emitted lazily, i.e. the obstacle
+		 * check and the body cost of the cheapest primitive that reaches the target vertex
+		 * @param Weight& Exact cost of the edge
+		 * @param Vertex Source state vertex
+		 * @param Vertex Target state vertex
+		 * @return False if the target vertex isn't reachable, e.g. it collides with an obstacle
+		 */
+		bool evaluateEdge(Weight& cost,
+						  Vertex source,
+						  Vertex target);
+
+		/**
+		 * @brief Gets the cache of the body costs, which exposes its hit, miss and eviction
+		 * counters
+		 * @return The body cost cache
+		 */
+		BodyCostCache& getBodyCostCache();
+
+		/**
+		 * @brief Adds a single-state body feature, which is evaluated in batches through an
+		 * adapter. The feature isn't owned by the adjacency model
+		 * @param environment::Feature* Pointer to the body feature
+		 */
+		void addFeature(environment::Feature* feature);
+
+		/**
+		 * @brief Adds a batch body feature. The feature isn't owned by the adjacency model
+		 * @param environment::BatchFeature* Pointer to the batch feature
+		 */
+		void addFeature(environment::BatchFeature* feature);
+
+		/**
+		 * @brief Reads the terrain and obstacle information from the snapshots published by a
+		 * mapping thread, instead of the terrain map, so the map integration doesn't stop while
+		 * planning. The terrain map is still used for its space discretization, which has to stay
+		 * constant
+		 * @param environment::TerrainSnapshotBuffer* Buffer of terrain snapshots, NULL for
+		 * publishing the snapshots from the terrain map
+		 */
+		void setTerrainSnapshots(environment::TerrainSnapshotBuffer* snapshots);
+
+		/**
+		 * @brief Pins the last terrain snapshot, so the next successor queries and obstacle checks
+		 * read the same version of the terrain information until it's released
+		 */
+		void pinTerrainSnapshot();
+
+		/** @brief Releases the pinned terrain snapshot, the next queries read the last version */
+		void releaseTerrainSnapshot();
+
+		/**
+		 * @brief Notifies that the terrain or obstacle information of the terrain map changed, so
+		 * the next query publishes a new snapshot of it. The queries already publish a new snapshot
+		 * if the number of terrain or obstacle cells or the average terrain cost changed, so it's
+		 * only required for the changes that keep all of them. It's ignored if the snapshots are
+		 * published by a mapping thread
+		 */
+		void notifyTerrainChanged();
+
+		/**
+		 * @brief Gets the instrumentation of the adjacency model, i.e. the per-stage counters and
+		 * cycle histograms. It's recorded only if DWL_ADJACENCY_INSTRUMENTATION is defined
+		 * @return The instrumentation
+		 */
+		AdjacencyInstrumentation& getInstrumentation();
+
 
 	private:
+		/**
+		 * @brief Updates the terrain snapshot, i.e. the dense view of the terrain and the obstacle
+		 * grid, and invalidates the cached body costs affected by the terrain changes. The pinned
+		 * snapshot is kept
+		 * @param bool Indicates if the terrain map is published even if its change wasn't detected
+		 * or notified, it's ignored if the snapshots are published by a mapping thread
+		 */
+		void updateTerrainView(bool is_forced);
+
 		/**
 		 * @brief Searches the neighbors of a current vertex
 		 * @param std::vector<Vertex>& The set of neighbors
@@ -56,11 +193,57 @@ class LatticeBasedBodyAdjacency : public AdjacencyModel
 							 Vertex vertex_id);
 
 		/**
-		 * @brief Computes the body cost of a current vertex
-		 * @param Eigen::Vector3d Current robot state (x,y,yaw)
+		 * @brief Gets the start cell and yaw bin of a state vertex
+		 * @param Eigen::Vector3d& State (x,y,yaw) of the vertex
+		 * @param Key& Key of the start cell
+		 * @param unsigned short int& Key of the start yaw
+		 * @param Vertex State vertex
+		 */
+		void getStartCell(Eigen::Vector3d& state,
+						  Key& start_key,
+						  unsigned short int& start_key_yaw,
+						  Vertex state_vertex);
+
+		/**
+		 * @brief Gets the successors of a start cell with a lower bound of their cost, one per
+		 * successor that is reached by the primitives
+		 * @param std::vector<Edge>& Buffer of successors
+		 * @param const std::vector<PrimitiveSuccessor>& Successors of the motor primitives
+		 * @param const Key& Key of the start cell
+		 */
+		void getLazySuccessors(std::vector<Edge>& successors,
+							   const std::vector<PrimitiveSuccessor>& primitives,
+							   const Key& start_key);
+
+		/**
+		 * @brief Gets the successors of the body motor primitives for a certain start yaw bin. The
+		 * successors are computed once from the motor primitives of the robot, which are generated
+		 * from a reference start cell
+		 * @param unsigned short int Key of the start yaw
+		 * @param const Key& Key of the reference start cell
+		 * @return The successors of the motor primitives
 		 */
-		void computeBodyCost(double& cost,
-							 Eigen::Vector3d state);
+		const std::vector<PrimitiveSuccessor>& getPrimitiveSuccessors(unsigned short int key_yaw,
+																	  const Key& start_key);
+
+		/**
+		 * @brief Computes the terrain (stance) cost of a current state, the cost of the body
+		 * features is added later for the whole batch of successors
+		 * @param double& Terrain cost
+		 * @param const Key& Key of the terrain cell of the body
+		 * @param unsigned short int Key of the yaw
+		 */
+		void computeStanceCost(double& cost,
+							   const Key& terrain_key,
+							   unsigned short int key_yaw);
+
+		/**
+		 * @brief Adds the weighted cost of the body features to a batch of body costs
+		 * @param std::vector<double>& Body costs of the batch
+		 * @param const std::vector<environment::FeatureState>& Batch of body states
+		 */
+		void computeFeatureCosts(std::vector<double>& costs,
+								 const std::vector<environment::FeatureState>& states);
 
 		/**
 		 * @brief Indicates if the free of obstacle
@@ -73,6 +256,14 @@ class LatticeBasedBodyAdjacency : public AdjacencyModel
 							  TypeOfState state_representation,
 							  bool body=false);
 
+		/**
+		 * @brief Gets the body footprint mask of a certain yaw bin. The masks are computed once
+		 * from the predefined body workspace of the robot
+		 * @param unsigned short int Key of the yaw
+		 * @return The body footprint mask
+		 */
+		const environment::FootprintMask& getBodyFootprint(unsigned short int key_yaw);
+
 		/**
 		 * @brief Indicates if it is requested a stance adjacency
 		 * @return True it is requested a stance adjacency (body cost), false otherwise
@@ -85,17 +276,61 @@ class LatticeBasedBodyAdjacency : public AdjacencyModel
 		/** @brief Pointer of the TerrainMap object which describes the terrain */
 		environment::TerrainMap* terrain_;
 
-		/** @brief Vector of pointers to the Feature class */
-		std::vector<environment::Feature*> features_;
+		/** @brief Terrain snapshot that is read by the queries */
+		environment::TerrainSnapshotReader snapshot_reader_;
+
+		/** @brief Dense and read-only view of the terrain information of the terrain snapshot */
+		const environment::DenseTerrainView* terrain_view_;
+
+		/** @brief Bit-packed occupancy grid of the obstacle information of the terrain snapshot */
+		const environment::ObstacleGrid* obstacle_grid_;
+
+		/** @brief Body footprint masks per yaw bin */
+		std::vector<environment::FootprintMask> body_footprints_;
+
+		/** @brief Successors of the body motor primitives per start yaw bin */
+		std::vector<std::vector<PrimitiveSuccessor> > primitive_successors_;
+
+		/** @brief Vector of pointers to the body features */
+		std::vector<environment::BatchFeature*> features_;
+
+		/** @brief Adapters of the single-state body features */
+		std::vector<environment::FeatureAdapter*> feature_adapters_;
 
 		/** @brief Current action of the body */
 		Eigen::Vector3d current_action_;
 
+		/** @brief Gait state of the expansions, so the shared robot model isn't modified */
+		robot::GaitState gait_state_;
+
 		/** @brief Indicates it was requested a stance or terrain adjacency */
 		bool is_stance_adjacency_;
 
-		/** @brief Map of search areas */
-		SearchAreaMap stance_areas_;
+		/** @brief Indicates if the successors are evaluated lazily */
+		bool is_lazy_evaluation_;
+
+		/** @brief Stance-sampling stencils per yaw bin and stance pattern */
+		StanceStencils stance_stencils_;
+
+		/** @brief Kernel for computing the stance cost */
+		StanceCostKernel stance_cost_kernel_;
+
+		/** @brief Cache of the terrain cost of the body states */
+		BodyCostCache body_cost_cache_;
+
+		/** @brief Per-stage counters and cycle histograms */
+		AdjacencyInstrumentation instrumentation_;
+
+		/** @brief Reusable buffer of successors for the list interface */
+		std::vector<Edge> successor_buffer_;
+
+		/** @brief Reusable buffers of the body feature batch of the successors */
+		std::vector<environment::FeatureState> feature_state_buffer_;
+		std::vector<double> body_cost_buffer_;
+		std::vector<double> feature_cost_buffer_;
+
+		/** @brief Reusable buffer of the primitives of the successors */
+		std::vector<unsigned int> successor_action_buffer_;
 
 		/** @brief Number of top cost for computing the stance cost */
 		int number_top_cost_;
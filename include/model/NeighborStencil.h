@@ -0,0 +1,109 @@
+#ifndef DWL__MODEL__NEIGHBOR_STENCIL__H
+#define DWL__MODEL__NEIGHBOR_STENCIL__H
+
+#include <dwl/utils/utils.h>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/** @brief Integer offset of a neighbor cell along a search direction */
+struct NeighborOffset
+{
+	NeighborOffset() : dx(0), dy(0), direction(0) {}
+	NeighborOffset(int _dx, int _dy, unsigned int _direction) :
+		dx(_dx), dy(_dy), direction(_direction) {}
+
+	/** @brief Offset of the cell w.r.t. the cell of the state */
+	int dx, dy;
+
+	/** @brief Index of the search direction */
+	unsigned int direction;
+};
+
+
+/**
+ * @class NeighborStencil
+ * @brief Table of the neighbor offsets of a grid, for a certain connectivity (8, 16 or 32
+ * directions) and neighboring definition (number of cells per direction). The offsets are sorted
+ * by radius first and by direction second, so the closest valid cell of every direction is found
+ * in the same order than searching radius by radius, and the search stops when every direction
+ * found its neighbor
+ */
+class NeighborStencil
+{
+	public:
+		/** @brief Constructor function */
+		NeighborStencil();
+
+		/** @brief Destructor function */
+		~NeighborStencil();
+
+		/**
+		 * @brief Computes the table of offsets
+		 * @param unsigned int Number of directions, i.e. 8, 16 or 32
+		 * @param int Neighboring definition (number of cells per direction)
+		 * @return False if the connectivity is not supported
+		 */
+		bool reset(unsigned int connectivity,
+				   int neighboring_definition);
+
+		/** @brief Gets the offsets sorted by radius and direction */
+		const std::vector<NeighborOffset>& getOffsets() const;
+
+		/** @brief Gets the number of directions */
+		unsigned int getConnectivity() const;
+
+		/** @brief Gets the bitmask of all the directions */
+		uint32_t getDirectionMask() const;
+
+		/**
+		 * @brief Gets the reach of the stencil, i.e. the maximum absolute offset (in cells) w.r.t.
+		 * the cell of the state
+		 * @return The reach of the stencil
+		 */
+		int getReach() const;
+
+
+	private:
+		/** @brief Offsets sorted by radius and direction */
+		std::vector<NeighborOffset> offsets_;
+
+		/** @brief Number of directions */
+		unsigned int connectivity_;
+
+		/** @brief Maximum absolute offset */
+		int reach_;
+};
+
+
+inline const std::vector<NeighborOffset>& NeighborStencil::getOffsets() const
+{
+	return offsets_;
+}
+
+
+inline unsigned int NeighborStencil::getConnectivity() const
+{
+	return connectivity_;
+}
+
+
+inline uint32_t NeighborStencil::getDirectionMask() const
+{
+	return (connectivity_ >= 32) ? 0xffffffff : ((uint32_t) 1 << connectivity_) - 1;
+}
+
+
+inline int NeighborStencil::getReach() const
+{
+	return reach_;
+}
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
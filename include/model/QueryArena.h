@@ -0,0 +1,174 @@
+#ifndef DWL__MODEL__QUERY_ARENA__H
+#define DWL__MODEL__QUERY_ARENA__H
+
+#include <dwl/utils/utils.h>
+#include <stdint.h>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/**
+ * @class QueryArena
+ * @brief Monotonic arena of the temporaries of a planning query. The memory is carved from large
+ * blocks, and the released chunks are kept in free lists of power-of-two size classes, so a
+ * temporary that grows or is created again in the same query reuses the memory of the previous
+ * one. Everything is released at once with a reset at the end of the query, and the blocks are
+ * kept for the next query, so a warm arena doesn't call the global allocator. It isn't thread-safe,
+ * every thread has to use its own arena
+ */
+class QueryArena
+{
+	public:
+		/** @brief Default size of the blocks (bytes) */
+		static const std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+		/**
+		 * @brief Constructor function
+		 * @param std::size_t Size of the blocks (bytes), bigger chunks get their own block
+		 */
+		QueryArena(std::size_t block_size = DEFAULT_BLOCK_SIZE);
+
+		/** @brief Destructor function */
+		~QueryArena();
+
+		/**
+		 * @brief Allocates a chunk of memory, it's aligned for any fundamental or fixed-size Eigen
+		 * type
+		 * @param std::size_t Size of the chunk (bytes)
+		 * @return The chunk of memory
+		 */
+		void* allocate(std::size_t size);
+
+		/**
+		 * @brief Returns a chunk of memory to the free list of its size class
+		 * @param void* Chunk of memory
+		 * @param std::size_t Size of the chunk (bytes), the same than the one of the allocation
+		 */
+		void deallocate(void* chunk,
+						std::size_t size);
+
+		/**
+		 * @brief Releases all the chunks of memory, the blocks are kept for the next query. The
+		 * temporaries that use the arena must be destroyed before
+		 */
+		void reset();
+
+		/** @brief Gets the number of bytes that were carved from the blocks since the last reset */
+		std::size_t getUsedSize() const;
+
+		/** @brief Gets the number of bytes of the blocks */
+		std::size_t getCapacity() const;
+
+
+	private:
+		/** @brief Size of the smallest size class (bytes), it's also the alignment of the chunks */
+		static const std::size_t MIN_CHUNK_SIZE = 16;
+
+		/** @brief Number of size classes */
+		static const unsigned int NUM_SIZE_CLASSES = 48;
+
+		/**
+		 * @brief Gets the size class of a chunk, i.e. the chunk size is MIN_CHUNK_SIZE << class
+		 * @param std::size_t Size of the chunk (bytes)
+		 * @return The size class
+		 */
+		static unsigned int getSizeClass(std::size_t size);
+
+		/** @brief Free chunk of a size class, the link is stored in the chunk itself */
+		struct FreeChunk
+		{
+			FreeChunk* next;
+		};
+
+		/** @brief Blocks of memory and their sizes */
+		std::vector<char*> blocks_;
+		std::vector<std::size_t> block_sizes_;
+
+		/** @brief Current block and offset of its free space */
+		std::size_t current_block_;
+		std::size_t offset_;
+
+		/** @brief Size of the blocks */
+		std::size_t block_size_;
+
+		/** @brief Number of bytes that were carved from the blocks since the last reset */
+		std::size_t used_size_;
+
+		/** @brief Free lists of every size class */
+		FreeChunk* free_lists_[NUM_SIZE_CLASSES];
+};
+
+
+/**
+ * @class ArenaAllocator
+ * @brief Standard allocator that takes the memory from a query arena, so the standard containers
+ * of the temporaries of a query are released with the reset of the arena
+ */
+template <typename T>
+class ArenaAllocator
+{
+	public:
+		typedef T value_type;
+
+		/**
+		 * @brief Constructor function
+		 * @param QueryArena& Arena of the query
+		 */
+		ArenaAllocator(QueryArena& arena) : arena_(&arena) {}
+
+		/** @brief Copy constructor function of another value type, i.e. the rebound allocator */
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.getArena()) {}
+
+		/** @brief Allocates the memory of a number of values */
+		T* allocate(std::size_t n)
+		{
+			return static_cast<T*>(arena_->allocate(n * sizeof(T)));
+		}
+
+		/** @brief Returns the memory of a number of values to the arena */
+		void deallocate(T* pointer,
+						std::size_t n)
+		{
+			arena_->deallocate(pointer, n * sizeof(T));
+		}
+
+		/** @brief Gets the arena of the allocator */
+		QueryArena* getArena() const
+		{
+			return arena_;
+		}
+
+
+	private:
+		/** @brief Arena of the query */
+		QueryArena* arena_;
+};
+
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.getArena() == b.getArena();
+}
+
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.getArena() != b.getArena();
+}
+
+
+/** @brief Vector whose memory is taken from a query arena */
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
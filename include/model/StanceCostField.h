@@ -0,0 +1,140 @@
+#ifndef DWL__MODEL__STANCE_COST_FIELD__H
+#define DWL__MODEL__STANCE_COST_FIELD__H
+
+#include <dwl/environment/DenseTerrainView.h>
+#include <dwl/model/StanceStencils.h>
+#include <dwl/utils/utils.h>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/**
+ * @class StanceCostField
+ * @brief Dense field of the terrain (stance) cost of every body cell of the terrain view, for a
+ * certain stance stencil (i.e. yaw bin and stance pattern). The field is computed row by row with
+ * a sliding window per foot: moving the body one cell only removes and inserts the cells of the
+ * window boundaries, which are kept in a sorted buffer. The best distinct costs are added in
+ * ascending order, so the field is the same than evaluating the StanceCostKernel in every cell
+ */
+class StanceCostField
+{
+	public:
+		/** @brief Constructor function */
+		StanceCostField();
+
+		/** @brief Destructor function */
+		~StanceCostField();
+
+		/**
+		 * @brief Computes the field over the bounding box of the terrain view
+		 * @param const environment::DenseTerrainView& Dense view of the terrain
+		 * @param const StanceStencil& Stance stencil
+		 * @param unsigned int Number of top (lowest) cost for computing the stance cost
+		 * @param double Stance cost of a foot without terrain information
+		 * @param unsigned int Number of threads
+		 */
+		void compute(const environment::DenseTerrainView& terrain_view,
+					 const StanceStencil& stencil,
+					 unsigned int number_top_cost,
+					 double unknown_cost,
+					 unsigned int num_threads = 1);
+
+		/**
+		 * @brief Indicates if the field describes a certain version of the terrain view
+		 * @param unsigned int Version of the terrain view
+		 * @param unsigned int Number of top (lowest) cost for computing the stance cost
+		 * @return True if the field is up to date
+		 */
+		bool isUpdated(unsigned int view_version,
+					   unsigned int number_top_cost) const;
+
+		/**
+		 * @brief Gets the terrain cost of a body cell
+		 * @param double& Terrain cost
+		 * @param bool& Indicates if the cost depends on the stance cost of the unknown feet
+		 * @param int Key of the x-axis of the body cell
+		 * @param int Key of the y-axis of the body cell
+		 * @return False if the cell is outside of the field
+		 */
+		bool getCost(double& cost,
+					 bool& is_unknown_cost,
+					 int key_x,
+					 int key_y) const;
+
+
+	private:
+		/** @brief Sliding window of a foot */
+		struct FootWindow
+		{
+			/** @brief Cell offsets of the foot */
+			std::vector<environment::CellOffset> offsets;
+
+			/** @brief Offsets that leave the window when the body moves one cell in x */
+			std::vector<environment::CellOffset> leaving;
+
+			/** @brief Offsets that enter the window when the body moves one cell in x */
+			std::vector<environment::CellOffset> entering;
+		};
+
+		/**
+		 * @brief Computes a range of rows of the field
+		 * @param const environment::DenseTerrainView& Dense view of the terrain
+		 * @param int First row
+		 * @param int Last row (not included)
+		 * @param unsigned int Number of top (lowest) cost for computing the stance cost
+		 * @param double Stance cost of a foot without terrain information
+		 */
+		void computeRows(const environment::DenseTerrainView& terrain_view,
+						 int first_row,
+						 int end_row,
+						 unsigned int number_top_cost,
+						 double unknown_cost);
+
+		/** @brief Sliding windows of every foot */
+		std::vector<FootWindow> windows_;
+
+		/** @brief Terrain cost of every cell of the field */
+		std::vector<double> cost_;
+
+		/** @brief Indicates if the cost of a cell depends on the stance cost of the unknown feet */
+		std::vector<char> is_unknown_cost_;
+
+		/** @brief Bounding box of the field */
+		int min_key_x_, min_key_y_, size_x_, size_y_;
+
+		/** @brief Version of the terrain view of the field */
+		unsigned int view_version_;
+
+		/** @brief Number of top cost of the field */
+		unsigned int number_top_cost_;
+
+		/** @brief Indicates if the field was computed */
+		bool is_computed_;
+};
+
+
+inline bool StanceCostField::getCost(double& cost,
+									 bool& is_unknown_cost,
+									 int key_x,
+									 int key_y) const
+{
+	int x = key_x - min_key_x_;
+	int y = key_y - min_key_y_;
+	if (((unsigned int) x >= (unsigned int) size_x_) ||
+			((unsigned int) y >= (unsigned int) size_y_))
+		return false;
+
+	int index = y * size_x_ + x;
+	cost = cost_[index];
+	is_unknown_cost = is_unknown_cost_[index];
+	return true;
+}
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef DWL__MODEL__STANCE_COST_KERNEL__H
+#define DWL__MODEL__STANCE_COST_KERNEL__H
+
+#include <dwl/environment/DenseTerrainView.h>
+#include <dwl/model/StanceStencils.h>
+#include <dwl/utils/utils.h>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/**
+ * @class StanceCostKernel
+ * @brief Computes the stance cost of the body adjacency models, i.e. the average of the k best
+ * (lowest) distinct terrain costs inside the stance area of every foot. The costs are gathered
+ * into a reusable buffer and the k best are selected with a bounded partial selection, which uses
+ * AVX2 (if it's available) for discarding the costs that are above the current k-th best.
+ * Therefore the kernel doesn't allocate memory once its buffers reached their size
+ */
+class StanceCostKernel
+{
+	public:
+		/** @brief Constructor function */
+		StanceCostKernel();
+
+		/** @brief Destructor function */
+		~StanceCostKernel();
+
+		/**
+		 * @brief Computes the terrain cost of a stance as the average of the stance costs of
+		 * every foot
+		 * @param const environment::DenseTerrainView& Dense view of the terrain
+		 * @param const StanceStencil& Stance stencil of the state
+		 * @param int Key of the x-axis of the body cell
+		 * @param int Key of the y-axis of the body cell
+		 * @param unsigned int Number of top (lowest) cost for computing the stance cost
+		 * @param double Stance cost of a foot without terrain information
+		 * @return The terrain cost of the stance
+		 */
+		double computeTerrainCost(const environment::DenseTerrainView& terrain_view,
+								  const StanceStencil& stencil,
+								  int key_x,
+								  int key_y,
+								  unsigned int number_top_cost,
+								  double unknown_cost);
+
+		/** @brief Gets the number of feet without terrain information in the last stance */
+		unsigned int getNumberOfUnknownFeet() const;
+
+		/**
+		 * @brief Computes the average of the k best (lowest) distinct costs. The equal costs are
+		 * merged and the best costs are added in ascending order, so the result is the same than
+		 * adding them from the cost-ordered queue of the stance cost
+		 * @param const double* Costs
+		 * @param unsigned int Number of costs
+		 * @param unsigned int Number of top (lowest) cost
+		 * @param double Cost if there isn't any cost
+		 * @return The average of the best costs
+		 */
+		double computeTopCostAverage(const double* costs,
+									 unsigned int size,
+									 unsigned int number_top_cost,
+									 double unknown_cost);
+
+
+	private:
+		/**
+		 * @brief Inserts a cost into the sorted set of best costs, it's discarded if the set already
+		 * has the same cost
+		 * @param double Cost
+		 * @param unsigned int& Number of best costs
+		 * @param unsigned int Number of top (lowest) cost
+		 */
+		void insertBestCost(double cost,
+							unsigned int& num_best,
+							unsigned int number_top_cost);
+
+		/** @brief Buffer of the gathered costs */
+		std::vector<double> costs_;
+
+		/** @brief Sorted buffer of the best costs */
+		std::vector<double> best_costs_;
+
+		/** @brief Number of feet without terrain information in the last stance */
+		unsigned int num_unknown_feet_;
+};
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef DWL__MODEL__STANCE_STENCILS__H
+#define DWL__MODEL__STANCE_STENCILS__H
+
+#include <dwl/environment/FootprintMask.h>
+#include <dwl/robot/Robot.h>
+#include <dwl/utils/utils.h>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/** @brief Integer cell offsets of the stance areas of every foot */
+struct StanceStencil
+{
+	StanceStencil() : is_defined(false) {}
+
+	/** @brief Cell offsets of all the feet w.r.t. the cell of the body */
+	std::vector<environment::CellOffset> offsets;
+
+	/** @brief Index of the first offset of each foot, plus the end of the last foot */
+	std::vector<unsigned int> foot_begin;
+
+	/** @brief Indicates if the stencil was computed */
+	bool is_defined;
+};
+
+
+/**
+ * @class StanceStencils
+ * @brief Table of the stance-sampling stencils per yaw bin and stance pattern. The stencils are
+ * computed once from the footstep search areas, so evaluating the stance cost of a state is a pure
+ * gather over the terrain cells, which doesn't depend on floating-point drift
+ */
+class StanceStencils
+{
+	public:
+		/** @brief Constructor function */
+		StanceStencils();
+
+		/** @brief Destructor function */
+		~StanceStencils();
+
+		/**
+		 * @brief Removes all the stencils and sets the resolution of the terrain cells
+		 * @param double Resolution of the terrain cells
+		 */
+		void reset(double resolution);
+
+		/**
+		 * @brief Indicates if the stencil of a certain yaw bin and stance pattern was computed
+		 * @param unsigned short int Key of the yaw
+		 * @param int Stance pattern
+		 * @return True if the stencil is defined
+		 */
+		bool isDefined(unsigned short int key_yaw,
+					   int pattern) const;
+
+		/**
+		 * @brief Computes the stencil of a certain yaw bin and stance pattern
+		 * @param unsigned short int Key of the yaw
+		 * @param int Stance pattern
+		 * @param double Orientation of the yaw bin
+		 * @param const SearchAreaMap& Footstep search areas of the stance pattern
+		 */
+		void compute(unsigned short int key_yaw,
+					 int pattern,
+					 double yaw,
+					 const SearchAreaMap& stance_areas);
+
+		/**
+		 * @brief Gets the stencil of a certain yaw bin and stance pattern
+		 * @param unsigned short int Key of the yaw
+		 * @param int Stance pattern
+		 * @return The stance stencil
+		 */
+		const StanceStencil& getStencil(unsigned short int key_yaw,
+										int pattern) const;
+
+		/**
+		 * @brief Gets the reach of the computed stencils, i.e. the maximum absolute offset (in
+		 * cells) w.r.t. the body cell
+		 * @return The reach of the stencils
+		 */
+		int getReach() const;
+
+
+	private:
+		/** @brief Stencils indexed by yaw bin and stance pattern */
+		std::vector<StanceStencil> stencils_;
+
+		/** @brief Resolution of the terrain cells */
+		double resolution_;
+
+		/** @brief Reach of the computed stencils */
+		int reach_;
+};
+
+
+inline bool StanceStencils::isDefined(unsigned short int key_yaw,
+									  int pattern) const
+{
+	std::size_t index = (std::size_t) key_yaw * robot::Robot::NUM_STANCE_PATTERNS + pattern;
+	return (index < stencils_.size()) && stencils_[index].is_defined;
+}
+
+
+inline const StanceStencil& StanceStencils::getStencil(unsigned short int key_yaw,
+													   int pattern) const
+{
+	return stencils_[(std::size_t) key_yaw * robot::Robot::NUM_STANCE_PATTERNS + pattern];
+}
+
+} //@namespace model
+} //@namespace dwl
+
+#endif
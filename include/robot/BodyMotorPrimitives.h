@@ -45,6 +45,18 @@ class BodyMotorPrimitives : public MotorPrimitives
 		void generateActions(std::vector<Action3d>& actions,
 							 Pose3d state);
 
+		/**
+		 * @brief Gets the body motor primitives
+		 * @return The body motor primitives
+		 */
+		const std::vector<BodyMotorPrimitive>& getPrimitives() const;
+
+		/**
+		 * @brief Sets the body motor primitives, e.g. from a precompiled robot bundle
+		 * @param const std::vector<BodyMotorPrimitive>& Body motor primitives
+		 */
+		void setPrimitives(const std::vector<BodyMotorPrimitive>& primitives);
+
 	private:
 		/** @brief Vector of body actions */
 		std::vector<BodyMotorPrimitive> actions_;
@@ -0,0 +1,93 @@
+#ifndef DWL__ROBOT__CONTACT_FEED__H
+#define DWL__ROBOT__CONTACT_FEED__H
+
+#include <dwl/robot/GaitState.h>
+#include <dwl/utils/utils.h>
+#include <atomic>
+
+
+namespace dwl
+{
+
+namespace robot
+{
+
+/**
+ * @class ContactFeed
+ * @brief Single-producer and multi-reader channel of the pose and contacts of the robot, e.g. from
+ * a state estimator at a high rate to the planners. It's a seqlock: the producer never waits for
+ * the readers, and a reader retries its copy if the producer published while it was reading. The
+ * sample is stored in a fixed number of atomic words, so publishing doesn't allocate memory. The
+ * producer also keeps the estimated ground from the body, i.e. the average height of the contacts
+ */
+class ContactFeed
+{
+	public:
+		/** @brief Maximum number of contacts of a sample */
+		static const unsigned int MAX_CONTACTS = 8;
+
+		/** @brief Constructor function */
+		ContactFeed();
+
+		/** @brief Destructor function */
+		~ContactFeed();
+
+		/**
+		 * @brief Publishes a new sample, it has to be called always from the same thread
+		 * @param const Pose& Pose of the robot
+		 * @param const Contact* Contacts of the robot
+		 * @param unsigned int Number of contacts, the contacts after MAX_CONTACTS are ignored
+		 */
+		void publish(const Pose& pose,
+					 const Contact* contacts,
+					 unsigned int num_contacts);
+
+		/**
+		 * @brief Publishes a new sample, it has to be called always from the same thread
+		 * @param const Pose& Pose of the robot
+		 * @param const std::vector<Contact>& Contacts of the robot
+		 */
+		void publish(const Pose& pose,
+					 const std::vector<Contact>& contacts);
+
+		/**
+		 * @brief Reads the last sample, it can be called from any thread. The contacts of the gait
+		 * state are reused, so it doesn't allocate memory once they reached their capacity
+		 * @param GaitState& Gait state, its pose and contacts are set
+		 * @param double& Estimated ground from the body
+		 * @return The version of the sample, zero if nothing was published
+		 */
+		uint64_t read(GaitState& state,
+					  double& estimated_ground) const;
+
+		/**
+		 * @brief Gets the version of the last sample, i.e. the number of published samples
+		 * @return The version of the last sample
+		 */
+		uint64_t getVersion() const;
+
+
+	private:
+		/** @brief Number of words of the pose (position and orientation) */
+		static const unsigned int POSE_SIZE = 7;
+
+		/** @brief Number of words of a contact (end-effector and position) */
+		static const unsigned int CONTACT_SIZE = 4;
+
+		/** @brief Number of words of a sample (pose, estimated ground, number of contacts and contacts) */
+		static const unsigned int SAMPLE_SIZE = POSE_SIZE + 2 + CONTACT_SIZE * MAX_CONTACTS;
+
+		/** @brief Sequence counter, it's odd while the producer is writing a sample */
+		std::atomic<uint64_t> sequence_;
+
+		/** @brief Words of the last sample */
+		std::atomic<double> sample_[SAMPLE_SIZE];
+
+		/** @brief Estimated ground of the producer, it's kept if a sample doesn't have contacts */
+		double estimated_ground_;
+};
+
+} //@namespace robot
+} //@namespace dwl
+
+#endif
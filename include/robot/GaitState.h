@@ -0,0 +1,59 @@
+#ifndef DWL__ROBOT__GAIT_STATE__H
+#define DWL__ROBOT__GAIT_STATE__H
+
+#include <dwl/utils/utils.h>
+#include <memory>
+
+
+namespace dwl
+{
+
+namespace robot
+{
+
+/**
+ * @brief Stances of every stance pattern for a certain estimated ground. The robot publishes a new
+ * table when the estimated ground changes instead of modifying the current one, so the stances
+ * that were returned to a query stay valid while its gait state keeps the table
+ */
+struct StanceTable
+{
+	StanceTable() : estimated_ground_from_body(0) {}
+
+	/** @brief Estimated ground from the body frame */
+	double estimated_ground_from_body;
+
+	/** @brief Stance of every stance pattern */
+	std::vector<Vector3dMap> stances;
+};
+
+
+/**
+ * @brief Per-query gait state of the robot, i.e. the state that changes while a plan is expanded.
+ * It's a small value type that is passed along with the queries of the robot model, so the robot
+ * model itself isn't modified by the queries and it can be shared by several threads or planners
+ */
+struct GaitState
+{
+	GaitState() : last_past_foot(1) {}
+
+	/** @brief Last past (swing) foot, it defines the lateral pattern of straight actions */
+	int last_past_foot;
+
+	/** @brief Pose of the robot */
+	Pose pose;
+
+	/** @brief Contacts of the robot */
+	std::vector<Contact> contacts;
+
+	/**
+	 * @brief Stance table of the estimated ground of the contacts. A null table is set to the
+	 * current table of the robot by the first query that needs it
+	 */
+	std::shared_ptr<const StanceTable> stance_table;
+};
+
+} //@namespace robot
+} //@namespace dwl
+
+#endif
@@ -2,8 +2,12 @@
 #define DWL__ROBOT__ROBOT__H
 
 #include <dwl/behavior/MotorPrimitives.h>
+#include <dwl/robot/GaitState.h>
+#include <dwl/robot/ContactFeed.h>
 #include <dwl/utils/utils.h>
 #include <dwl/utils/YamlWrapper.h>
+#include <memory>
+#include <mutex>
 
 
 namespace dwl
@@ -19,11 +23,23 @@ namespace robot
 
 /**
  * @class Robot
- * @brief Class for defining the properties of the robot
+ * @brief Class for defining the properties of the robot. The const queries don't modify the
+ * robot, the per-query gait state (last swing foot, pose, contacts and stance table) is passed
+ * along with them in a GaitState. The properties aren't modified once they were read, and the
+ * current gait state is published as an immutable value that is swapped atomically, like the
+ * terrain snapshots. So a robot can be shared by several threads or planners without locks or
+ * copies, even while its pose and contacts are updated. The queries without a gait state use the
+ * current gait state of the robot and return copies of it, since it can be replaced concurrently
  */
 class Robot
 {
+	/** @brief The robot bundle writes and reads the robot properties */
+	friend class RobotBundle;
+
 	public:
+		/** @brief Number of stance patterns (displacement pattern x lateral pattern) */
+		static const int NUM_STANCE_PATTERNS = 9;
+
 		/** @brief Constructor function */
 		Robot();
 
@@ -37,13 +53,15 @@ class Robot
 		void read(std::string filename);
 
 		/**
-		 * @brief Sets the current pose of the robot
+		 * @brief Sets the current pose of the robot, it publishes a new current gait state
 		 * @param const Pose& Current pose
 		 */
 		void setCurrentPose(const Pose& pose);
 
 		/**
-		 * @brief Sets the current contacts of the robot
+		 * @brief Sets the current contacts of the robot, which also update the estimated ground of
+		 * the stances. It publishes a new current gait state and stance table, the gait states
+		 * that were taken before keep the previous ones
 		 * @param const std::vector<Contact>& Contact positions
 		 */
 		void setCurrentContacts(const std::vector<Contact>& contacts);
@@ -52,13 +70,35 @@ class Robot
 		 * @brief Gets current pose of the robot
 		 * @return The current pose of the robot
 		 */
-		Pose getCurrentPose();
+		Pose getCurrentPose() const;
 
 		/**
 		 * @brief Gets the current contact positions
 		 * @return The set of current contacts
 		 */
-		std::vector<Contact> getCurrentContacts();
+		std::vector<Contact> getCurrentContacts() const;
+
+		/**
+		 * @brief Gets a copy of the current gait state of the robot, e.g. for initializing the gait
+		 * state of a query. The copy keeps the current stance table
+		 * @return The current gait state
+		 */
+		GaitState getGaitState() const;
+
+		/**
+		 * @brief Gets the feed of the pose and contacts of the robot. A state estimator publishes
+		 * in it from its own thread, without waiting for the planners
+		 * @return The contact feed
+		 */
+		ContactFeed& getContactFeed();
+
+		/**
+		 * @brief Updates the current gait state and the estimated ground from the last sample of
+		 * the contact feed. Like setCurrentContacts, it publishes a new current gait state, but it
+		 * only builds a new stance table if the estimated ground changed
+		 * @return True if there was a new sample
+		 */
+		bool updateFromContactFeed();
 
 		/**
 		 * @brief Gets the body motor primitives
@@ -71,47 +111,113 @@ class Robot
 		 * potential collisions
 		 * @return The predefined body workspace
 		 */
-		SearchArea getPredefinedBodyWorkspace();
+		const SearchArea& getPredefinedBodyWorkspace() const;
 
 		/**
 		 * @brief Gets the predefined leg workspace for evaluation of
 		 * potential collisions
 		 * @return The predefined leg workspaces
 		 */
-		SearchAreaMap getPredefinedLegWorkspaces();
+		const SearchAreaMap& getPredefinedLegWorkspaces() const;
 
 		/**
-		 * @brief Gets the current stance of the robot
+		 * @brief Gets a copy of the current stance of the robot. The current stance table can be
+		 * replaced by a concurrent update, so the stance is returned by value; the gait state
+		 * overload returns a reference without copying
 		 * @param const Eigen::Vector3d& action Action to execute
 		 * @return The current stance of the robot
 		 */
 		Vector3dMap getStance(const Eigen::Vector3d& action = Eigen::Vector3d::Zero());
 
+		/**
+		 * @brief Gets the stance of the robot for a certain gait state. The stance is valid while
+		 * the gait state keeps its stance table
+		 * @param GaitState& Gait state of the query, its last swing foot is updated, and its
+		 * stance table is set if it's null
+		 * @param const Eigen::Vector3d& action Action to execute
+		 * @return The stance of the robot
+		 */
+		const Vector3dMap& getStance(GaitState& state,
+									 const Eigen::Vector3d& action = Eigen::Vector3d::Zero()) const;
+
+		/**
+		 * @brief Gets the stance pattern of an action, i.e. the combination of displacement and
+		 * lateral patterns which defines the stance and the footstep search areas
+		 * @param const Eigen::Vector3d& action Action to execute
+		 * @return The stance pattern, a value between 0 and NUM_STANCE_PATTERNS - 1
+		 */
+		int getStancePattern(const Eigen::Vector3d& action = Eigen::Vector3d::Zero());
+
+		/**
+		 * @brief Gets the stance pattern of an action for a certain gait state
+		 * @param GaitState& Gait state of the query, its last swing foot is updated
+		 * @param const Eigen::Vector3d& action Action to execute
+		 * @return The stance pattern, a value between 0 and NUM_STANCE_PATTERNS - 1
+		 */
+		int getStancePattern(GaitState& state,
+							 const Eigen::Vector3d& action = Eigen::Vector3d::Zero()) const;
+
 		/**
 		 * @brief Gets the nominal stance of the robot
 		 * @return The nominal stance of the robot
 		 */
-		Vector3dMap getNominalStance();
+		const Vector3dMap& getNominalStance() const;
 
 		/**
 		 * @brief Gets the pattern of locomotion of the robot
 		 * @return The pattern of locomotion
 		 */
-		PatternOfLocomotionMap getPatternOfLocomotion();
+		const PatternOfLocomotionMap& getPatternOfLocomotion() const;
 
 		/**
-		 * @brief Gets the stance areas
+		 * @brief Gets the stance areas. The stance areas of every stance pattern are precomputed,
+		 * so it doesn't allocate memory
 		 * @param const Eigen::Vector3d& action Action to execute
 		 * @return The stance areas
 		 */
-		SearchAreaMap getFootstepSearchAreas(const Eigen::Vector3d& action = Eigen::Vector3d::Zero());
+		const SearchAreaMap& getFootstepSearchAreas(const Eigen::Vector3d& action = Eigen::Vector3d::Zero());
+
+		/**
+		 * @brief Gets the stance areas for a certain gait state
+		 * @param GaitState& Gait state of the query, its last swing foot is updated
+		 * @param const Eigen::Vector3d& action Action to execute
+		 * @return The stance areas
+		 */
+		const SearchAreaMap& getFootstepSearchAreas(GaitState& state,
+													const Eigen::Vector3d& action = Eigen::Vector3d::Zero()) const;
+
+		/**
+		 * @brief Gets a copy of the precomputed stance of a stance pattern in the current stance
+		 * table, which can be replaced by a concurrent update
+		 * @param int Stance pattern, a value between 0 and NUM_STANCE_PATTERNS - 1
+		 * @return The stance of the stance pattern
+		 */
+		Vector3dMap getPatternStance(int pattern) const;
+
+		/**
+		 * @brief Gets the precomputed stance of a stance pattern for a certain gait state. The
+		 * stance is valid while the gait state keeps its stance table
+		 * @param GaitState& Gait state of the query, its stance table is set if it's null
+		 * @param int Stance pattern, a value between 0 and NUM_STANCE_PATTERNS - 1
+		 * @return The stance of the stance pattern
+		 */
+		const Vector3dMap& getPatternStance(GaitState& state,
+											int pattern) const;
+
+		/**
+		 * @brief Gets the precomputed stance areas of a stance pattern. They don't depend on the
+		 * estimated ground, so they don't change once the properties were read
+		 * @param int Stance pattern, a value between 0 and NUM_STANCE_PATTERNS - 1
+		 * @return The stance areas of the stance pattern
+		 */
+		const SearchAreaMap& getPatternFootstepSearchAreas(int pattern) const;
 
 		/**
 		 * @brief Gets the footstep search region given an action
 		 * @param const Eigen::Vector3d& action Action to execute
 		 * @return The footstep search regions
 		 */
-		SearchAreaMap getFootstepSearchSize(const Eigen::Vector3d& action = Eigen::Vector3d::Zero());
+		const SearchAreaMap& getFootstepSearchSize(const Eigen::Vector3d& action = Eigen::Vector3d::Zero()) const;
 
 		/**
 		 * @brief Gets the expected ground according to the nominal stance
@@ -120,22 +226,62 @@ class Robot
 		 */
 		double getExpectedGround(int foot_id);
 
+		/**
+		 * @brief Gets the expected ground according to the nominal stance for a certain gait state
+		 * @param const GaitState& Gait state of the query, the current stance table is used if it
+		 * doesn't have one
+		 * @param int Foot id
+		 * @return The expected ground according to the nominal stance of the leg
+		 */
+		double getExpectedGround(const GaitState& state,
+								 int foot_id) const;
+
 		/** @brief Gets the number of legs of the robot */
-		double getNumberOfLegs();
+		double getNumberOfLegs() const;
 
 		/** @brief Gets the end-effector map */
-		EndEffectorMap getEndEffectorMap();
+		const EndEffectorMap& getEndEffectorMap() const;
 
 		/** @brief Gets the leg map */
-		EndEffectorMap getLegMap();
+		const EndEffectorMap& getLegMap() const;
 
 
 	protected:
-		/** @brief Current pose of the robot */
-		Pose current_pose_;
+		/**
+		 * @brief Precomputes the stance areas of every stance pattern and the footstep search
+		 * regions of the forward and backward actions, and publishes a gait state with the stance
+		 * table of the estimated ground. It's called every time that the properties are read
+		 */
+		void updateStanceTables();
+
+		/**
+		 * @brief Computes the stance of every stance pattern for a certain estimated ground
+		 * @param double Estimated ground from the body frame
+		 * @return The stance table
+		 */
+		std::shared_ptr<const StanceTable> computeStanceTable(double estimated_ground) const;
+
+		/**
+		 * @brief Gets the current gait state, it can be called from any thread
+		 * @return The current gait state
+		 */
+		std::shared_ptr<const GaitState> loadGaitState() const;
+
+		/**
+		 * @brief Current gait state of the robot, i.e. its pose, contacts and stance table. It's only
+		 * accessed with the atomic operations
+		 */
+		std::shared_ptr<const GaitState> gait_state_;
 
-		/** @brief Current contacts of the robot */
-		std::vector<Contact> current_contacts_;
+		/** @brief Serializes the updates of the current gait state, the queries don't lock it */
+		std::mutex update_mutex_;
+
+		/** @brief Last swing foot of the queries without a gait state */
+		int last_past_foot_;
+
+		/** @brief Feed of the pose and contacts, and version of its last applied sample */
+		ContactFeed contact_feed_;
+		uint64_t contact_feed_version_;
 
 		/** @brief Pointer to the body motor primitives */
 		behavior::MotorPrimitives* body_behavior_;
@@ -167,6 +313,12 @@ class Robot
 		/** @brief Vector of footstep search areas */
 		std::vector<SearchArea> footstep_search_areas_;
 
+		/** @brief Stance areas of every stance pattern */
+		std::vector<SearchAreaMap> footstep_area_table_;
+
+		/** @brief Footstep search regions of the forward and backward actions */
+		std::vector<SearchAreaMap> footstep_size_table_;
+
 		/** @brief Pattern of locomotion */
 		PatternOfLocomotionMap pattern_locomotion_;
 
@@ -176,12 +328,9 @@ class Robot
 		/** @brief Number of end-effectors */
 		double num_end_effectors_;
 
-		/** @brief Estimated ground from the body frame */
+		/** @brief Estimated ground from the body frame of the robot properties */
 		double estimated_ground_from_body_;
 
-		/** @brief The last past foot */
-		int last_past_foot_;
-
 		/** @brief Lateral offset between the feet */
 		double feet_lateral_offset_;
 
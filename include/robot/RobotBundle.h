@@ -0,0 +1,93 @@
+#ifndef DWL__ROBOT__ROBOT_BUNDLE__H
+#define DWL__ROBOT__ROBOT_BUNDLE__H
+
+#include <dwl/robot/Robot.h>
+#include <dwl/behavior/BodyMotorPrimitives.h>
+#include <dwl/utils/utils.h>
+
+
+namespace dwl
+{
+
+namespace robot
+{
+
+/**
+ * @class RobotBundle
+ * @brief Precompiled binary bundle of the robot properties and body motor primitives. The bundle
+ * is compiled once from the yaml files, and it's loaded by memory-mapping the file without any
+ * parsing. The bundle starts with a header that describes its format version, the byte order and
+ * the size and checksum of the payload, so an outdated or corrupted bundle is rejected
+ */
+class RobotBundle
+{
+	public:
+		/** @brief Format version of the bundle */
+		static const uint32_t VERSION = 1;
+
+		/**
+		 * @brief Compiles the yaml files of the robot properties and body motor primitives into a
+		 * bundle
+		 * @param std::string File name of the robot yaml
+		 * @param std::string File name of the body motor primitives yaml
+		 * @param std::string File name of the bundle
+		 * @return True if the bundle was written
+		 */
+		static bool compile(std::string robot_filename,
+							std::string primitives_filename,
+							std::string bundle_filename);
+
+		/**
+		 * @brief Writes the robot properties and its body motor primitives into a bundle
+		 * @param Robot& Robot
+		 * @param std::string File name of the bundle
+		 * @return True if the bundle was written
+		 */
+		static bool write(Robot& robot,
+						  std::string bundle_filename);
+
+		/**
+		 * @brief Reads the robot properties and its body motor primitives from a bundle. The robot
+		 * isn't modified if the bundle is invalid
+		 * @param Robot& Robot
+		 * @param std::string File name of the bundle
+		 * @return True if the bundle was read
+		 */
+		static bool read(Robot& robot,
+						 std::string bundle_filename);
+
+
+	private:
+		/** @brief Header of the bundle */
+		struct Header
+		{
+			/** @brief Magic number of the bundle file */
+			char magic[8];
+
+			/** @brief Format version */
+			uint32_t version;
+
+			/** @brief Byte-order mark, it's written in the byte order of the host */
+			uint32_t byte_order;
+
+			/** @brief Size of the payload in bytes */
+			uint64_t payload_size;
+
+			/** @brief FNV-1a checksum of the payload */
+			uint64_t checksum;
+		};
+
+		/**
+		 * @brief Computes the FNV-1a checksum of a block of memory
+		 * @param const char* Data
+		 * @param std::size_t Size of the data in bytes
+		 * @return The checksum
+		 */
+		static uint64_t computeChecksum(const char* data,
+										std::size_t size);
+};
+
+} //@namespace robot
+} //@namespace dwl
+
+#endif
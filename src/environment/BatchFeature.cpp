@@ -0,0 +1,58 @@
+#include <dwl/environment/BatchFeature.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+BatchFeature::BatchFeature() : weight_(1.), footprint_radius_(-1.)
+{
+
+}
+
+
+BatchFeature::~BatchFeature()
+{
+
+}
+
+
+void BatchFeature::reset(robot::Robot* robot)
+{
+
+}
+
+
+void BatchFeature::setWeight(double weight)
+{
+	weight_ = weight;
+}
+
+
+void BatchFeature::getWeight(double& weight)
+{
+	weight = weight_;
+}
+
+
+std::string BatchFeature::getName()
+{
+	return name_;
+}
+
+
+void BatchFeature::setFootprintRadius(double radius)
+{
+	footprint_radius_ = radius;
+}
+
+
+double BatchFeature::getFootprintRadius()
+{
+	return footprint_radius_;
+}
+
+} //@namespace environment
+} //@namespace dwl
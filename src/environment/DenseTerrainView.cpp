@@ -0,0 +1,188 @@
+#include <dwl/environment/DenseTerrainView.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+DenseTerrainView::DenseTerrainView() : min_key_x_(0), min_key_y_(0), size_x_(0),
+		size_y_(0), num_cells_(0), average_cost_(0), minimum_cost_(0), dirty_min_x_(0), dirty_min_y_(0),
+		dirty_max_x_(-1), dirty_max_y_(-1), is_fully_dirty_(true), version_(0),
+		is_terrain_information_(false)
+{
+
+}
+
+
+DenseTerrainView::~DenseTerrainView()
+{
+
+}
+
+
+void DenseTerrainView::reset(TerrainMap* terrain)
+{
+	int previous_min_x = min_key_x_, previous_min_y = min_key_y_;
+	int previous_size_x = size_x_, previous_size_y = size_y_;
+	double previous_average_cost = average_cost_;
+	bool was_terrain_information = is_terrain_information_ && (num_cells_ > 0);
+
+	dirty_min_x_ = dirty_min_y_ = 0;
+	dirty_max_x_ = dirty_max_y_ = -1;
+	num_cells_ = 0;
+	size_x_ = 0;
+	size_y_ = 0;
+	is_terrain_information_ = terrain->isTerrainInformation();
+	if (!is_terrain_information_) {
+		cost_.clear();
+		valid_mask_.clear();
+		is_fully_dirty_ = true;
+		if (was_terrain_information)
+			version_++;
+		return;
+	}
+
+	const TerrainDataMap& terrain_map = terrain->getTerrainDataMap();
+	average_cost_ = terrain->getAverageCostOfTerrain();
+
+	// Computing the bounding box of the terrain cells
+	int min_x = std::numeric_limits<int>::max(), max_x = std::numeric_limits<int>::min();
+	int min_y = std::numeric_limits<int>::max(), max_y = std::numeric_limits<int>::min();
+	for (TerrainDataMap::const_iterator vertex_iter = terrain_map.begin();
+			vertex_iter != terrain_map.end(); vertex_iter++) {
+		Key key;
+		terrain->getTerrainSpaceModel().vertexToKey(key, vertex_iter->first, true);
+		if (key.x < min_x) min_x = key.x;
+		if (key.x > max_x) max_x = key.x;
+		if (key.y < min_y) min_y = key.y;
+		if (key.y > max_y) max_y = key.y;
+	}
+
+	if (terrain_map.empty()) {
+		is_fully_dirty_ = true;
+		if (was_terrain_information)
+			version_++;
+		return;
+	}
+
+	min_key_x_ = min_x;
+	min_key_y_ = min_y;
+	size_x_ = max_x - min_x + 1;
+	size_y_ = max_y - min_y + 1;
+
+	// Keeping the previous information for detecting the changed cells, the allocated memory is
+	// kept between resets
+	is_fully_dirty_ = !was_terrain_information || (min_key_x_ != previous_min_x) ||
+			(min_key_y_ != previous_min_y) || (size_x_ != previous_size_x) ||
+			(size_y_ != previous_size_y);
+	if (!is_fully_dirty_) {
+		cost_.swap(previous_cost_);
+		valid_mask_.swap(previous_valid_mask_);
+	}
+
+	// Filling the flat arrays
+	std::size_t size = (std::size_t) size_x_ * size_y_;
+	cost_.assign(size, 0.);
+	valid_mask_.assign((size + 63) / 64, 0);
+	minimum_cost_ = std::numeric_limits<double>::max();
+	for (TerrainDataMap::const_iterator vertex_iter = terrain_map.begin();
+			vertex_iter != terrain_map.end(); vertex_iter++) {
+		Key key;
+		terrain->getTerrainSpaceModel().vertexToKey(key, vertex_iter->first, true);
+
+		int index = getIndex(key.x, key.y);
+		cost_[index] = vertex_iter->second.cost;
+		valid_mask_[index >> 6] |= (uint64_t) 1 << (index & 63);
+		minimum_cost_ = std::min(minimum_cost_, vertex_iter->second.cost);
+	}
+	num_cells_ = terrain_map.size();
+
+	if (is_fully_dirty_) {
+		version_++;
+		return;
+	}
+
+	// Computing the region of the changed cells
+	for (std::size_t index = 0; index < size; index++) {
+		bool is_valid = (valid_mask_[index >> 6] >> (index & 63)) & 1;
+		bool was_valid = (previous_valid_mask_[index >> 6] >> (index & 63)) & 1;
+		if ((is_valid == was_valid) && (!is_valid || (cost_[index] == previous_cost_[index])))
+			continue;
+
+		int x = min_key_x_ + index % size_x_;
+		int y = min_key_y_ + index / size_x_;
+		if (dirty_max_x_ < dirty_min_x_) {
+			dirty_min_x_ = dirty_max_x_ = x;
+			dirty_min_y_ = dirty_max_y_ = y;
+		} else {
+			if (x < dirty_min_x_) dirty_min_x_ = x;
+			if (x > dirty_max_x_) dirty_max_x_ = x;
+			if (y < dirty_min_y_) dirty_min_y_ = y;
+			if (y > dirty_max_y_) dirty_max_y_ = y;
+		}
+	}
+
+	if ((dirty_max_x_ >= dirty_min_x_) || (average_cost_ != previous_average_cost))
+		version_++;
+}
+
+
+bool DenseTerrainView::getDirtyRegion(int& min_key_x,
+									  int& min_key_y,
+									  int& max_key_x,
+									  int& max_key_y) const
+{
+	min_key_x = dirty_min_x_;
+	min_key_y = dirty_min_y_;
+	max_key_x = dirty_max_x_;
+	max_key_y = dirty_max_y_;
+
+	return !is_fully_dirty_;
+}
+
+
+void DenseTerrainView::getBounds(int& min_key_x,
+								 int& min_key_y,
+								 int& size_x,
+								 int& size_y) const
+{
+	min_key_x = min_key_x_;
+	min_key_y = min_key_y_;
+	size_x = size_x_;
+	size_y = size_y_;
+}
+
+
+unsigned int DenseTerrainView::getVersion() const
+{
+	return version_;
+}
+
+
+bool DenseTerrainView::isTerrainInformation() const
+{
+	return is_terrain_information_;
+}
+
+
+double DenseTerrainView::getAverageCost() const
+{
+	return average_cost_;
+}
+
+
+double DenseTerrainView::getMinimumCost() const
+{
+	return minimum_cost_;
+}
+
+
+std::size_t DenseTerrainView::getNumberOfCells() const
+{
+	return num_cells_;
+}
+
+} //@namespace environment
+} //@namespace dwl
@@ -0,0 +1,62 @@
+#include <dwl/environment/FeatureAdapter.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+FeatureAdapter::FeatureAdapter(Feature* feature) : feature_(feature)
+{
+
+}
+
+
+FeatureAdapter::~FeatureAdapter()
+{
+
+}
+
+
+void FeatureAdapter::reset(robot::Robot* robot)
+{
+	feature_->reset(robot);
+}
+
+
+void FeatureAdapter::computeCosts(std::vector<double>& costs,
+								  const std::vector<FeatureState>& states,
+								  const FeatureTerrain& terrain)
+{
+	costs.resize(states.size());
+	if (states.empty())
+		return;
+
+	// Filling the robot and terrain information once for the whole batch
+	RobotAndTerrain info;
+	info.resolution = terrain.resolution;
+	if (terrain.height_map != NULL)
+		info.height_map = *terrain.height_map;
+
+	for (std::size_t i = 0; i < states.size(); i++) {
+		info.body_action = states[i].body_action;
+		info.pose = states[i].pose;
+		feature_->computeCost(costs[i], info);
+	}
+}
+
+
+void FeatureAdapter::getWeight(double& weight)
+{
+	feature_->getWeight(weight);
+}
+
+
+std::string FeatureAdapter::getName()
+{
+	return feature_->getName();
+}
+
+} //@namespace environment
+} //@namespace dwl
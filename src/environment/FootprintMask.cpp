@@ -0,0 +1,170 @@
+#include <dwl/environment/FootprintMask.h>
+#include <algorithm>
+#include <set>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+/** @brief Orders the cell offsets by row, and then by column */
+static bool isLowerCellOffset(const CellOffset& a, const CellOffset& b)
+{
+	if (a.dy == b.dy)
+		return a.dx < b.dx;
+	return a.dy < b.dy;
+}
+
+
+/** @brief Indicates if two cell offsets are the same */
+static bool isEqualCellOffset(const CellOffset& a, const CellOffset& b)
+{
+	return (a.dx == b.dx) && (a.dy == b.dy);
+}
+
+
+FootprintMask::FootprintMask() : circumscribed_squared_radius_(0),
+		inscribed_squared_radius_(0), is_defined_(false)
+{
+
+}
+
+
+FootprintMask::~FootprintMask()
+{
+
+}
+
+
+void FootprintMask::rasterize(std::vector<CellOffset>& offsets,
+							  const SearchArea& area,
+							  double yaw,
+							  double step,
+							  double resolution)
+{
+	offsets.clear();
+
+	// Computing the number of samples with integer arithmetic, so it doesn't depend on the
+	// floating-point drift of the sampling loop
+	double tolerance = 1e-9;
+	int num_x = (int) floor((area.max_x - area.min_x) / step + tolerance) + 1;
+	int num_y = (int) floor((area.max_y - area.min_y) / step + tolerance) + 1;
+	if ((num_x <= 0) || (num_y <= 0))
+		return;
+
+	double cos_yaw = cos(yaw);
+	double sin_yaw = sin(yaw);
+	offsets.reserve(num_x * num_y);
+	for (int j = 0; j < num_y; j++) {
+		double y = area.min_y + j * step;
+		for (int i = 0; i < num_x; i++) {
+			double x = area.min_x + i * step;
+
+			// Computing the rotated sample w.r.t. the center of the anchor cell
+			CellOffset offset;
+			offset.dx = (int) floor((x * cos_yaw - y * sin_yaw) / resolution + 0.5);
+			offset.dy = (int) floor((x * sin_yaw + y * cos_yaw) / resolution + 0.5);
+			offsets.push_back(offset);
+		}
+	}
+
+	// The same cell could be sampled more than once
+	std::sort(offsets.begin(), offsets.end(), isLowerCellOffset);
+	offsets.erase(std::unique(offsets.begin(), offsets.end(), isEqualCellOffset), offsets.end());
+}
+
+
+void FootprintMask::reset(const std::vector<CellOffset>& offsets)
+{
+	rows_.clear();
+	words_.clear();
+
+	std::size_t num_offsets = offsets.size();
+	std::size_t i = 0;
+	while (i < num_offsets) {
+		// Getting the cells of the current row
+		std::size_t end = i;
+		while ((end < num_offsets) && (offsets[end].dy == offsets[i].dy))
+			end++;
+
+		FootprintRow row;
+		row.dy = offsets[i].dy;
+		row.dx = offsets[i].dx;
+		row.first_word = words_.size();
+		row.num_words = (offsets[end - 1].dx - row.dx) / 64 + 1;
+		words_.resize(words_.size() + row.num_words, 0);
+		for (std::size_t k = i; k < end; k++) {
+			int bit = offsets[k].dx - row.dx;
+			words_[row.first_word + bit / 64] |= (uint64_t) 1 << (bit % 64);
+		}
+		rows_.push_back(row);
+
+		i = end;
+	}
+
+	// Computing the circumscribed circle and the bounding box of the mask
+	circumscribed_squared_radius_ = 0;
+	int min_dx = 0, max_dx = 0, min_dy = 0, max_dy = 0;
+	std::set<std::pair<int, int> > cells;
+	for (std::size_t k = 0; k < num_offsets; k++) {
+		uint32_t squared_radius = offsets[k].dx * offsets[k].dx + offsets[k].dy * offsets[k].dy;
+		circumscribed_squared_radius_ = std::max(circumscribed_squared_radius_, squared_radius);
+
+		min_dx = std::min(min_dx, offsets[k].dx);
+		max_dx = std::max(max_dx, offsets[k].dx);
+		min_dy = std::min(min_dy, offsets[k].dy);
+		max_dy = std::max(max_dy, offsets[k].dy);
+		cells.insert(std::make_pair(offsets[k].dx, offsets[k].dy));
+	}
+
+	// Computing the inscribed circle as the closest cell that doesn't belong to the mask. It's
+	// enough to search inside the bounding box (plus one cell) if the anchor belongs to the mask
+	inscribed_squared_radius_ = 0;
+	if (cells.find(std::make_pair(0, 0)) != cells.end()) {
+		inscribed_squared_radius_ = std::numeric_limits<uint32_t>::max();
+		for (int dy = min_dy - 1; dy <= max_dy + 1; dy++) {
+			for (int dx = min_dx - 1; dx <= max_dx + 1; dx++) {
+				if (cells.find(std::make_pair(dx, dy)) == cells.end())
+					inscribed_squared_radius_ = std::min(inscribed_squared_radius_,
+							(uint32_t) (dx * dx + dy * dy));
+			}
+		}
+	}
+
+	is_defined_ = true;
+}
+
+
+uint32_t FootprintMask::getCircumscribedSquaredRadius() const
+{
+	return circumscribed_squared_radius_;
+}
+
+
+uint32_t FootprintMask::getInscribedSquaredRadius() const
+{
+	return inscribed_squared_radius_;
+}
+
+
+bool FootprintMask::isDefined() const
+{
+	return is_defined_;
+}
+
+
+const std::vector<FootprintRow>& FootprintMask::getRows() const
+{
+	return rows_;
+}
+
+
+const std::vector<uint64_t>& FootprintMask::getWords() const
+{
+	return words_;
+}
+
+} //@namespace environment
+} //@namespace dwl
@@ -0,0 +1,181 @@
+#include <dwl/environment/ObstacleGrid.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+ObstacleGrid::ObstacleGrid() : min_key_x_(0), min_key_y_(0), size_x_(0), size_y_(0),
+		words_per_row_(0), is_obstacle_information_(false)
+{
+
+}
+
+
+ObstacleGrid::~ObstacleGrid()
+{
+
+}
+
+
+void ObstacleGrid::reset(TerrainMap* terrain)
+{
+	is_obstacle_information_ = terrain->isObstacleInformation();
+	if (!is_obstacle_information_) {
+		size_x_ = 0;
+		size_y_ = 0;
+		words_per_row_ = 0;
+		words_.clear();
+		squared_distance_.clear();
+		return;
+	}
+
+	// Getting the keys of the occupied cells
+	const ObstacleMap& obstacle_map = terrain->getObstacleMap();
+	std::vector<Key> obstacle_keys;
+	obstacle_keys.reserve(obstacle_map.size());
+	for (ObstacleMap::const_iterator vertex_iter = obstacle_map.begin();
+			vertex_iter != obstacle_map.end(); vertex_iter++) {
+		if (!vertex_iter->second)
+			continue;
+
+		Key key;
+		terrain->getObstacleSpaceModel().vertexToKey(key, vertex_iter->first, true);
+		obstacle_keys.push_back(key);
+	}
+
+	reset(obstacle_keys);
+}
+
+
+void ObstacleGrid::reset(const std::vector<Key>& obstacle_keys)
+{
+	size_x_ = 0;
+	size_y_ = 0;
+	words_per_row_ = 0;
+	is_obstacle_information_ = true;
+	if (obstacle_keys.empty()) {
+		words_.clear();
+		squared_distance_.clear();
+		return;
+	}
+
+	// Computing the bounding box of the occupied cells
+	int min_x = std::numeric_limits<int>::max(), max_x = std::numeric_limits<int>::min();
+	int min_y = std::numeric_limits<int>::max(), max_y = std::numeric_limits<int>::min();
+	for (std::size_t i = 0; i < obstacle_keys.size(); i++) {
+		const Key& key = obstacle_keys[i];
+		if (key.x < min_x) min_x = key.x;
+		if (key.x > max_x) max_x = key.x;
+		if (key.y < min_y) min_y = key.y;
+		if (key.y > max_y) max_y = key.y;
+	}
+
+	min_key_x_ = min_x;
+	min_key_y_ = min_y;
+	size_x_ = max_x - min_x + 1;
+	size_y_ = max_y - min_y + 1;
+
+	// Packing the occupied cells, the padding word allows unaligned reads of 64 cells
+	words_per_row_ = (size_x_ + 63) / 64 + 1;
+	words_.assign((std::size_t) words_per_row_ * size_y_, 0);
+	for (std::size_t i = 0; i < obstacle_keys.size(); i++) {
+		int x = obstacle_keys[i].x - min_key_x_;
+		int y = obstacle_keys[i].y - min_key_y_;
+		words_[y * words_per_row_ + (x >> 6)] |= (uint64_t) 1 << (x & 63);
+	}
+
+	computeDistanceTransform();
+}
+
+
+void ObstacleGrid::computeDistanceTransform()
+{
+	// Initializing the sampled function, zero in the occupied cells
+	const double infinity = 1e20;
+	std::size_t num_cells = (std::size_t) size_x_ * size_y_;
+	std::vector<double> distance(num_cells);
+	for (int y = 0; y < size_y_; y++) {
+		for (int x = 0; x < size_x_; x++)
+			distance[y * size_x_ + x] = isOccupied(x + min_key_x_, y + min_key_y_) ? 0 : infinity;
+	}
+
+	// Computing the transform along the columns, and then along the rows
+	std::vector<int> vertices(std::max(size_x_, size_y_));
+	std::vector<double> boundaries(std::max(size_x_, size_y_) + 1);
+	std::vector<double> transform(std::max(size_x_, size_y_));
+	std::vector<double> column(size_y_);
+	for (int x = 0; x < size_x_; x++) {
+		for (int y = 0; y < size_y_; y++)
+			column[y] = distance[y * size_x_ + x];
+		computeDistanceTransform(&column[0], size_y_, vertices, boundaries, transform);
+		for (int y = 0; y < size_y_; y++)
+			distance[y * size_x_ + x] = column[y];
+	}
+	for (int y = 0; y < size_y_; y++)
+		computeDistanceTransform(&distance[y * size_x_], size_x_, vertices, boundaries, transform);
+
+	// The squared distances are integers, so they are stored without loss
+	squared_distance_.resize(num_cells);
+	for (std::size_t i = 0; i < num_cells; i++)
+		squared_distance_[i] = (uint32_t) std::min(distance[i],
+				(double) std::numeric_limits<uint32_t>::max());
+}
+
+
+void ObstacleGrid::computeDistanceTransform(double* f,
+											int n,
+											std::vector<int>& vertices,
+											std::vector<double>& boundaries,
+											std::vector<double>& transform)
+{
+	// Computing the lower envelope of the parabolas
+	int k = 0;
+	vertices[0] = 0;
+	boundaries[0] = -std::numeric_limits<double>::max();
+	boundaries[1] = std::numeric_limits<double>::max();
+	for (int q = 1; q < n; q++) {
+		double s;
+		while (true) {
+			int v = vertices[k];
+			s = ((f[q] + q * q) - (f[v] + v * v)) / (2. * (q - v));
+			if ((s > boundaries[k]) || (k == 0))
+				break;
+			k--;
+		}
+		if (s <= boundaries[k]) {
+			// The new parabola is lower than the first one everywhere
+			vertices[0] = q;
+			boundaries[1] = std::numeric_limits<double>::max();
+			continue;
+		}
+
+		k++;
+		vertices[k] = q;
+		boundaries[k] = s;
+		boundaries[k + 1] = std::numeric_limits<double>::max();
+	}
+
+	// Evaluating the lower envelope
+	k = 0;
+	for (int q = 0; q < n; q++) {
+		while (boundaries[k + 1] < q)
+			k++;
+		double d = q - vertices[k];
+		transform[q] = d * d + f[vertices[k]];
+	}
+
+	for (int q = 0; q < n; q++)
+		f[q] = transform[q];
+}
+
+
+bool ObstacleGrid::isObstacleInformation() const
+{
+	return is_obstacle_information_;
+}
+
+} //@namespace environment
+} //@namespace dwl
@@ -0,0 +1,167 @@
+#include <dwl/environment/TerrainCellIndex.h>
+#include <algorithm>
+#include <cmath>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+TerrainCellIndex::TerrainCellIndex() : min_key_x_(0), min_key_y_(0), size_x_(0), size_y_(0),
+		num_buckets_x_(0), num_buckets_y_(0)
+{
+
+}
+
+
+TerrainCellIndex::~TerrainCellIndex()
+{
+
+}
+
+
+void TerrainCellIndex::reset(const DenseTerrainView& terrain_view)
+{
+	terrain_view.getBounds(min_key_x_, min_key_y_, size_x_, size_y_);
+	num_buckets_x_ = (size_x_ + BUCKET_SIZE - 1) / BUCKET_SIZE;
+	num_buckets_y_ = (size_y_ + BUCKET_SIZE - 1) / BUCKET_SIZE;
+	count_.assign(num_buckets_x_ * num_buckets_y_, 0);
+
+	for (int bucket_y = 0; bucket_y < num_buckets_y_; bucket_y++) {
+		for (int bucket_x = 0; bucket_x < num_buckets_x_; bucket_x++)
+			countBucket(terrain_view, bucket_x, bucket_y);
+	}
+}
+
+
+void TerrainCellIndex::update(const DenseTerrainView& terrain_view,
+							  int min_key_x,
+							  int min_key_y,
+							  int max_key_x,
+							  int max_key_y)
+{
+	// Rebuilding the whole index if the bounding box of the view changed
+	int min_x, min_y, size_x, size_y;
+	terrain_view.getBounds(min_x, min_y, size_x, size_y);
+	if ((min_x != min_key_x_) || (min_y != min_key_y_) ||
+			(size_x != size_x_) || (size_y != size_y_)) {
+		reset(terrain_view);
+		return;
+	}
+
+	// Counting again the buckets that overlap the region
+	int first_x = std::max(min_key_x - min_key_x_, 0) / BUCKET_SIZE;
+	int first_y = std::max(min_key_y - min_key_y_, 0) / BUCKET_SIZE;
+	int last_x = std::min(max_key_x - min_key_x_, size_x_ - 1);
+	int last_y = std::min(max_key_y - min_key_y_, size_y_ - 1);
+	if ((last_x < 0) || (last_y < 0))
+		return;
+
+	for (int bucket_y = first_y; bucket_y <= last_y / BUCKET_SIZE; bucket_y++) {
+		for (int bucket_x = first_x; bucket_x <= last_x / BUCKET_SIZE; bucket_x++)
+			countBucket(terrain_view, bucket_x, bucket_y);
+	}
+}
+
+
+bool TerrainCellIndex::findClosest(int& key_x,
+								   int& key_y,
+								   const DenseTerrainView& terrain_view,
+								   double query_x,
+								   double query_y) const
+{
+	if ((num_buckets_x_ == 0) || (num_buckets_y_ == 0))
+		return false;
+
+	// Getting the bucket of the query, the query is clamped to the bounding box
+	double x = query_x - min_key_x_;
+	double y = query_y - min_key_y_;
+	int center_x = std::min(std::max((int) floor(x + 0.5), 0), size_x_ - 1) / BUCKET_SIZE;
+	int center_y = std::min(std::max((int) floor(y + 0.5), 0), size_y_ - 1) / BUCKET_SIZE;
+
+	// Visiting the buckets in rings around the query bucket. The cells of the ring r are at
+	// least (r - 1) buckets away from the query
+	bool is_found = false;
+	double closest_distance = std::numeric_limits<double>::max();
+	int closest_x = 0, closest_y = 0;
+	int max_ring = std::max(num_buckets_x_, num_buckets_y_);
+	for (int r = 0; r <= max_ring; r++) {
+		if (is_found && (r > 1)) {
+			double ring_distance = (r - 1) * BUCKET_SIZE;
+			if (ring_distance * ring_distance > closest_distance)
+				break;
+		}
+
+		for (int bucket_y = center_y - r; bucket_y <= center_y + r; bucket_y++) {
+			if ((bucket_y < 0) || (bucket_y >= num_buckets_y_))
+				continue;
+
+			// Only the first and last rows of the ring are fully visited
+			int step = ((bucket_y == center_y - r) || (bucket_y == center_y + r)) ? 1 : 2 * r;
+			for (int bucket_x = center_x - r; bucket_x <= center_x + r; bucket_x += step) {
+				if ((bucket_x < 0) || (bucket_x >= num_buckets_x_) ||
+						(count_[bucket_y * num_buckets_x_ + bucket_x] == 0))
+					continue;
+
+				// Skipping the bucket if all its cells are farther than the closest one
+				int first_x = bucket_x * BUCKET_SIZE, first_y = bucket_y * BUCKET_SIZE;
+				int last_x = std::min(first_x + BUCKET_SIZE, size_x_) - 1;
+				int last_y = std::min(first_y + BUCKET_SIZE, size_y_) - 1;
+				double dx = std::max(std::max(first_x - x, x - last_x), 0.);
+				double dy = std::max(std::max(first_y - y, y - last_y), 0.);
+				if (dx * dx + dy * dy > closest_distance)
+					continue;
+
+				for (int cell_y = first_y; cell_y <= last_y; cell_y++) {
+					for (int cell_x = first_x; cell_x <= last_x; cell_x++) {
+						if (!terrain_view.isValid(cell_y * size_x_ + cell_x))
+							continue;
+
+						double distance = (cell_x - x) * (cell_x - x) +
+								(cell_y - y) * (cell_y - y);
+						bool is_lower_key = (cell_y < closest_y) ||
+								((cell_y == closest_y) && (cell_x < closest_x));
+						if ((distance < closest_distance) ||
+								((distance == closest_distance) && is_lower_key)) {
+							closest_distance = distance;
+							closest_x = cell_x;
+							closest_y = cell_y;
+							is_found = true;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (!is_found)
+		return false;
+
+	key_x = closest_x + min_key_x_;
+	key_y = closest_y + min_key_y_;
+	return true;
+}
+
+
+void TerrainCellIndex::countBucket(const DenseTerrainView& terrain_view,
+								   int bucket_x,
+								   int bucket_y)
+{
+	int first_x = bucket_x * BUCKET_SIZE, first_y = bucket_y * BUCKET_SIZE;
+	int last_x = std::min(first_x + BUCKET_SIZE, size_x_);
+	int last_y = std::min(first_y + BUCKET_SIZE, size_y_);
+
+	unsigned int count = 0;
+	for (int cell_y = first_y; cell_y < last_y; cell_y++) {
+		for (int cell_x = first_x; cell_x < last_x; cell_x++) {
+			if (terrain_view.isValid(cell_y * size_x_ + cell_x))
+				count++;
+		}
+	}
+	count_[bucket_y * num_buckets_x_ + bucket_x] = count;
+}
+
+} //@namespace environment
+} //@namespace dwl
@@ -0,0 +1,138 @@
+#include <dwl/environment/TerrainSnapshot.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+TerrainSnapshot::TerrainSnapshot() : num_obstacle_cells_(0), resolution_(0),
+		obstacle_resolution_(0), dirty_min_x_(0), dirty_min_y_(0), dirty_max_x_(-1),
+		dirty_max_y_(-1), is_fully_dirty_(true), version_(0)
+{
+
+}
+
+
+TerrainSnapshot::~TerrainSnapshot()
+{
+
+}
+
+
+void TerrainSnapshot::setPreviousVersion(const TerrainSnapshot& previous)
+{
+	terrain_view_ = previous.terrain_view_;
+	dirty_min_x_ = previous.dirty_min_x_;
+	dirty_min_y_ = previous.dirty_min_y_;
+	dirty_max_x_ = previous.dirty_max_x_;
+	dirty_max_y_ = previous.dirty_max_y_;
+	is_fully_dirty_ = previous.is_fully_dirty_;
+	version_ = previous.version_;
+}
+
+
+void TerrainSnapshot::reset(TerrainMap* terrain)
+{
+	version_++;
+	resolution_ = terrain->getResolution(true);
+	obstacle_resolution_ = terrain->getObstacleResolution();
+
+	// Updating the dense view, the changed region is kept if the view didn't change, so it always
+	// describes the changes w.r.t. the previous version of the view
+	unsigned int view_version = terrain_view_.getVersion();
+	terrain_view_.reset(terrain);
+	if (terrain_view_.getVersion() != view_version)
+		is_fully_dirty_ = !terrain_view_.getDirtyRegion(dirty_min_x_, dirty_min_y_,
+				dirty_max_x_, dirty_max_y_);
+
+	// Rebuilding the obstacle grid on every publish, so a forced publish never carries forward the
+	// grid of a previous version
+	obstacle_grid_.reset(terrain);
+	num_obstacle_cells_ = terrain->isObstacleInformation() ? terrain->getObstacleMap().size() : 0;
+
+	// Copying the information that is read directly from the terrain map
+	height_map_ = terrain->getTerrainHeightMap();
+	const TerrainDataMap& terrain_map = terrain->getTerrainDataMap();
+	terrain_vertices_.clear();
+	terrain_vertices_.reserve(terrain_map.size());
+	for (TerrainDataMap::const_iterator vertex_iter = terrain_map.begin();
+			vertex_iter != terrain_map.end(); vertex_iter++)
+		terrain_vertices_.push_back(vertex_iter->first);
+}
+
+
+bool TerrainSnapshot::isOutdated(TerrainMap* terrain) const
+{
+	if ((terrain->isTerrainInformation() != terrain_view_.isTerrainInformation()) ||
+			(terrain->isObstacleInformation() != obstacle_grid_.isObstacleInformation()))
+		return true;
+
+	if (terrain_view_.isTerrainInformation() &&
+			((terrain->getTerrainDataMap().size() != terrain_view_.getNumberOfCells()) ||
+			(terrain->getAverageCostOfTerrain() != terrain_view_.getAverageCost())))
+		return true;
+
+	return obstacle_grid_.isObstacleInformation() &&
+			(terrain->getObstacleMap().size() != num_obstacle_cells_);
+}
+
+
+bool TerrainSnapshot::getDirtyRegion(int& min_key_x,
+									 int& min_key_y,
+									 int& max_key_x,
+									 int& max_key_y) const
+{
+	min_key_x = dirty_min_x_;
+	min_key_y = dirty_min_y_;
+	max_key_x = dirty_max_x_;
+	max_key_y = dirty_max_y_;
+
+	return !is_fully_dirty_;
+}
+
+
+const DenseTerrainView& TerrainSnapshot::getTerrainView() const
+{
+	return terrain_view_;
+}
+
+
+const ObstacleGrid& TerrainSnapshot::getObstacleGrid() const
+{
+	return obstacle_grid_;
+}
+
+
+const HeightMap& TerrainSnapshot::getHeightMap() const
+{
+	return height_map_;
+}
+
+
+const std::vector<Vertex>& TerrainSnapshot::getTerrainVertices() const
+{
+	return terrain_vertices_;
+}
+
+
+double TerrainSnapshot::getResolution() const
+{
+	return resolution_;
+}
+
+
+double TerrainSnapshot::getObstacleResolution() const
+{
+	return obstacle_resolution_;
+}
+
+
+uint64_t TerrainSnapshot::getVersion() const
+{
+	return version_;
+}
+
+} //@namespace environment
+} //@namespace dwl
@@ -0,0 +1,66 @@
+#include <dwl/environment/TerrainSnapshotBuffer.h>
+#include <atomic>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+TerrainSnapshotBuffer::TerrainSnapshotBuffer()
+{
+
+}
+
+
+TerrainSnapshotBuffer::~TerrainSnapshotBuffer()
+{
+
+}
+
+
+void TerrainSnapshotBuffer::publish(TerrainMap* terrain)
+{
+	std::shared_ptr<const TerrainSnapshot> current = std::atomic_load(&current_);
+
+	// Recycling the back buffer if no planner pins it. The published pointer doesn't point to the
+	// back buffer, so it can't be pinned again once it's only referenced here
+	std::shared_ptr<TerrainSnapshot> snapshot;
+	if (back_ && (back_.use_count() == 1)) {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		snapshot.swap(back_);
+	} else {
+		back_.reset();
+		snapshot = std::make_shared<TerrainSnapshot>();
+	}
+
+	// Building the next version from the current one. Only the dense view is copied since the rest
+	// of the information is rebuilt by the reset, and the copies keep the allocated memory of the
+	// back buffer
+	if (current)
+		snapshot->setPreviousVersion(*current);
+	snapshot->reset(terrain);
+
+	std::atomic_store(&current_, std::shared_ptr<const TerrainSnapshot>(snapshot));
+	back_ = std::const_pointer_cast<TerrainSnapshot>(current);
+}
+
+
+std::shared_ptr<const TerrainSnapshot> TerrainSnapshotBuffer::acquire() const
+{
+	return std::atomic_load(&current_);
+}
+
+
+uint64_t TerrainSnapshotBuffer::getVersion() const
+{
+	std::shared_ptr<const TerrainSnapshot> current = std::atomic_load(&current_);
+	if (!current)
+		return 0;
+
+	return current->getVersion();
+}
+
+} //@namespace environment
+} //@namespace dwl
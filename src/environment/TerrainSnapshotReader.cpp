@@ -0,0 +1,125 @@
+#include <dwl/environment/TerrainSnapshotReader.h>
+
+
+namespace dwl
+{
+
+namespace environment
+{
+
+TerrainSnapshotReader::TerrainSnapshotReader() : shared_snapshots_(NULL), is_pinned_(false),
+		is_terrain_changed_(false), dirty_min_x_(0), dirty_min_y_(0), dirty_max_x_(-1),
+		dirty_max_y_(-1), is_dirty_region_(false)
+{
+
+}
+
+
+TerrainSnapshotReader::~TerrainSnapshotReader()
+{
+
+}
+
+
+void TerrainSnapshotReader::setSharedSnapshots(TerrainSnapshotBuffer* snapshots)
+{
+	shared_snapshots_ = snapshots;
+	clear();
+}
+
+
+void TerrainSnapshotReader::clear()
+{
+	snapshot_.reset();
+	is_pinned_ = false;
+}
+
+
+bool TerrainSnapshotReader::update(TerrainMap* terrain,
+								   bool is_forced)
+{
+	// Keeping the pinned snapshot until it's released
+	if (is_pinned_ && snapshot_)
+		return false;
+
+	// Getting the last snapshot, it's published from the terrain map if there isn't a mapping
+	// thread that publishes them
+	std::shared_ptr<const TerrainSnapshot> snapshot;
+	if (shared_snapshots_ != NULL) {
+		snapshot = shared_snapshots_->acquire();
+		if (!snapshot)
+			snapshot = getEmptySnapshot();
+	} else {
+		if (is_forced || !snapshot_ || is_terrain_changed_ || snapshot_->isOutdated(terrain)) {
+			terrain_snapshots_.publish(terrain);
+			is_terrain_changed_ = false;
+		}
+		snapshot = terrain_snapshots_.acquire();
+	}
+
+	if (snapshot == snapshot_)
+		return false;
+
+	bool is_first = !snapshot_;
+	unsigned int version = is_first ? 0 : snapshot_->getTerrainView().getVersion();
+	snapshot_ = snapshot;
+	unsigned int new_version = snapshot_->getTerrainView().getVersion();
+	if (!is_first && (new_version == version))
+		return false;
+
+	// The changed region is only known w.r.t. the previous version of the view
+	is_dirty_region_ = !is_first && (new_version == version + 1) &&
+			snapshot_->getDirtyRegion(dirty_min_x_, dirty_min_y_, dirty_max_x_, dirty_max_y_);
+
+	return true;
+}
+
+
+bool TerrainSnapshotReader::getDirtyRegion(int& min_key_x,
+										   int& min_key_y,
+										   int& max_key_x,
+										   int& max_key_y) const
+{
+	min_key_x = dirty_min_x_;
+	min_key_y = dirty_min_y_;
+	max_key_x = dirty_max_x_;
+	max_key_y = dirty_max_y_;
+
+	return is_dirty_region_;
+}
+
+
+void TerrainSnapshotReader::pin()
+{
+	is_pinned_ = true;
+}
+
+
+void TerrainSnapshotReader::release()
+{
+	is_pinned_ = false;
+}
+
+
+void TerrainSnapshotReader::notifyChanged()
+{
+	is_terrain_changed_ = true;
+}
+
+
+const TerrainSnapshot& TerrainSnapshotReader::getSnapshot() const
+{
+	return *snapshot_;
+}
+
+
+const std::shared_ptr<const TerrainSnapshot>& TerrainSnapshotReader::getEmptySnapshot()
+{
+	static const std::shared_ptr<const TerrainSnapshot> empty_snapshot =
+			std::make_shared<TerrainSnapshot>();
+
+	return empty_snapshot;
+}
+
+} //@namespace environment
+} //@namespace dwl
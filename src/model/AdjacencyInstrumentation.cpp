@@ -0,0 +1,201 @@
+#include <dwl/model/AdjacencyInstrumentation.h>
+#include <sstream>
+#include <cstdio>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/** @brief Names of the stages and counters in the JSON export */
+static const char* STAGE_NAMES[AdjacencyInstrumentation::NUM_STAGES] = {"adjacency_map",
+		"successors", "search_neighbors", "obstacle_check", "stance_cost", "feature_cost"};
+static const char* COUNTER_NAMES[AdjacencyInstrumentation::NUM_COUNTERS] = {"sampled_cells",
+		"field_hits", "cache_hits", "cache_misses", "rejected_primitives", "lazy_edges",
+		"evaluated_edges"};
+
+
+/**
+ * @brief Writes a string as a JSON string, i.e. quoted and with the quotes, backslashes and control
+ * characters escaped
+ * @param std::ostringstream& Output stream
+ * @param const std::string& String
+ */
+static void writeString(std::ostringstream& json,
+						const std::string& value)
+{
+	json << "\"";
+	for (std::size_t i = 0; i < value.size(); i++) {
+		char c = value[i];
+		if ((c == '"') || (c == '\\'))
+			json << '\\' << c;
+		else if (c == '\n')
+			json << "\\n";
+		else if (c == '\t')
+			json << "\\t";
+		else if ((unsigned char) c < 0x20) {
+			char code[8];
+			snprintf(code, sizeof(code), "\\u%04x", (unsigned int) c);
+			json << code;
+		} else
+			json << c;
+	}
+	json << "\"";
+}
+
+
+/**
+ * @brief Writes the statistics of a stage as a JSON object
+ * @param std::ostringstream& Output stream
+ * @param const StageStatistics& Statistics of the stage
+ */
+static void writeStage(std::ostringstream& json,
+					   const StageStatistics& statistics)
+{
+	// The trailing empty buckets are omitted
+	unsigned int num_buckets = StageStatistics::NUM_BUCKETS;
+	while ((num_buckets > 0) && (statistics.histogram[num_buckets - 1] == 0))
+		num_buckets--;
+
+	json << "{\"calls\": " << statistics.calls << ", \"sampled_calls\": "
+			<< statistics.sampled_calls << ", \"cycles\": " << statistics.cycles
+			<< ", \"histogram\": [";
+	for (unsigned int i = 0; i < num_buckets; i++)
+		json << (i > 0 ? ", " : "") << statistics.histogram[i];
+	json << "]}";
+}
+
+
+AdjacencyInstrumentation::AdjacencyInstrumentation() : sampling_mask_(63)
+{
+	reset();
+}
+
+
+AdjacencyInstrumentation::~AdjacencyInstrumentation()
+{
+
+}
+
+
+void AdjacencyInstrumentation::reset()
+{
+	for (unsigned int i = 0; i < NUM_COUNTERS; i++)
+		counters_[i] = 0;
+	for (unsigned int i = 0; i < NUM_STAGES; i++)
+		stages_[i] = StageStatistics();
+	features_.assign(features_.size(), StageStatistics());
+}
+
+
+void AdjacencyInstrumentation::merge(const AdjacencyInstrumentation& instrumentation)
+{
+	for (unsigned int i = 0; i < NUM_COUNTERS; i++)
+		counters_[i] += instrumentation.counters_[i];
+
+	if (features_.size() < instrumentation.features_.size())
+		features_.resize(instrumentation.features_.size());
+	for (unsigned int i = 0; i < NUM_STAGES + instrumentation.features_.size(); i++) {
+		StageStatistics& statistics = (i < NUM_STAGES) ? stages_[i] : features_[i - NUM_STAGES];
+		const StageStatistics& other = (i < NUM_STAGES) ?
+				instrumentation.stages_[i] : instrumentation.features_[i - NUM_STAGES];
+
+		statistics.calls += other.calls;
+		statistics.sampled_calls += other.sampled_calls;
+		statistics.cycles += other.cycles;
+		for (unsigned int j = 0; j < StageStatistics::NUM_BUCKETS; j++)
+			statistics.histogram[j] += other.histogram[j];
+	}
+}
+
+
+void AdjacencyInstrumentation::setFeatureName(unsigned int feature,
+											  std::string name)
+{
+	if (feature >= feature_names_.size())
+		feature_names_.resize(feature + 1);
+	if (feature >= features_.size())
+		features_.resize(feature + 1);
+
+	feature_names_[feature] = name;
+}
+
+
+void AdjacencyInstrumentation::setSamplingPeriod(unsigned int period)
+{
+	uint64_t rounded_period = 1;
+	while (rounded_period < period)
+		rounded_period <<= 1;
+
+	sampling_mask_ = rounded_period - 1;
+}
+
+
+unsigned int AdjacencyInstrumentation::getSamplingPeriod() const
+{
+	return sampling_mask_ + 1;
+}
+
+
+uint64_t AdjacencyInstrumentation::getCounter(Counter counter) const
+{
+	return counters_[counter];
+}
+
+
+const StageStatistics& AdjacencyInstrumentation::getStage(Stage stage) const
+{
+	return stages_[stage];
+}
+
+
+const std::vector<StageStatistics>& AdjacencyInstrumentation::getFeatures() const
+{
+	return features_;
+}
+
+
+std::string AdjacencyInstrumentation::toJson() const
+{
+	std::ostringstream json;
+	json << "{\"enabled\": " << (isEnabled() ? "true" : "false") << ", \"sampling_period\": "
+			<< getSamplingPeriod();
+
+	json << ", \"counters\": {";
+	for (unsigned int i = 0; i < NUM_COUNTERS; i++)
+		json << (i > 0 ? ", " : "") << "\"" << COUNTER_NAMES[i] << "\": " << counters_[i];
+
+	json << "}, \"stages\": {";
+	for (unsigned int i = 0; i < NUM_STAGES; i++) {
+		json << (i > 0 ? ", " : "") << "\"" << STAGE_NAMES[i] << "\": ";
+		writeStage(json, stages_[i]);
+	}
+
+	json << "}, \"features\": [";
+	for (std::size_t i = 0; i < features_.size(); i++) {
+		std::string name = (i < feature_names_.size()) ? feature_names_[i] : std::string();
+		json << (i > 0 ? ", " : "") << "{\"name\": ";
+		writeString(json, name);
+		json << ", \"statistics\": ";
+		writeStage(json, features_[i]);
+		json << "}";
+	}
+	json << "]}";
+
+	return json.str();
+}
+
+
+bool AdjacencyInstrumentation::isEnabled()
+{
+#ifdef DWL_ADJACENCY_INSTRUMENTATION
+	return true;
+#else
+	return false;
+#endif
+}
+
+} //@namespace model
+} //@namespace dwl
@@ -0,0 +1,200 @@
+#include <dwl/model/BodyCostCache.h>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+BodyCostCache::BodyCostCache(std::size_t capacity) : num_buckets_(0), version_(1)
+{
+	setCapacity(capacity);
+}
+
+
+BodyCostCache::~BodyCostCache()
+{
+
+}
+
+
+void BodyCostCache::setCapacity(std::size_t capacity)
+{
+	num_buckets_ = capacity / (NUM_SHARDS * BUCKET_SIZE);
+	if (num_buckets_ == 0)
+		num_buckets_ = 1;
+
+	Entry empty_entry;
+	empty_entry.key = 0;
+	empty_entry.cost = 0;
+	empty_entry.unknown_cost = 0;
+	empty_entry.version = 0;
+	empty_entry.tick = 0;
+	empty_entry.is_unknown_cost = false;
+	for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+		std::lock_guard<std::mutex> lock(shards_[i].mutex);
+		shards_[i].entries.assign(num_buckets_ * BUCKET_SIZE, empty_entry);
+		shards_[i].tick = 0;
+	}
+}
+
+
+uint64_t BodyCostCache::getKey(int key_x,
+							   int key_y,
+							   unsigned short int key_yaw,
+							   int pattern)
+{
+	return (uint64_t) (key_x & 0xffff) | ((uint64_t) (key_y & 0xffff) << 16) |
+			((uint64_t) key_yaw << 32) | ((uint64_t) (pattern & 0xff) << 48);
+}
+
+
+bool BodyCostCache::find(double& cost,
+						 uint64_t key,
+						 double unknown_cost)
+{
+	bool is_unknown_cost;
+	return find(cost, is_unknown_cost, key, unknown_cost);
+}
+
+
+bool BodyCostCache::find(double& cost,
+						 bool& is_unknown_cost,
+						 uint64_t key,
+						 double unknown_cost)
+{
+	Shard* shard;
+	std::size_t bucket = getBucket(shard, key);
+	unsigned int version = version_.load(std::memory_order_acquire);
+
+	std::lock_guard<std::mutex> lock(shard->mutex);
+	for (unsigned int i = 0; i < BUCKET_SIZE; i++) {
+		Entry& entry = shard->entries[bucket + i];
+		if ((entry.version != version) || (entry.key != key))
+			continue;
+
+		// The cost of the unknown feet depends on the average cost of the terrain
+		if (entry.is_unknown_cost && (entry.unknown_cost != unknown_cost))
+			break;
+
+		entry.tick = ++shard->tick;
+		cost = entry.cost;
+		is_unknown_cost = entry.is_unknown_cost;
+		shard->statistics.hits++;
+		return true;
+	}
+
+	shard->statistics.misses++;
+	return false;
+}
+
+
+void BodyCostCache::insert(uint64_t key,
+						   double cost,
+						   bool is_unknown_cost,
+						   double unknown_cost)
+{
+	Shard* shard;
+	std::size_t bucket = getBucket(shard, key);
+	unsigned int version = version_.load(std::memory_order_acquire);
+
+	std::lock_guard<std::mutex> lock(shard->mutex);
+
+	// Looking for the same key or an invalid entry, otherwise the least recently used entry is
+	// evicted
+	Entry* replaced_entry = NULL;
+	for (unsigned int i = 0; i < BUCKET_SIZE; i++) {
+		Entry& entry = shard->entries[bucket + i];
+		if ((entry.version != version) || (entry.key == key)) {
+			replaced_entry = &entry;
+			break;
+		}
+
+		if ((replaced_entry == NULL) || (entry.tick < replaced_entry->tick))
+			replaced_entry = &entry;
+	}
+
+	if ((replaced_entry->version == version) && (replaced_entry->key != key))
+		shard->statistics.evictions++;
+
+	replaced_entry->key = key;
+	replaced_entry->cost = cost;
+	replaced_entry->unknown_cost = unknown_cost;
+	replaced_entry->version = version;
+	replaced_entry->tick = ++shard->tick;
+	replaced_entry->is_unknown_cost = is_unknown_cost;
+}
+
+
+void BodyCostCache::invalidate(int min_key_x,
+							   int min_key_y,
+							   int max_key_x,
+							   int max_key_y)
+{
+	if ((max_key_x < min_key_x) || (max_key_y < min_key_y))
+		return;
+
+	for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+		std::lock_guard<std::mutex> lock(shards_[i].mutex);
+
+		std::vector<Entry>& entries = shards_[i].entries;
+		for (std::size_t k = 0; k < entries.size(); k++) {
+			int key_x = entries[k].key & 0xffff;
+			int key_y = (entries[k].key >> 16) & 0xffff;
+			if ((key_x >= min_key_x) && (key_x <= max_key_x) &&
+					(key_y >= min_key_y) && (key_y <= max_key_y))
+				entries[k].version = 0;
+		}
+	}
+}
+
+
+void BodyCostCache::invalidateAll()
+{
+	// The version zero is reserved for the empty entries
+	unsigned int version = version_.load() + 1;
+	if (version == 0)
+		version = 1;
+	version_.store(version, std::memory_order_release);
+}
+
+
+BodyCostCacheStatistics BodyCostCache::getStatistics()
+{
+	BodyCostCacheStatistics statistics;
+	for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+		std::lock_guard<std::mutex> lock(shards_[i].mutex);
+		statistics.hits += shards_[i].statistics.hits;
+		statistics.misses += shards_[i].statistics.misses;
+		statistics.evictions += shards_[i].statistics.evictions;
+	}
+
+	return statistics;
+}
+
+
+void BodyCostCache::resetStatistics()
+{
+	for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+		std::lock_guard<std::mutex> lock(shards_[i].mutex);
+		shards_[i].statistics = BodyCostCacheStatistics();
+	}
+}
+
+
+std::size_t BodyCostCache::getBucket(Shard*& shard,
+									 uint64_t key)
+{
+	// Mixing the bits of the key (splitmix64 finalizer)
+	uint64_t hash = key;
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+	hash = hash ^ (hash >> 31);
+
+	shard = &shards_[hash % NUM_SHARDS];
+	return ((hash / NUM_SHARDS) % num_buckets_) * BUCKET_SIZE;
+}
+
+} //@namespace model
+} //@namespace dwl
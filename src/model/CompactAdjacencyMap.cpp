@@ -0,0 +1,168 @@
+#include <dwl/model/CompactAdjacencyMap.h>
+#include <limits>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+CompactAdjacencyMap::CompactAdjacencyMap() : offsets_(1, 0)
+{
+
+}
+
+
+CompactAdjacencyMap::~CompactAdjacencyMap()
+{
+
+}
+
+
+void CompactAdjacencyMap::clear()
+{
+	vertices_.clear();
+	offsets_.assign(1, 0);
+	targets_.clear();
+	weights_.clear();
+}
+
+
+void CompactAdjacencyMap::build(
+		const std::vector<const std::vector<std::pair<Vertex, Edge> >*>& edge_lists)
+{
+	// Getting the sorted source and target vertices
+	vertices_.clear();
+	std::size_t num_edges = 0;
+	for (std::size_t l = 0; l < edge_lists.size(); l++) {
+		const std::vector<std::pair<Vertex, Edge> >& edges = *edge_lists[l];
+		for (std::size_t i = 0; i < edges.size(); i++) {
+			vertices_.push_back(edges[i].first);
+			vertices_.push_back(edges[i].second.target);
+		}
+		num_edges += edges.size();
+	}
+	if (!buildVertexTable(num_edges))
+		return;
+
+	// Counting the edges of every row
+	offsets_.assign(vertices_.size() + 1, 0);
+	for (std::size_t l = 0; l < edge_lists.size(); l++) {
+		const std::vector<std::pair<Vertex, Edge> >& edges = *edge_lists[l];
+		for (std::size_t i = 0; i < edges.size(); i++)
+			offsets_[getRow(edges[i].first) + 1]++;
+	}
+	for (std::size_t row = 0; row < vertices_.size(); row++)
+		offsets_[row + 1] += offsets_[row];
+
+	// Filling the rows in the order of the lists
+	targets_.resize(num_edges);
+	weights_.resize(num_edges);
+	std::vector<uint32_t> next(offsets_.begin(), offsets_.end() - 1);
+	for (std::size_t l = 0; l < edge_lists.size(); l++) {
+		const std::vector<std::pair<Vertex, Edge> >& edges = *edge_lists[l];
+		for (std::size_t i = 0; i < edges.size(); i++) {
+			uint32_t index = next[getRow(edges[i].first)]++;
+			targets_[index] = getRow(edges[i].second.target);
+			weights_[index] = edges[i].second.weight;
+		}
+	}
+}
+
+
+void CompactAdjacencyMap::build(const AdjacencyMap& adjacency_map)
+{
+	// Getting the sorted source and target vertices
+	vertices_.clear();
+	std::size_t num_edges = 0;
+	for (AdjacencyMap::const_iterator vertex_iter = adjacency_map.begin();
+			vertex_iter != adjacency_map.end(); vertex_iter++) {
+		const std::vector<Edge>& edges = vertex_iter->second;
+		if (!edges.empty())
+			vertices_.push_back(vertex_iter->first);
+		for (std::size_t i = 0; i < edges.size(); i++)
+			vertices_.push_back(edges[i].target);
+		num_edges += edges.size();
+	}
+	if (!buildVertexTable(num_edges))
+		return;
+
+	// Filling the rows, the adjacency map is already sorted by source vertex
+	offsets_.assign(vertices_.size() + 1, 0);
+	targets_.resize(num_edges);
+	weights_.resize(num_edges);
+	std::size_t row = 0, index = 0;
+	for (AdjacencyMap::const_iterator vertex_iter = adjacency_map.begin();
+			vertex_iter != adjacency_map.end(); vertex_iter++) {
+		const std::vector<Edge>& edges = vertex_iter->second;
+		if (edges.empty())
+			continue;
+
+		for (; vertices_[row] != vertex_iter->first; row++)
+			offsets_[row + 1] = index;
+		for (std::size_t i = 0; i < edges.size(); i++, index++) {
+			targets_[index] = getRow(edges[i].target);
+			weights_[index] = edges[i].weight;
+		}
+		offsets_[++row] = index;
+	}
+	for (; row < vertices_.size(); row++)
+		offsets_[row + 1] = index;
+}
+
+
+void CompactAdjacencyMap::toAdjacencyMap(AdjacencyMap& adjacency_map) const
+{
+	adjacency_map.clear();
+	for (std::size_t row = 0; row < vertices_.size(); row++) {
+		if (offsets_[row + 1] == offsets_[row])
+			continue;
+
+		std::vector<Edge>& edges = adjacency_map[vertices_[row]];
+		edges.reserve(offsets_[row + 1] - offsets_[row]);
+		for (uint32_t i = offsets_[row]; i < offsets_[row + 1]; i++)
+			edges.push_back(Edge(vertices_[targets_[i]], weights_[i]));
+	}
+}
+
+
+void CompactAdjacencyMap::getEdges(std::vector<Edge>& edges,
+								   Vertex vertex) const
+{
+	edges.clear();
+	int row = getRow(vertex);
+	if (row < 0)
+		return;
+
+	for (uint32_t i = offsets_[row]; i < offsets_[row + 1]; i++)
+		edges.push_back(Edge(vertices_[targets_[i]], weights_[i]));
+}
+
+
+bool CompactAdjacencyMap::buildVertexTable(std::size_t num_edges)
+{
+	std::sort(vertices_.begin(), vertices_.end());
+	vertices_.erase(std::unique(vertices_.begin(), vertices_.end()), vertices_.end());
+	std::vector<Vertex>(vertices_).swap(vertices_);
+
+	if ((vertices_.size() > std::numeric_limits<uint32_t>::max()) ||
+			(num_edges > std::numeric_limits<uint32_t>::max())) {
+		printf(RED "Could not build the compact adjacency map because it has more than 2^32"
+				" vertices or edges\n" COLOR_RESET);
+		clear();
+		return false;
+	}
+
+	return true;
+}
+
+
+std::size_t CompactAdjacencyMap::getMemoryUsage() const
+{
+	return vertices_.capacity() * sizeof(Vertex) + offsets_.capacity() * sizeof(uint32_t) +
+			targets_.capacity() * sizeof(uint32_t) + weights_.capacity() * sizeof(float);
+}
+
+} //@namespace model
+} //@namespace dwl
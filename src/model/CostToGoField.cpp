@@ -0,0 +1,421 @@
+#include <dwl/model/CostToGoField.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/** @brief Minimum number of frontier vertices per thread for relaxing the frontier concurrently */
+static const std::size_t MIN_VERTICES_PER_THREAD = 512;
+
+/** @brief Maximum number of cyclic buckets, it bounds the width of the buckets */
+static const double MAX_NUM_BUCKETS = 1024;
+
+
+/**
+ * @brief Converts a non-negative cost to its bits. The bits of the non-negative doubles have the
+ * same order than the doubles, so the atomic minimum is computed over the integers
+ */
+static inline uint64_t costToBits(double cost)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &cost, sizeof(bits));
+	return bits;
+}
+
+
+/** @brief Converts the bits of a non-negative cost to the cost */
+static inline double bitsToCost(uint64_t bits)
+{
+	double cost;
+	std::memcpy(&cost, &bits, sizeof(cost));
+	return cost;
+}
+
+
+/**
+ * @brief Workers that run the concurrent rounds of a computation of the field. The threads are
+ * created once and live until the workers are destroyed, and every round is dispatched to them
+ * with a condition variable. The calling thread runs the first task of every round
+ */
+class RelaxationWorkers
+{
+	public:
+		/**
+		 * @brief Constructor function
+		 * @param unsigned int Number of threads, including the calling thread
+		 * @param const std::function<void(unsigned int, unsigned int)>& Task of a round, it
+		 * receives the index of the task and the number of tasks of the round
+		 */
+		RelaxationWorkers(unsigned int num_threads,
+						  const std::function<void(unsigned int, unsigned int)>& task) :
+				task_(task), round_(0), num_tasks_(0), num_pending_(0), is_stopped_(false)
+		{
+			for (unsigned int i = 1; i < num_threads; i++)
+				threads_.push_back(std::thread(&RelaxationWorkers::work, this, i));
+		}
+
+		/** @brief Destructor function */
+		~RelaxationWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				is_stopped_ = true;
+			}
+			start_condition_.notify_all();
+			for (std::size_t i = 0; i < threads_.size(); i++)
+				threads_[i].join();
+		}
+
+		/**
+		 * @brief Runs a round and waits until all its tasks finished
+		 * @param unsigned int Number of tasks, at most the number of threads
+		 */
+		void run(unsigned int num_tasks)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				num_tasks_ = num_tasks;
+				num_pending_ = num_tasks - 1;
+				round_++;
+			}
+			start_condition_.notify_all();
+			task_(0, num_tasks);
+
+			std::unique_lock<std::mutex> lock(mutex_);
+			done_condition_.wait(lock, [this]() { return num_pending_ == 0; });
+		}
+
+
+	private:
+		/** @brief Runs the tasks of a thread until the workers are destroyed */
+		void work(unsigned int task)
+		{
+			uint64_t round = 0;
+			while (true) {
+				unsigned int num_tasks;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					start_condition_.wait(lock, [this, round]() {
+						return is_stopped_ || (round_ != round); });
+					if (is_stopped_)
+						return;
+					round = round_;
+					num_tasks = num_tasks_;
+				}
+
+				if (task < num_tasks) {
+					task_(task, num_tasks);
+					std::lock_guard<std::mutex> lock(mutex_);
+					if (--num_pending_ == 0)
+						done_condition_.notify_one();
+				}
+			}
+		}
+
+		/** @brief Task of a round */
+		std::function<void(unsigned int, unsigned int)> task_;
+
+		/** @brief Threads of the workers */
+		std::vector<std::thread> threads_;
+
+		/** @brief Synchronization of the rounds */
+		std::mutex mutex_;
+		std::condition_variable start_condition_, done_condition_;
+
+		/** @brief Current round, number of tasks of the round and number of unfinished tasks */
+		uint64_t round_;
+		unsigned int num_tasks_, num_pending_;
+
+		/** @brief Indicates if the workers were destroyed */
+		bool is_stopped_;
+};
+
+
+/** @brief Gets the key of the terrain cell of a state vertex */
+static inline void getCellKey(Key& key,
+							  Vertex state_vertex,
+							  environment::TerrainMap* terrain)
+{
+	Vertex terrain_vertex;
+	terrain->getTerrainSpaceModel().stateVertexToEnvironmentVertex(terrain_vertex,
+			state_vertex, XY_Y);
+	terrain->getTerrainSpaceModel().vertexToKey(key, terrain_vertex, true);
+}
+
+
+CostToGoField::CostToGoField() : terrain_(NULL), min_key_x_(0), min_key_y_(0), size_x_(0),
+		size_y_(0), goal_(0), num_threads_(1), bucket_width_(0), is_computed_(false)
+{
+
+}
+
+
+CostToGoField::~CostToGoField()
+{
+
+}
+
+
+bool CostToGoField::compute(const AdjacencyMap& adjacency_map,
+							Vertex goal,
+							environment::TerrainMap* terrain)
+{
+	terrain_ = terrain;
+	goal_ = goal;
+	is_computed_ = false;
+
+	// Getting the cells of the edges and their bounding box. The vertices of the map are merged by
+	// terrain cell, so the start and goal vertices share the cell of the closest grid vertex
+	std::vector<Key> source_keys, target_keys;
+	std::vector<double> weights;
+	Key goal_key;
+	getCellKey(goal_key, goal, terrain_);
+	bool is_goal_vertex = false;
+	int min_x = std::numeric_limits<int>::max(), min_y = std::numeric_limits<int>::max();
+	int max_x = std::numeric_limits<int>::min(), max_y = std::numeric_limits<int>::min();
+	for (AdjacencyMap::const_iterator vertex_iter = adjacency_map.begin();
+			vertex_iter != adjacency_map.end(); vertex_iter++) {
+		Key source_key;
+		getCellKey(source_key, vertex_iter->first, terrain_);
+		min_x = std::min(min_x, (int) source_key.x);
+		min_y = std::min(min_y, (int) source_key.y);
+		max_x = std::max(max_x, (int) source_key.x);
+		max_y = std::max(max_y, (int) source_key.y);
+
+		const std::vector<Edge>& edges = vertex_iter->second;
+		for (std::size_t i = 0; i < edges.size(); i++) {
+			Key target_key;
+			getCellKey(target_key, edges[i].target, terrain_);
+			min_x = std::min(min_x, (int) target_key.x);
+			min_y = std::min(min_y, (int) target_key.y);
+			max_x = std::max(max_x, (int) target_key.x);
+			max_y = std::max(max_y, (int) target_key.y);
+
+			source_keys.push_back(source_key);
+			target_keys.push_back(target_key);
+			weights.push_back(edges[i].weight);
+			if ((target_key.x == goal_key.x) && (target_key.y == goal_key.y))
+				is_goal_vertex = true;
+		}
+	}
+
+	if (!is_goal_vertex) {
+		printf(RED "Could not compute the cost-to-go field because the goal isn't a vertex of the"
+				" adjacency map\n" COLOR_RESET);
+		min_key_x_ = min_key_y_ = size_x_ = size_y_ = 0;
+		cost_.clear();
+		return false;
+	}
+
+	min_key_x_ = min_x;
+	min_key_y_ = min_y;
+	size_x_ = max_x - min_x + 1;
+	size_y_ = max_y - min_y + 1;
+	std::size_t num_cells = (std::size_t) size_x_ * size_y_;
+
+	// Building the reverse graph, i.e. the incoming edges of every cell, with a counting sort by
+	// target cell
+	std::size_t num_edges = weights.size();
+	std::vector<unsigned int> targets(num_edges);
+	offsets_.assign(num_cells + 1, 0);
+	for (std::size_t i = 0; i < num_edges; i++) {
+		targets[i] = (target_keys[i].y - min_key_y_) * size_x_ + (target_keys[i].x - min_key_x_);
+		offsets_[targets[i] + 1]++;
+	}
+	for (std::size_t i = 0; i < num_cells; i++)
+		offsets_[i + 1] += offsets_[i];
+
+	std::vector<unsigned int> next_edge(offsets_.begin(), offsets_.end() - 1);
+	sources_.resize(num_edges);
+	weights_.resize(num_edges);
+	double total_weight = 0, max_weight = 0;
+	for (std::size_t i = 0; i < num_edges; i++) {
+		unsigned int edge = next_edge[targets[i]]++;
+		sources_[edge] = (source_keys[i].y - min_key_y_) * size_x_ + (source_keys[i].x - min_key_x_);
+		weights_[edge] = std::max(weights[i], 0.);
+		total_weight += weights_[edge];
+		max_weight = std::max(max_weight, weights_[edge]);
+	}
+
+	// Getting the width of the buckets, the average weight settles roughly one edge per bucket. The
+	// width is bounded by the largest weight, so a tiny width (e.g. the average of mostly zero
+	// weights) doesn't require a huge number of buckets
+	double bucket_width = bucket_width_;
+	if (bucket_width <= 0)
+		bucket_width = total_weight / num_edges;
+	bucket_width = std::max(bucket_width, max_weight / MAX_NUM_BUCKETS);
+	if (bucket_width <= 0)
+		bucket_width = 1;
+
+	// The pending costs are between the cost of the current bucket and that cost plus the largest
+	// weight, so the buckets are reused cyclically. The extra bucket absorbs the rounding of the
+	// bucket of a cost
+	std::size_t num_buckets = (std::size_t) std::ceil(max_weight / bucket_width) + 2;
+
+	// Running the delta-stepping from the goal. The costs are atomic bits of non-negative doubles,
+	// so the concurrent relaxations keep the minimum cost without locks
+	std::vector<std::atomic<uint64_t> > costs(num_cells);
+	uint64_t infinity = costToBits(std::numeric_limits<double>::max());
+	for (std::size_t i = 0; i < num_cells; i++)
+		costs[i].store(infinity, std::memory_order_relaxed);
+
+	unsigned int goal_cell = (goal_key.y - min_key_y_) * size_x_ + (goal_key.x - min_key_x_);
+	costs[goal_cell].store(costToBits(0.), std::memory_order_relaxed);
+
+	std::vector<std::vector<unsigned int> > buckets(num_buckets);
+	buckets[0].push_back(goal_cell);
+	std::size_t num_pending = 1;
+	std::vector<std::vector<unsigned int> > relaxed(num_threads_);
+	std::vector<unsigned int> frontier, next_frontier;
+	std::vector<unsigned int> frontier_phase(num_cells, 0);
+	unsigned int phase = 0;
+
+	// Creating the workers once for the whole computation, every round relaxes a range of the
+	// frontier per thread
+	std::unique_ptr<RelaxationWorkers> workers;
+	if (num_threads_ > 1)
+		workers.reset(new RelaxationWorkers(num_threads_,
+				[this, &costs, &frontier, &relaxed](unsigned int task, unsigned int num_tasks) {
+			relaxVertices(costs.data(), frontier, frontier.size() * task / num_tasks,
+					frontier.size() * (task + 1) / num_tasks, relaxed[task]);
+		}));
+
+	for (std::size_t bucket = 0; num_pending > 0; bucket++) {
+		// Gathering the vertices whose cost is still in the bucket, the others were moved to a
+		// previous bucket after they were inserted. The pending cells are at most one cycle ahead,
+		// so a run of empty buckets is shorter than the number of buckets
+		std::vector<unsigned int>& bucket_cells = buckets[bucket % num_buckets];
+		if (bucket_cells.empty())
+			continue;
+
+		phase++;
+		frontier.clear();
+		num_pending -= bucket_cells.size();
+		for (std::size_t i = 0; i < bucket_cells.size(); i++) {
+			unsigned int cell = bucket_cells[i];
+			double cost = bitsToCost(costs[cell].load(std::memory_order_relaxed));
+			if (((std::size_t) (cost / bucket_width) == bucket) && (frontier_phase[cell] != phase)) {
+				frontier_phase[cell] = phase;
+				frontier.push_back(cell);
+			}
+		}
+		bucket_cells.clear();
+
+		// Relaxing the bucket until its costs don't change, the vertices whose cost decreases
+		// inside the bucket are relaxed again
+		while (!frontier.empty()) {
+			unsigned int num_threads = std::max(std::min((std::size_t) num_threads_,
+					frontier.size() / MIN_VERTICES_PER_THREAD), (std::size_t) 1);
+			if (num_threads == 1)
+				relaxVertices(costs.data(), frontier, 0, frontier.size(), relaxed[0]);
+			else
+				workers->run(num_threads);
+
+			phase++;
+			next_frontier.clear();
+			for (unsigned int i = 0; i < num_threads; i++) {
+				for (std::size_t j = 0; j < relaxed[i].size(); j++) {
+					unsigned int cell = relaxed[i][j];
+					double cost = bitsToCost(costs[cell].load(std::memory_order_relaxed));
+					std::size_t cell_bucket = (std::size_t) (cost / bucket_width);
+					if (cell_bucket == bucket) {
+						if (frontier_phase[cell] != phase) {
+							frontier_phase[cell] = phase;
+							next_frontier.push_back(cell);
+						}
+					} else {
+						buckets[cell_bucket % num_buckets].push_back(cell);
+						num_pending++;
+					}
+				}
+				relaxed[i].clear();
+			}
+			frontier.swap(next_frontier);
+		}
+	}
+
+	cost_.resize(num_cells);
+	for (std::size_t i = 0; i < num_cells; i++)
+		cost_[i] = bitsToCost(costs[i].load(std::memory_order_relaxed));
+
+	is_computed_ = true;
+	return true;
+}
+
+
+void CostToGoField::setNumberOfThreads(unsigned int num_threads)
+{
+	if (num_threads == 0)
+		num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	num_threads_ = num_threads;
+}
+
+
+void CostToGoField::setBucketWidth(double bucket_width)
+{
+	bucket_width_ = bucket_width;
+}
+
+
+bool CostToGoField::getCost(double& cost,
+							Vertex state_vertex) const
+{
+	if (!is_computed_)
+		return false;
+
+	Key key;
+	getCellKey(key, state_vertex, terrain_);
+	return getCost(cost, key.x, key.y);
+}
+
+
+bool CostToGoField::isComputed() const
+{
+	return is_computed_;
+}
+
+
+Vertex CostToGoField::getGoal() const
+{
+	return goal_;
+}
+
+
+void CostToGoField::relaxVertices(std::atomic<uint64_t>* costs,
+								  const std::vector<unsigned int>& frontier,
+								  std::size_t first,
+								  std::size_t end,
+								  std::vector<unsigned int>& relaxed) const
+{
+	for (std::size_t i = first; i < end; i++) {
+		unsigned int cell = frontier[i];
+		double cost = bitsToCost(costs[cell].load(std::memory_order_relaxed));
+		for (unsigned int edge = offsets_[cell]; edge < offsets_[cell + 1]; edge++) {
+			unsigned int source = sources_[edge];
+			uint64_t new_cost = costToBits(cost + weights_[edge]);
+			uint64_t old_cost = costs[source].load(std::memory_order_relaxed);
+			while (new_cost < old_cost) {
+				if (costs[source].compare_exchange_weak(old_cost, new_cost,
+						std::memory_order_relaxed)) {
+					relaxed.push_back(source);
+					break;
+				}
+			}
+		}
+	}
+}
+
+} //@namespace model
+} //@namespace dwl
@@ -1,4 +1,7 @@
 #include <dwl/model/GridBasedBodyAdjacency.h>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 
 
 namespace dwl
@@ -8,18 +11,24 @@ namespace model
 {
 
 GridBasedBodyAdjacency::GridBasedBodyAdjacency() : robot_(NULL),
-		terrain_(NULL), is_stance_adjacency_(true),
-		neighboring_definition_(3), number_top_cost_(5),
-		uncertainty_factor_(1.15)
+		terrain_(NULL), terrain_view_(NULL), is_stance_adjacency_(true),
+		neighboring_definition_(3), stance_pattern_(-1), number_top_cost_(5),
+		uncertainty_factor_(1.15), num_threads_(1), num_chunks_(0), adjacency_key_yaw_(-1),
+		adjacency_average_cost_(0), adjacency_source_(0), adjacency_target_(0),
+		adjacency_closest_source_(0), adjacency_closest_target_(0)
 {
 	name_ = "Grid-based Body";
 	is_lattice_ = false;
+	neighbor_stencil_.reset(8, neighboring_definition_);
 }
 
 
 GridBasedBodyAdjacency::~GridBasedBodyAdjacency()
 {
-
+	for (std::size_t i = 0; i < feature_adapters_.size(); i++)
+		delete feature_adapters_[i];
+	for (std::size_t i = 0; i < thread_arenas_.size(); i++)
+		delete thread_arenas_[i];
 }
 
 
@@ -33,6 +42,12 @@ void GridBasedBodyAdjacency::reset(robot::Robot* robot,
 	printf(BLUE "Setting the environment information in the %s adjacency model"
 			" \n" COLOR_RESET, name_.c_str());
 	terrain_ = environment;
+	snapshot_reader_.clear();
+	updateTerrainView(true);
+	stance_stencils_.reset(terrain_->getResolution(true));
+	stance_pattern_ = -1;
+	stance_cost_fields_.clear();
+	adjacency_key_yaw_ = -1;
 
 	for (int i = 0; i < (int) features_.size(); i++)
 		features_[i]->reset(robot);
@@ -43,81 +58,387 @@ void GridBasedBodyAdjacency::computeAdjacencyMap(AdjacencyMap& adjacency_map,
 												 Vertex source,
 												 Vertex target)
 {
-	// Computing a default stance areas
-	Eigen::Vector3d full_action = Eigen::Vector3d::Zero();
-	stance_areas_ = robot_->getFootstepSearchAreas(full_action);
+	if (!computeAdjacencyEdges(source, target))
+		return;
 
-	// Getting the body orientation
-	Eigen::Vector3d initial_state;
-	terrain_->getTerrainSpaceModel().vertexToState(initial_state, source);
-	unsigned short int key_yaw;
-	terrain_->getTerrainSpaceModel().stateToKey(key_yaw, (double) initial_state(2), false);
+	// Merging the edges in order
+	for (std::size_t i = 0; i < snapping_edges_.size(); i++)
+		adjacency_map[snapping_edges_[i].first].push_back(snapping_edges_[i].second);
+	for (unsigned int chunk = 0; chunk < num_chunks_; chunk++) {
+		std::vector<std::pair<Vertex, Edge> >& edges = chunk_edges_[chunk];
+		for (std::size_t i = 0; i < edges.size(); i++)
+			adjacency_map[edges[i].first].push_back(edges[i].second);
+	}
+}
+
+
+void GridBasedBodyAdjacency::computeAdjacencyMap(CompactAdjacencyMap& adjacency_map,
+												 Vertex source,
+												 Vertex target)
+{
+	adjacency_map.clear();
+	if (!computeAdjacencyEdges(source, target))
+		return;
+
+	// Packing the edges in order
+	std::vector<const std::vector<std::pair<Vertex, Edge> >*> edge_lists;
+	edge_lists.push_back(&snapping_edges_);
+	for (unsigned int chunk = 0; chunk < num_chunks_; chunk++)
+		edge_lists.push_back(&chunk_edges_[chunk]);
+	adjacency_map.build(edge_lists);
+}
+
+
+void GridBasedBodyAdjacency::updateAdjacencyMap(AdjacencyMap& adjacency_map,
+												const std::vector<Vertex>& changed_cells,
+												std::vector<EdgeChange>& changed_edges)
+{
+	updateAdjacencyEdges(adjacency_map, changed_cells, changed_edges);
+
+	// Releasing the temporaries of the update at once
+	arena_.reset();
+}
+
+
+void GridBasedBodyAdjacency::updateAdjacencyEdges(AdjacencyMap& adjacency_map,
+												  const std::vector<Vertex>& changed_cells,
+												  std::vector<EdgeChange>& changed_edges)
+{
+	changed_edges.clear();
+	if (adjacency_key_yaw_ < 0) {
+		printf(RED "Could not update the adjacency map because it was not computed before"
+				" \n" COLOR_RESET);
+		return;
+	}
+
+	// Getting the body orientation of the adjacency map
+	unsigned short int key_yaw = adjacency_key_yaw_;
 	double yaw;
 	terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
 
-	if (terrain_->isTerrainInformation()) {
-		// Adding the source and target vertex if it is outside the information terrain
-		Vertex closest_source, closest_target;
-		getTheClosestStartAndGoalVertex(closest_source, closest_target, source, target);
-		if (closest_source != source) {
-			adjacency_map[source].push_back(Edge(closest_source, 0));
+	// Updating the dense view of the terrain
+	updateTerrainView(true);
+
+	// Getting the radius of the states affected by a changed cell. The cost of a state depends on
+	// the cells inside its stance stencil, and its neighbors on the cells inside the neighboring
+	// area
+	int radius = neighbor_stencil_.getReach();
+	if (isStanceAdjacency()) {
+		getStanceStencil(key_yaw);
+		radius = std::max(radius, stance_stencils_.getReach());
+	}
+
+	// The cost of a body feature depends on the terrain inside its footprint, a feature without a
+	// footprint radius could depend on any cell
+	bool is_whole_terrain = false;
+	double resolution = terrain_->getResolution(true);
+	for (std::size_t i = 0; i < features_.size(); i++) {
+		double footprint_radius = features_[i]->getFootprintRadius();
+		if (footprint_radius < 0)
+			is_whole_terrain = true;
+		else
+			radius = std::max(radius, (int) std::ceil(footprint_radius / resolution));
+	}
+
+	// Collecting the cells of the affected states
+	ArenaVector<uint32_t> affected_cells(arena_);
+	if (is_whole_terrain) {
+		int min_x, min_y, size_x, size_y;
+		terrain_view_->getBounds(min_x, min_y, size_x, size_y);
+		for (int y = min_y; y < min_y + size_y; y++) {
+			for (int x = min_x; x < min_x + size_x; x++)
+				affected_cells.push_back((uint32_t) y << 16 | x);
 		}
-		if (closest_target != target) {
-			adjacency_map[closest_target].push_back(Edge(target, 0));
+	}
+	for (std::size_t i = 0; i < changed_cells.size(); i++) {
+		Key key;
+		terrain_->getTerrainSpaceModel().vertexToKey(key, changed_cells[i], true);
+		for (int y = std::max(key.y - radius, 0); y <= std::min(key.y + radius, 0xffff); y++) {
+			for (int x = std::max(key.x - radius, 0); x <= std::min(key.x + radius, 0xffff); x++)
+				affected_cells.push_back((uint32_t) y << 16 | x);
 		}
+	}
 
-		// Computing the adjacency map given the terrain information
-		TerrainDataMap terrain_map = terrain_->getTerrainDataMap();
-		for (TerrainDataMap::iterator vertex_iter = terrain_map.begin();
-				vertex_iter != terrain_map.end();
-				vertex_iter++)
+	// The states with unknown feet depend on the average cost of the terrain
+	if (isStanceAdjacency() && (terrain_view_->getAverageCost() != adjacency_average_cost_))
+		affected_cells.insert(affected_cells.end(),
+				unknown_cost_cells_.begin(), unknown_cost_cells_.end());
+
+	std::sort(affected_cells.begin(), affected_cells.end());
+	affected_cells.erase(std::unique(affected_cells.begin(), affected_cells.end()),
+			affected_cells.end());
+
+	// Getting the previous incoming edges of the affected states from the adjacency map. These
+	// edges come from the states along the neighboring directions
+	const std::vector<NeighborOffset>& offsets = neighbor_stencil_.getOffsets();
+	ArenaVector<EdgeChange> previous_edges(arena_), current_edges(arena_);
+	for (std::size_t i = 0; i < affected_cells.size(); i++) {
+		Key key;
+		key.x = affected_cells[i] & 0xffff;
+		key.y = affected_cells[i] >> 16;
+		Vertex state_vertex;
+		getStateVertex(state_vertex, key, yaw);
+
+		for (std::size_t j = 0; j < offsets.size(); j++) {
+			int x = key.x + offsets[j].dx;
+			int y = key.y + offsets[j].dy;
+			if ((x < 0) || (x > 0xffff) || (y < 0) || (y > 0xffff))
+				continue;
+
+			Key neighbor_key;
+			neighbor_key.x = x;
+			neighbor_key.y = y;
+			Vertex neighbor_vertex;
+			getStateVertex(neighbor_vertex, neighbor_key, yaw);
+
+			AdjacencyMap::iterator edges_iter = adjacency_map.find(neighbor_vertex);
+			if (edges_iter == adjacency_map.end())
+				continue;
+
+			for (std::size_t k = 0; k < edges_iter->second.size(); k++) {
+				if (edges_iter->second[k].target == state_vertex) {
+					previous_edges.push_back(EdgeChange(neighbor_vertex, state_vertex,
+							edges_iter->second[k].weight, std::numeric_limits<Weight>::max()));
+					break;
+				}
+			}
+		}
+	}
+
+	// Computing the body cost of the affected states
+	ArenaVector<uint32_t> unknown_cost_cells(arena_);
+	ArenaVector<Vertex> state_vertices(arena_);
+	ArenaVector<double> costs(arena_);
+	std::vector<environment::FeatureState>& feature_states = feature_state_buffer_;
+	feature_states.clear();
+	for (std::size_t i = 0; i < affected_cells.size(); i++) {
+		Key key;
+		key.x = affected_cells[i] & 0xffff;
+		key.y = affected_cells[i] >> 16;
+		if (!terrain_view_->isValid(key))
+			continue;
+
+		Vertex state_vertex;
+		getStateVertex(state_vertex, key, yaw);
+
+		double cost = 0;
+		if (!isStanceAdjacency())
+			terrain_view_->getCost(cost, key.x, key.y);
+		else {
+			bool is_unknown_cost;
+			computeStanceCost(cost, is_unknown_cost, state_vertex, stance_cost_kernel_,
+					instrumentation_);
+			if (is_unknown_cost)
+				unknown_cost_cells.push_back(affected_cells[i]);
+
+			if (!features_.empty()) {
+				feature_states.push_back(environment::FeatureState());
+				getFeatureState(feature_states.back(), state_vertex);
+			}
+		}
+		state_vertices.push_back(state_vertex);
+		costs.push_back(cost);
+	}
+	if (isStanceAdjacency())
+		computeFeatureCosts(costs.data(), feature_states, feature_cost_buffer_, instrumentation_);
+
+	// Computing the current incoming edges of the affected states
+	std::vector<Vertex>& neighbor_actions = neighbor_buffer_;
+	for (std::size_t i = 0; i < state_vertices.size(); i++) {
+		neighbor_actions.clear();
 		{
-			Vertex vertex = vertex_iter->first;
-			Eigen::Vector2d current_coord;
+			DWL_INSTRUMENT_STAGE(instrumentation_, SEARCH_NEIGHBORS);
+			searchNeighbors(neighbor_actions, state_vertices[i]);
+		}
+		for (unsigned int j = 0; j < neighbor_actions.size(); j++)
+			current_edges.push_back(EdgeChange(neighbor_actions[j], state_vertices[i],
+					std::numeric_limits<Weight>::max(), costs[i]));
+	}
 
-			Vertex state_vertex;
-			terrain_->getTerrainSpaceModel().vertexToCoord(current_coord, vertex);
-			Eigen::Vector3d current_state;
-			current_state << current_coord, yaw;
-			terrain_->getTerrainSpaceModel().stateToVertex(state_vertex, current_state);
+	// Updating the states with unknown feet
+	ArenaVector<uint32_t> unaffected_cells(arena_);
+	std::set_difference(unknown_cost_cells_.begin(), unknown_cost_cells_.end(),
+			affected_cells.begin(), affected_cells.end(), std::back_inserter(unaffected_cells));
+	unknown_cost_cells_.clear();
+	std::merge(unaffected_cells.begin(), unaffected_cells.end(), unknown_cost_cells.begin(),
+			unknown_cost_cells.end(), std::back_inserter(unknown_cost_cells_));
+	adjacency_average_cost_ = terrain_view_->getAverageCost();
+
+	// Merging the previous and current edges, and applying the differences to the adjacency map
+	std::sort(previous_edges.begin(), previous_edges.end(), edge_change_less);
+	std::sort(current_edges.begin(), current_edges.end(), edge_change_less);
+	std::size_t i = 0, j = 0;
+	while ((i < previous_edges.size()) || (j < current_edges.size())) {
+		EdgeChange change;
+		if ((j == current_edges.size()) || ((i < previous_edges.size()) &&
+				edge_change_less(previous_edges[i], current_edges[j])))
+			change = previous_edges[i++];
+		else if ((i == previous_edges.size()) ||
+				edge_change_less(current_edges[j], previous_edges[i]))
+			change = current_edges[j++];
+		else {
+			change = previous_edges[i++];
+			change.new_weight = current_edges[j++].new_weight;
+		}
 
-			if (!isStanceAdjacency()) {
-				double terrain_cost = vertex_iter->second.cost;
+		if (change.old_weight == change.new_weight)
+			continue;
 
-				// Searching the neighbor actions
-				std::vector<Vertex> neighbor_actions;
-				searchNeighbors(neighbor_actions, state_vertex);
-				for (unsigned int i = 0; i < neighbor_actions.size(); i++)
-					adjacency_map[neighbor_actions[i]].push_back(Edge(state_vertex, terrain_cost));
-			} else {
-				// Computing the body cost
-				double body_cost;
-				computeBodyCost(body_cost, state_vertex);
-
-				// Searching the neighbor actions
-				std::vector<Vertex> neighbor_actions;
-				searchNeighbors(neighbor_actions, state_vertex);
-				for (unsigned int i = 0; i < neighbor_actions.size(); i++)
-					adjacency_map[neighbor_actions[i]].push_back(Edge(state_vertex, body_cost));
-			}
+		applyEdgeChange(adjacency_map, change);
+		changed_edges.push_back(change);
+	}
+
+	// Snapping again the source and target vertex if a changed cell could be closer than their
+	// closest terrain vertex, or it's the closest terrain vertex itself (e.g. it became unknown)
+	if (isSnappingAffected(changed_cells, adjacency_source_, adjacency_closest_source_) ||
+			isSnappingAffected(changed_cells, adjacency_target_, adjacency_closest_target_)) {
+		Vertex closest_source = adjacency_source_, closest_target = adjacency_target_;
+		getTheClosestStartAndGoalVertex(closest_source, closest_target,
+				adjacency_source_, adjacency_target_);
+
+		ArenaVector<EdgeChange> snapping_changes(arena_);
+		if (closest_source != adjacency_closest_source_) {
+			if (adjacency_closest_source_ != adjacency_source_)
+				snapping_changes.push_back(EdgeChange(adjacency_source_, adjacency_closest_source_,
+						0, std::numeric_limits<Weight>::max()));
+			if (closest_source != adjacency_source_)
+				snapping_changes.push_back(EdgeChange(adjacency_source_, closest_source,
+						std::numeric_limits<Weight>::max(), 0));
 		}
-	} else
-		printf(RED "Could not computed the adjacency map because there is not"
-				" terrain information \n" COLOR_RESET);
+		if (closest_target != adjacency_closest_target_) {
+			if (adjacency_closest_target_ != adjacency_target_)
+				snapping_changes.push_back(EdgeChange(adjacency_closest_target_, adjacency_target_,
+						0, std::numeric_limits<Weight>::max()));
+			if (closest_target != adjacency_target_)
+				snapping_changes.push_back(EdgeChange(closest_target, adjacency_target_,
+						std::numeric_limits<Weight>::max(), 0));
+		}
+		for (std::size_t k = 0; k < snapping_changes.size(); k++) {
+			applyEdgeChange(adjacency_map, snapping_changes[k]);
+			changed_edges.push_back(snapping_changes[k]);
+		}
+
+		setSnappingEdges(closest_source, closest_target);
+	}
+}
+
+
+void GridBasedBodyAdjacency::applyEdgeChange(AdjacencyMap& adjacency_map,
+											 const EdgeChange& change)
+{
+	std::vector<Edge>& edges = adjacency_map[change.source];
+	if (change.old_weight == std::numeric_limits<Weight>::max()) {
+		edges.push_back(Edge(change.target, change.new_weight));
+		return;
+	}
+
+	for (std::size_t k = 0; k < edges.size(); k++) {
+		if (edges[k].target != change.target)
+			continue;
+
+		if (change.new_weight == std::numeric_limits<Weight>::max())
+			edges.erase(edges.begin() + k);
+		else
+			edges[k].weight = change.new_weight;
+		break;
+	}
+	if (edges.empty())
+		adjacency_map.erase(change.source);
+}
+
+
+bool GridBasedBodyAdjacency::isSnappingAffected(const std::vector<Vertex>& changed_cells,
+												Vertex vertex,
+												Vertex closest_vertex)
+{
+	if (changed_cells.empty())
+		return false;
+
+	// Without a closest terrain vertex, any new cell could be the closest one
+	if (closest_vertex == 0)
+		return true;
+
+	// The closest vertex is searched from the continuous position, so the reach has a margin of
+	// one cell w.r.t. the keys
+	Key key, closest_key;
+	terrain_->getTerrainSpaceModel().vertexToKey(key, vertex, true);
+	terrain_->getTerrainSpaceModel().vertexToKey(closest_key, closest_vertex, true);
+	double dx = (double) closest_key.x - key.x;
+	double dy = (double) closest_key.y - key.y;
+	double reach = std::sqrt(dx * dx + dy * dy) + 1;
+	for (std::size_t i = 0; i < changed_cells.size(); i++) {
+		Key changed_key;
+		terrain_->getTerrainSpaceModel().vertexToKey(changed_key, changed_cells[i], true);
+		dx = (double) changed_key.x - key.x;
+		dy = (double) changed_key.y - key.y;
+		if (dx * dx + dy * dy <= reach * reach)
+			return true;
+	}
+
+	return false;
+}
+
+
+void GridBasedBodyAdjacency::setSnappingEdges(Vertex closest_source,
+											  Vertex closest_target)
+{
+	adjacency_closest_source_ = closest_source;
+	adjacency_closest_target_ = closest_target;
+	snapping_edges_.clear();
+	if (closest_source != adjacency_source_)
+		snapping_edges_.push_back(std::make_pair(adjacency_source_, Edge(closest_source, 0)));
+	if (closest_target != adjacency_target_)
+		snapping_edges_.push_back(std::make_pair(closest_target, Edge(adjacency_target_, 0)));
+}
+
+
+void GridBasedBodyAdjacency::setNumberOfThreads(unsigned int num_threads)
+{
+	if (num_threads == 0)
+		num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	num_threads_ = num_threads;
+}
+
+
+void GridBasedBodyAdjacency::setNeighborConnectivity(unsigned int connectivity)
+{
+	if (!neighbor_stencil_.reset(connectivity, neighboring_definition_))
+		return;
+
+	// The edges of a previous adjacency map can't be updated with a different connectivity
+	adjacency_key_yaw_ = -1;
 }
 
 
 void GridBasedBodyAdjacency::getSuccessors(std::list<Edge>& successors,
 										   Vertex state_vertex)
 {
-	Eigen::Vector3d state;
-	terrain_->getTerrainSpaceModel().vertexToState(state, state_vertex);
+	getSuccessors(successor_buffer_, state_vertex);
+	successors.insert(successors.end(), successor_buffer_.begin(), successor_buffer_.end());
+}
 
-	std::vector<Vertex> neighbor_actions;
-	searchNeighbors(neighbor_actions, state_vertex);
-	if (terrain_->isTerrainInformation()) {
-		// Getting the terrain map
-		TerrainDataMap terrain_map = terrain_->getTerrainDataMap();
+
+void GridBasedBodyAdjacency::getSuccessors(std::vector<Edge>& successors,
+										   Vertex state_vertex)
+{
+	DWL_INSTRUMENT_STAGE(instrumentation_, SUCCESSORS);
+	successors.clear();
+
+	// Updating the terrain view if the terrain map changed
+	updateTerrainView(false);
+
+	std::vector<Vertex>& neighbor_actions = neighbor_buffer_;
+	neighbor_actions.clear();
+	{
+		DWL_INSTRUMENT_STAGE(instrumentation_, SEARCH_NEIGHBORS);
+		searchNeighbors(neighbor_actions, state_vertex);
+	}
+	if (terrain_view_->isTerrainInformation()) {
+		std::vector<double>& body_costs = body_cost_buffer_;
+		std::vector<environment::FeatureState>& feature_states = feature_state_buffer_;
+		body_costs.clear();
+		feature_states.clear();
 
 		unsigned int action_size = neighbor_actions.size();
 		for (unsigned int i = 0; i < action_size; i++) {
@@ -127,128 +448,318 @@ void GridBasedBodyAdjacency::getSuccessors(std::list<Edge>& successors,
 					terrain_vertex,	neighbor_actions[i], XY_Y);
 
 			if (!isStanceAdjacency()) {
-				double terrain_cost = terrain_->getTerrainCost(terrain_vertex);
+				Key terrain_key;
+				terrain_->getTerrainSpaceModel().vertexToKey(terrain_key, terrain_vertex, true);
+
+				double terrain_cost = 0;
+				terrain_view_->getCost(terrain_cost, terrain_key.x, terrain_key.y);
 				successors.push_back(Edge(neighbor_actions[i], terrain_cost));
 			} else {
-				// Computing the body cost
-				double body_cost;
-				computeBodyCost(body_cost, neighbor_actions[i]);
-				successors.push_back(Edge(neighbor_actions[i], body_cost));
+				// Computing the terrain cost of the body, the features are computed in batch
+				double terrain_cost;
+				bool is_unknown_cost;
+				computeStanceCost(terrain_cost, is_unknown_cost, neighbor_actions[i],
+						stance_cost_kernel_, instrumentation_);
+				body_costs.push_back(terrain_cost);
+				if (!features_.empty()) {
+					feature_states.push_back(environment::FeatureState());
+					getFeatureState(feature_states.back(), neighbor_actions[i]);
+				}
 			}
 		}
+
+		// Computing the cost of the body features for all the successors
+		if (isStanceAdjacency()) {
+			computeFeatureCosts(body_costs.data(), feature_states, feature_cost_buffer_,
+					instrumentation_);
+			for (unsigned int i = 0; i < action_size; i++)
+				successors.push_back(Edge(neighbor_actions[i], body_costs[i]));
+		}
 	} else
 		printf(RED "Could not computed the successors because there is not"
 				" terrain information \n" COLOR_RESET);
 }
 
 
-void GridBasedBodyAdjacency::getTheClosestStartAndGoalVertex(Vertex& closest_source,
-															 Vertex& closest_target,
-															 Vertex source,
-															 Vertex target)
+BodyCostCache& GridBasedBodyAdjacency::getBodyCostCache()
+{
+	return body_cost_cache_;
+}
+
+
+void GridBasedBodyAdjacency::addFeature(environment::Feature* feature,
+										 double footprint_radius)
+{
+	feature_adapters_.push_back(new environment::FeatureAdapter(feature));
+	feature_adapters_.back()->setFootprintRadius(footprint_radius);
+	addFeature(feature_adapters_.back());
+}
+
+
+void GridBasedBodyAdjacency::addFeature(environment::BatchFeature* feature)
+{
+	double weight;
+	feature->getWeight(weight);
+	printf(BLUE "Adding the %s feature with a weight of %f to the %s adjacency model\n"
+			COLOR_RESET, feature->getName().c_str(), weight, name_.c_str());
+	instrumentation_.setFeatureName(features_.size(), feature->getName());
+	features_.push_back(feature);
+}
+
+
+AdjacencyInstrumentation& GridBasedBodyAdjacency::getInstrumentation()
+{
+	return instrumentation_;
+}
+
+
+bool GridBasedBodyAdjacency::computeAdjacencyEdges(Vertex source,
+												   Vertex target)
 {
-	// Checking if the start and goal vertex are part of the terrain information
-	bool is_there_start_vertex, is_there_goal_vertex = false;
-	std::vector<Vertex> vertex_map;
-	if (terrain_->isTerrainInformation()) {
-		TerrainDataMap terrain_map = terrain_->getTerrainDataMap();
-		for (TerrainDataMap::iterator vertex_iter = terrain_map.begin();
-				vertex_iter != terrain_map.end(); vertex_iter++) {
-			Vertex current_vertex = vertex_iter->first;
-			if (source == current_vertex) {
-				is_there_start_vertex = true;
-				closest_source = current_vertex;
+	DWL_INSTRUMENT_STAGE(instrumentation_, ADJACENCY_MAP);
+
+	// Updating the dense view of the terrain
+	updateTerrainView(true);
+
+	// Computing a default stance areas, the gait state of the robot isn't modified
+	Eigen::Vector3d full_action = Eigen::Vector3d::Zero();
+	robot::GaitState gait_state = robot_->getGaitState();
+	stance_pattern_ = robot_->getStancePattern(gait_state, full_action);
+	stance_areas_ = robot_->getPatternFootstepSearchAreas(stance_pattern_);
+
+	// Getting the body orientation
+	Eigen::Vector3d initial_state;
+	terrain_->getTerrainSpaceModel().vertexToState(initial_state, source);
+	unsigned short int key_yaw;
+	terrain_->getTerrainSpaceModel().stateToKey(key_yaw, (double) initial_state(2), false);
+	double yaw;
+	terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
+
+	if (terrain_view_->isTerrainInformation()) {
+		// Adding the source and target vertex if it is outside the information terrain
+		Vertex closest_source, closest_target;
+		getTheClosestStartAndGoalVertex(closest_source, closest_target, source, target);
+		adjacency_source_ = source;
+		adjacency_target_ = target;
+		setSnappingEdges(closest_source, closest_target);
+
+		// Computing the stance stencil and stance cost field of the current yaw bin before
+		// sharing them between threads
+		if (isStanceAdjacency())
+			updateStanceCostField(key_yaw);
+
+		// Computing the edges of every chunk of terrain vertices
+		num_chunks_ = (snapshot_reader_.getSnapshot().getTerrainVertices().size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		unsigned int num_chunks = num_chunks_;
+		// The single-state features aren't required to be reentrant, so the chunks are computed
+		// serially if any of them is registered
+		unsigned int num_threads = std::min(num_threads_, num_chunks);
+		if (!feature_adapters_.empty())
+			num_threads = 1;
+		if (chunk_edges_.size() < num_chunks) {
+			chunk_edges_.resize(num_chunks);
+			chunk_unknown_cost_cells_.resize(num_chunks);
+		}
+		if (thread_kernels_.size() < num_threads) {
+			thread_kernels_.resize(num_threads);
+			thread_instrumentation_.resize(num_threads);
+			thread_buffers_.resize(num_threads);
+			while (thread_arenas_.size() < num_threads)
+				thread_arenas_.push_back(new QueryArena());
+		}
+
+		if (num_threads <= 1) {
+			for (unsigned int chunk = 0; chunk < num_chunks; chunk++)
+				computeChunkEdges(chunk_edges_[chunk], chunk_unknown_cost_cells_[chunk], chunk,
+						yaw, stance_cost_kernel_, arena_, thread_buffers_[0], instrumentation_);
+		} else {
+			std::atomic<unsigned int> next_chunk(0);
+			std::vector<std::thread> threads;
+			for (unsigned int i = 0; i < num_threads; i++) {
+				threads.push_back(std::thread([this, &next_chunk, num_chunks, yaw, i]() {
+					unsigned int chunk;
+					while ((chunk = next_chunk.fetch_add(1)) < num_chunks)
+						computeChunkEdges(chunk_edges_[chunk], chunk_unknown_cost_cells_[chunk],
+								chunk, yaw, thread_kernels_[i], *thread_arenas_[i], thread_buffers_[i],
+								thread_instrumentation_[i]);
+				}));
 			}
-			if (target == current_vertex) {
-				is_there_goal_vertex = true;
-				closest_target = current_vertex;
+			for (unsigned int i = 0; i < num_threads; i++)
+				threads[i].join();
+
+#ifdef DWL_ADJACENCY_INSTRUMENTATION
+			// Merging the instrumentation of the threads
+			for (unsigned int i = 0; i < num_threads; i++) {
+				instrumentation_.merge(thread_instrumentation_[i]);
+				thread_instrumentation_[i].reset();
 			}
+#endif
+		}
 
-			if ((is_there_start_vertex) && (is_there_goal_vertex))
-				return;
-
-			vertex_map.push_back(vertex_iter->first);
+		// Collecting the states with unknown feet
+		unknown_cost_cells_.clear();
+		for (unsigned int chunk = 0; chunk < num_chunks; chunk++) {
+			unknown_cost_cells_.insert(unknown_cost_cells_.end(),
+					chunk_unknown_cost_cells_[chunk].begin(), chunk_unknown_cost_cells_[chunk].end());
 		}
+		std::sort(unknown_cost_cells_.begin(), unknown_cost_cells_.end());
+
+		// Recording the yaw bin and average cost of the adjacency map for incremental updates
+		adjacency_key_yaw_ = key_yaw;
+		adjacency_average_cost_ = terrain_view_->getAverageCost();
+
+		// Releasing the temporaries of the chunks at once
+		arena_.reset();
+		for (std::size_t i = 0; i < thread_arenas_.size(); i++)
+			thread_arenas_[i]->reset();
 	} else {
-		printf(RED "Could not get the closest start and goal vertex because"
-				" there is not terrain information \n" COLOR_RESET);
-		return;
+		printf(RED "Could not computed the adjacency map because there is not"
+				" terrain information \n" COLOR_RESET);
+		return false;
 	}
 
-	// Start and goal state
-	Eigen::Vector3d start_state, goal_state;
-	terrain_->getTerrainSpaceModel().vertexToState(start_state, source);
-	terrain_->getTerrainSpaceModel().vertexToState(goal_state, target);
+	return true;
+}
 
-	double closest_source_distant = std::numeric_limits<double>::max();
-	double closest_target_distant = std::numeric_limits<double>::max();
-	Vertex start_closest_vertex = 0, goal_closest_vertex = 0;
-	if ((!is_there_start_vertex) && (!is_there_goal_vertex)) {
-		Eigen::Vector3d current_state;
-		for (unsigned int i = 0; i < vertex_map.size(); i++) {
-			// Calculating the vertex position
-			terrain_->getTerrainSpaceModel().vertexToState(current_state, vertex_map[i]);
-
-			// Calculating the distant to the vertex from start and goal positions
-			double start_distant = (start_state.head(2) - current_state.head(2)).norm();
-			double goal_distant = (goal_state.head(2) - current_state.head(2)).norm();
-
-			// Recording the closest vertex from the start position
-			if (start_distant < closest_source_distant) {
-				start_closest_vertex = vertex_map[i];
-				closest_source_distant = start_distant;
-			}
 
-			// Recording the closest vertex from the goal position
-			if (goal_distant < closest_target_distant) {
-				goal_closest_vertex = vertex_map[i];
-				closest_target_distant = goal_distant;
+void GridBasedBodyAdjacency::computeChunkEdges(std::vector<std::pair<Vertex, Edge> >& edges,
+											   std::vector<uint32_t>& unknown_cost_cells,
+											   unsigned int chunk,
+											   double yaw,
+											   StanceCostKernel& kernel,
+											   QueryArena& arena,
+											   ChunkBuffers& buffers,
+											   AdjacencyInstrumentation& instrumentation)
+{
+	edges.clear();
+	unknown_cost_cells.clear();
+
+	// Computing the body cost of the state vertex of every terrain vertex
+	std::size_t begin = (std::size_t) chunk * CHUNK_SIZE;
+	const std::vector<Vertex>& terrain_vertices = snapshot_reader_.getSnapshot().getTerrainVertices();
+	std::size_t end = std::min((std::size_t) (chunk + 1) * CHUNK_SIZE, terrain_vertices.size());
+	ArenaVector<Vertex> state_vertices(arena);
+	ArenaVector<double> costs(arena);
+	std::vector<environment::FeatureState>& feature_states = buffers.feature_states;
+	feature_states.clear();
+	state_vertices.reserve(end - begin);
+	costs.reserve(end - begin);
+	for (std::size_t k = begin; k < end; k++) {
+		Vertex vertex = terrain_vertices[k];
+		Eigen::Vector2d current_coord;
+
+		Vertex state_vertex;
+		terrain_->getTerrainSpaceModel().vertexToCoord(current_coord, vertex);
+		Eigen::Vector3d current_state;
+		current_state << current_coord, yaw;
+		terrain_->getTerrainSpaceModel().stateToVertex(state_vertex, current_state);
+
+		Key terrain_key;
+		terrain_->getTerrainSpaceModel().vertexToKey(terrain_key, vertex, true);
+
+		double cost = 0;
+		if (!isStanceAdjacency())
+			terrain_view_->getCost(cost, terrain_key.x, terrain_key.y);
+		else {
+			bool is_unknown_cost;
+			computeStanceCost(cost, is_unknown_cost, state_vertex, kernel, instrumentation);
+			if (is_unknown_cost)
+				unknown_cost_cells.push_back((uint32_t) terrain_key.y << 16 | terrain_key.x);
+
+			if (!features_.empty()) {
+				feature_states.push_back(environment::FeatureState());
+				getFeatureState(feature_states.back(), state_vertex);
 			}
 		}
+		state_vertices.push_back(state_vertex);
+		costs.push_back(cost);
+	}
 
-		// Adding the goal to the adjacency map
-		closest_source = start_closest_vertex;
-		closest_target = goal_closest_vertex;
-	} else if (!is_there_start_vertex) {
-		Eigen::Vector3d current_state;
-		for (unsigned int i = 0; i < vertex_map.size(); i++) {
-			// Calculating the vertex position
-			terrain_->getTerrainSpaceModel().vertexToState(current_state, vertex_map[i]);
-
-			// Calculating the distant to the vertex from start position
-			double start_distant = (start_state.head(2) - current_state.head(2)).norm();
+	// Computing the cost of the body features for the whole chunk
+	if (isStanceAdjacency())
+		computeFeatureCosts(costs.data(), feature_states, buffers.feature_costs, instrumentation);
 
-			// Recording the closest vertex from the start position
-			if (start_distant < closest_source_distant) {
-				start_closest_vertex = vertex_map[i];
-				closest_source_distant = start_distant;
-			}
+	// Searching the neighbor actions
+	std::vector<Vertex>& neighbor_actions = buffers.neighbor_actions;
+	for (std::size_t k = 0; k < state_vertices.size(); k++) {
+		neighbor_actions.clear();
+		{
+			DWL_INSTRUMENT_STAGE(instrumentation, SEARCH_NEIGHBORS);
+			searchNeighbors(neighbor_actions, state_vertices[k]);
 		}
+		for (unsigned int i = 0; i < neighbor_actions.size(); i++)
+			edges.push_back(std::make_pair(neighbor_actions[i],
+					Edge(state_vertices[k], costs[k])));
+	}
+}
 
-		// Adding the start to the adjacency map
-		closest_source = start_closest_vertex;
-	} else if (!is_there_goal_vertex) {
-		Eigen::Vector3d current_state;
-		for (unsigned int i = 0; i < vertex_map.size(); i++) {
-			// Calculating the vertex position
-			terrain_->getTerrainSpaceModel().vertexToState(current_state, vertex_map[i]);
 
-			// Calculating the distant to the vertex from goal position
-			double goal_distant = (goal_state.head(2) - current_state.head(2)).norm();
+void GridBasedBodyAdjacency::getTheClosestStartAndGoalVertex(Vertex& closest_source,
+															 Vertex& closest_target,
+															 Vertex source,
+															 Vertex target)
+{
+	if (!terrain_view_->isTerrainInformation()) {
+		printf(RED "Could not get the closest start and goal vertex because"
+				" there is not terrain information \n" COLOR_RESET);
+		return;
+	}
 
-			// Recording the closest vertex from the goal position
-			if (goal_distant < closest_target_distant) {
-				goal_closest_vertex = vertex_map[i];
-				closest_target_distant = goal_distant;
-			}
+	getTheClosestTerrainVertex(closest_source, source);
+	getTheClosestTerrainVertex(closest_target, target);
+}
+
+
+void GridBasedBodyAdjacency::getTheClosestTerrainVertex(Vertex& closest_vertex,
+														Vertex vertex)
+{
+	// Checking if the vertex is part of the terrain information
+	Key key;
+	terrain_->getTerrainSpaceModel().vertexToKey(key, vertex, true);
+	if (terrain_view_->isValid(key)) {
+		Vertex terrain_vertex;
+		terrain_->getTerrainSpaceModel().keyToVertex(terrain_vertex, key, true);
+		if (terrain_vertex == vertex) {
+			closest_vertex = vertex;
+			return;
 		}
+	}
 
-		// Adding the goal to the adjacency map
-		closest_target = goal_closest_vertex;
+	// Getting the position of the vertex in key units
+	Eigen::Vector3d state;
+	terrain_->getTerrainSpaceModel().vertexToState(state, vertex);
+	double origin_x, origin_y;
+	terrain_->getTerrainSpaceModel().keyToState(origin_x, 0, true);
+	terrain_->getTerrainSpaceModel().keyToState(origin_y, 0, true);
+	double resolution = snapshot_reader_.getSnapshot().getResolution();
+
+	// Searching the closest terrain cell
+	int key_x, key_y;
+	closest_vertex = 0;
+	if (terrain_index_.findClosest(key_x, key_y, *terrain_view_,
+			(state(0) - origin_x) / resolution, (state(1) - origin_y) / resolution)) {
+		key.x = key_x;
+		key.y = key_y;
+		terrain_->getTerrainSpaceModel().keyToVertex(closest_vertex, key, true);
 	}
 }
 
 
+void GridBasedBodyAdjacency::getStateVertex(Vertex& state_vertex,
+											const Key& terrain_key,
+											double yaw)
+{
+	Vertex terrain_vertex;
+	Eigen::Vector2d coord;
+	terrain_->getTerrainSpaceModel().keyToVertex(terrain_vertex, terrain_key, true);
+	terrain_->getTerrainSpaceModel().vertexToCoord(coord, terrain_vertex);
+
+	Eigen::Vector3d state;
+	state << coord, yaw;
+	terrain_->getTerrainSpaceModel().stateToVertex(state_vertex, state);
+}
+
+
 void GridBasedBodyAdjacency::searchNeighbors(std::vector<Vertex>& neighbor_states,
 											 Vertex state_vertex)
 {
@@ -264,246 +775,237 @@ void GridBasedBodyAdjacency::searchNeighbors(std::vector<Vertex>& neighbor_state
 	terrain_->getTerrainSpaceModel().stateVertexToEnvironmentVertex(terrain_vertex, state_vertex, XY_Y);
 	terrain_->getTerrainSpaceModel().vertexToKey(terrain_key, terrain_vertex, true);
 
-	// Searching the closed neighbors around 3-neighboring area
-	bool is_found_neighbor_positive_x = false, is_found_neighbor_negative_x = false;
-	bool is_found_neighbor_positive_y = false, is_found_neighbor_negative_y = false;
-	bool is_found_neighbor_positive_xy = false, is_found_neighbor_negative_xy = false;
-	bool is_found_neighbor_positive_yx = false, is_found_neighbor_negative_yx = false;
-	if (terrain_->isTerrainInformation()) {
-		// Getting the terrain map
-		TerrainDataMap terrain_map = terrain_->getTerrainDataMap();
-
-		double x, y, yaw;
-
-		// Searching the states neighbors
-		for (int r = 1; r <= neighboring_definition_; r++) {
-			Key searching_key;
-			Vertex neighbor_vertex, neighbor_state_vertex;
-
-			// Searching the neighbors in the positive x-axis
-			searching_key.x = terrain_key.x + r;
-			searching_key.y = terrain_key.y;
-			terrain_->getTerrainSpaceModel().keyToVertex(neighbor_vertex, searching_key, true);
-			if ((terrain_map.count(neighbor_vertex) > 0) && (!is_found_neighbor_positive_x)) {
-				// Getting the state vertex of the neighbor
-				terrain_->getTerrainSpaceModel().keyToState(x, searching_key.x, true);
-				terrain_->getTerrainSpaceModel().keyToState(y, searching_key.y, true);
-				terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
-				state << x, y, yaw;
-				terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
-
-				neighbor_states.push_back(neighbor_state_vertex);
-				is_found_neighbor_positive_x = true;
-			}
-
-			// Searching the neighbor in the negative x-axis
-			searching_key.x = terrain_key.x - r;
-			searching_key.y = terrain_key.y;
-			terrain_->getTerrainSpaceModel().keyToVertex(neighbor_vertex, searching_key, true);
-			if ((terrain_map.count(neighbor_vertex) > 0) && (!is_found_neighbor_negative_x)) {
-				// Getting the state vertex of the neighbor
-				terrain_->getTerrainSpaceModel().keyToState(x, searching_key.x, true);
-				terrain_->getTerrainSpaceModel().keyToState(y, searching_key.y, true);
-				terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
-				state << x, y, yaw;
-				terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
-
-				neighbor_states.push_back(neighbor_state_vertex);
-				is_found_neighbor_negative_x = true;
-			}
+	// Searching the closest neighbor of every direction, radius by radius
+	if (terrain_view_->isTerrainInformation()) {
+		double yaw;
+		terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
+
+		const std::vector<NeighborOffset>& offsets = neighbor_stencil_.getOffsets();
+		uint32_t direction_mask = neighbor_stencil_.getDirectionMask();
+		uint32_t found_mask = 0;
+		for (std::size_t i = 0; (i < offsets.size()) && (found_mask != direction_mask); i++) {
+			const NeighborOffset& offset = offsets[i];
+			uint32_t direction = (uint32_t) 1 << offset.direction;
+			if (found_mask & direction)
+				continue;
+
+			int key_x = terrain_key.x + offset.dx;
+			int key_y = terrain_key.y + offset.dy;
+			if (!terrain_view_->isValid(key_x, key_y))
+				continue;
+
+			// Getting the state vertex of the neighbor
+			double x, y;
+			terrain_->getTerrainSpaceModel().keyToState(x, key_x, true);
+			terrain_->getTerrainSpaceModel().keyToState(y, key_y, true);
+			state << x, y, yaw;
+
+			Vertex neighbor_state_vertex;
+			terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
+			neighbor_states.push_back(neighbor_state_vertex);
+			found_mask |= direction;
+		}
+	} else
+		printf(RED "Could not searched the neighbors because there is not"
+				" terrain information \n" COLOR_RESET);
+}
 
-			// Searching the neighbor in the positive y-axis
-			searching_key.x = terrain_key.x;
-			searching_key.y = terrain_key.y + r;
-			terrain_->getTerrainSpaceModel().keyToVertex(neighbor_vertex, searching_key, true);
-			if ((terrain_map.count(neighbor_vertex) > 0) && (!is_found_neighbor_positive_y)) {
-				// Getting the state vertex of the neighbor
-				terrain_->getTerrainSpaceModel().keyToState(x, searching_key.x, true);
-				terrain_->getTerrainSpaceModel().keyToState(y, searching_key.y, true);
-				terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
-				state << x, y, yaw;
-				terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
-
-				neighbor_states.push_back(neighbor_state_vertex);
-				is_found_neighbor_positive_y = true;
-			}
 
-			// Searching the neighbor in the negative y-axis
-			searching_key.x = terrain_key.x;
-			searching_key.y = terrain_key.y - r;
-			terrain_->getTerrainSpaceModel().keyToVertex(neighbor_vertex, searching_key, true);
-			if ((terrain_map.count(neighbor_vertex) > 0) && (!is_found_neighbor_negative_y)) {
-				// Getting the state vertex of the neighbor
-				terrain_->getTerrainSpaceModel().keyToState(x, searching_key.x, true);
-				terrain_->getTerrainSpaceModel().keyToState(y, searching_key.y, true);
-				terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
-				state << x, y, yaw;
-				terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
-
-				neighbor_states.push_back(neighbor_state_vertex);
-				is_found_neighbor_negative_y = true;
-			}
+void GridBasedBodyAdjacency::computeStanceCost(double& cost,
+											   bool& is_unknown_cost,
+											   Vertex state_vertex,
+											   StanceCostKernel& kernel,
+											   AdjacencyInstrumentation& instrumentation)
+{
+	DWL_INSTRUMENT_STAGE(instrumentation, STANCE_COST);
 
-			// Searching the neighbor in the positive xy-axis
-			searching_key.x = terrain_key.x + r;
-			searching_key.y = terrain_key.y + r;
-			terrain_->getTerrainSpaceModel().keyToVertex(neighbor_vertex, searching_key, true);
-			if ((terrain_map.count(neighbor_vertex) > 0) && (!is_found_neighbor_positive_xy)) {
-				// Getting the state vertex of the neighbor
-				terrain_->getTerrainSpaceModel().keyToState(x, searching_key.x, true);
-				terrain_->getTerrainSpaceModel().keyToState(y, searching_key.y, true);
-				terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
-				state << x, y, yaw;
-				terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
-
-				neighbor_states.push_back(neighbor_state_vertex);
-				is_found_neighbor_positive_xy = true;
-			}
+	// Converting the vertex to state (x,y,yaw)
+	Eigen::Vector3d state;
+	terrain_->getTerrainSpaceModel().vertexToState(state, state_vertex);
 
-			// Searching the neighbor in the negative xy-axis
-			searching_key.x = terrain_key.x - r;
-			searching_key.y = terrain_key.y - r;
-			terrain_->getTerrainSpaceModel().keyToVertex(neighbor_vertex, searching_key, true);
-			if ((terrain_map.count(neighbor_vertex) > 0) && (!is_found_neighbor_negative_xy)) {
-				// Getting the state vertex of the neighbor
-				terrain_->getTerrainSpaceModel().keyToState(x, searching_key.x, true);
-				terrain_->getTerrainSpaceModel().keyToState(y, searching_key.y, true);
-				terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
-				state << x, y, yaw;
-				terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
-
-				neighbor_states.push_back(neighbor_state_vertex);
-				is_found_neighbor_negative_xy = true;
-			}
+	// Getting the terrain cell of the body
+	Vertex terrain_vertex;
+	Key terrain_key;
+	terrain_->getTerrainSpaceModel().stateVertexToEnvironmentVertex(terrain_vertex,
+			state_vertex, XY_Y);
+	terrain_->getTerrainSpaceModel().vertexToKey(terrain_key, terrain_vertex, true);
 
-			// Searching the neighbor in the positive yx-axis
-			searching_key.x = terrain_key.x - r;
-			searching_key.y = terrain_key.y + r;
-			terrain_->getTerrainSpaceModel().keyToVertex(neighbor_vertex, searching_key, true);
-			if ((terrain_map.count(neighbor_vertex) > 0) && (!is_found_neighbor_positive_yx)) {
-				// Getting the state vertex of the neighbor
-				terrain_->getTerrainSpaceModel().keyToState(x, searching_key.x, true);
-				terrain_->getTerrainSpaceModel().keyToState(y, searching_key.y, true);
-				terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
-				state << x, y, yaw;
-				terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
-
-				neighbor_states.push_back(neighbor_state_vertex);
-				is_found_neighbor_positive_yx = true;
-			}
+	// Getting the stance stencil of the current yaw bin
+	unsigned short int key_yaw;
+	terrain_->getTerrainSpaceModel().stateToKey(key_yaw, (double) state(2), false);
+	const StanceStencil& stencil = getStanceStencil(key_yaw);
+
+	// Getting the terrain cost from the stance cost field if it's updated, otherwise from the
+	// cache or the stance stencil
+	double terrain_cost;
+	double unknown_cost = uncertainty_factor_ * terrain_view_->getAverageCost();
+	uint64_t cache_key = BodyCostCache::getKey(terrain_key.x, terrain_key.y, key_yaw, stance_pattern_);
+	if (getFieldCost(terrain_cost, is_unknown_cost, key_yaw, terrain_key))
+		DWL_INSTRUMENT_COUNT(instrumentation, FIELD_HITS, 1);
+	else if (body_cost_cache_.find(terrain_cost, is_unknown_cost, cache_key, unknown_cost))
+		DWL_INSTRUMENT_COUNT(instrumentation, CACHE_HITS, 1);
+	else {
+		DWL_INSTRUMENT_COUNT(instrumentation, CACHE_MISSES, 1);
+		DWL_INSTRUMENT_COUNT(instrumentation, SAMPLED_CELLS, stencil.offsets.size());
+		terrain_cost = kernel.computeTerrainCost(*terrain_view_, stencil,
+				terrain_key.x, terrain_key.y, number_top_cost_, unknown_cost);
+		is_unknown_cost = kernel.getNumberOfUnknownFeet() > 0;
+		body_cost_cache_.insert(cache_key, terrain_cost, is_unknown_cost, unknown_cost);
+	}
 
-			// Searching the neighbor in the negative yx-axis
-			searching_key.x = terrain_key.x + r;
-			searching_key.y = terrain_key.y - r;
-			terrain_->getTerrainSpaceModel().keyToVertex(neighbor_vertex, searching_key, true);
-			if ((terrain_map.count(neighbor_vertex) > 0) && (!is_found_neighbor_negative_yx)) {
-				// Getting the state vertex of the neighbor
-				terrain_->getTerrainSpaceModel().keyToState(x, searching_key.x, true);
-				terrain_->getTerrainSpaceModel().keyToState(y, searching_key.y, true);
-				terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
-				state << x, y, yaw;
-				terrain_->getTerrainSpaceModel().stateToVertex(neighbor_state_vertex, state);
-
-				neighbor_states.push_back(neighbor_state_vertex);
-				is_found_neighbor_negative_yx = true;
-			}
-		}
-	} else
-		printf(RED "Could not searched the neighbors because there is not"
-				" terrain information \n" COLOR_RESET);
+	cost = terrain_cost;
 }
 
 
-void GridBasedBodyAdjacency::computeBodyCost(double& cost,
+void GridBasedBodyAdjacency::getFeatureState(environment::FeatureState& feature_state,
 											 Vertex state_vertex)
 {
 	// Converting the vertex to state (x,y,yaw)
 	Eigen::Vector3d state;
 	terrain_->getTerrainSpaceModel().vertexToState(state, state_vertex);
 
-	// Getting the terrain map
-	TerrainDataMap terrain_map = terrain_->getTerrainDataMap();
-
-	// Computing the terrain cost
-	double terrain_cost = 0;
-	unsigned int area_size = stance_areas_.size();
-	for (unsigned int n = 0; n < area_size; n++) {
-		// Computing the boundary of stance area
-		Eigen::Vector2d boundary_min, boundary_max;
-		boundary_min(0) = stance_areas_[n].min_x + state(0);
-		boundary_min(1) = stance_areas_[n].min_y + state(1);
-		boundary_max(0) = stance_areas_[n].max_x + state(0);
-		boundary_max(1) = stance_areas_[n].max_y + state(1);
-
-		// Computing the stance cost
-		std::set< std::pair<Weight, Vertex>, pair_first_less<Weight, Vertex> > stance_cost_queue;
-		double stance_cost = 0;
-		double resolution = stance_areas_[n].resolution;
-		for (double y = boundary_min(1); y <= boundary_max(1); y += resolution ) {
-			for (double x = boundary_min(0); x <= boundary_max(0); x += resolution) {
-				// Computing the rotated coordinate according to the orientation of the body
-				Eigen::Vector2d point_position;
-				point_position(0) = (x - state(0)) * cos((double) state(2)) -
-						(y - state(1)) * sin((double) state(2)) + state(0);
-				point_position(1) = (x - state(0)) * sin((double) state(2)) +
-						(y - state(1)) * cos((double) state(2)) + state(1);
-
-				Vertex current_2d_vertex;
-				terrain_->getTerrainSpaceModel().coordToVertex(current_2d_vertex, point_position);
-
-				// Inserts the element in an organized vertex queue, according to the maximum value
-				if (terrain_map.count(current_2d_vertex) > 0)
-					stance_cost_queue.insert(std::pair<Weight, Vertex>(
-							terrain_->getTerrainCost(current_2d_vertex),
-							current_2d_vertex));
-			}
-		}
+	feature_state.body_action << 1, 0, 0;
+	feature_state.pose.position = (Eigen::Vector2d) state.head(2);
+	feature_state.pose.orientation = (double) state(2);
+}
 
-		// Averaging the 5-best (lowest) cost
-		unsigned int number_top_cost = number_top_cost_;
-		if (stance_cost_queue.size() < number_top_cost)
-			number_top_cost = stance_cost_queue.size();
 
-		if (number_top_cost == 0) {
-			stance_cost += uncertainty_factor_ * terrain_->getAverageCostOfTerrain();
-		} else {
-			for (unsigned int i = 0; i < number_top_cost; i++) {
-				stance_cost += stance_cost_queue.begin()->first;
-				stance_cost_queue.erase(stance_cost_queue.begin());
-			}
+void GridBasedBodyAdjacency::computeFeatureCosts(double* costs,
+												 const std::vector<environment::FeatureState>& states,
+												 std::vector<double>& feature_costs,
+												 AdjacencyInstrumentation& instrumentation)
+{
+	unsigned int feature_size = features_.size();
+	if ((feature_size == 0) || states.empty())
+		return;
 
-			stance_cost /= number_top_cost;
-		}
+	DWL_INSTRUMENT_STAGE(instrumentation, FEATURE_COST);
+
+	// Borrowing the terrain information for the whole batch
+	environment::FeatureTerrain terrain;
+	terrain.height_map = &snapshot_reader_.getSnapshot().getHeightMap();
+	terrain.terrain_view = terrain_view_;
+	terrain.resolution = snapshot_reader_.getSnapshot().getResolution();
 
-		terrain_cost += stance_cost;
-	}
-	terrain_cost /= stance_areas_.size();
-
-	// Getting robot and terrain information
-	RobotAndTerrain info;
-	Eigen::Vector3d default_action;
-	default_action << 1, 0, 0;
-	info.body_action = default_action;
-	info.pose.position = (Eigen::Vector2d) state.head(2);
-	info.pose.orientation = (double) state(2);
-	info.height_map = terrain_->getTerrainHeightMap();
-	info.resolution = terrain_->getResolution(true);
-
-	// Computing the cost of the body features
-	cost = terrain_cost;
-	unsigned int feature_size = features_.size();
 	for (unsigned int i = 0; i < feature_size; i++) {
 		// Computing the cost associated with body path features
-		double feature_cost, weight;
-		features_[i]->computeCost(feature_cost, info);
+		double weight;
+		{
+			DWL_INSTRUMENT_FEATURE(instrumentation, i);
+			features_[i]->computeCosts(feature_costs, states, terrain);
+		}
 		features_[i]->getWeight(weight);
 
 		// Computing the cost of the body feature
-		cost += weight * feature_cost;
+		for (std::size_t k = 0; k < states.size(); k++)
+			costs[k] += weight * feature_costs[k];
+	}
+}
+
+
+const StanceStencil& GridBasedBodyAdjacency::getStanceStencil(unsigned short int key_yaw)
+{
+	// Computing the default stance areas if the adjacency map wasn't computed before
+	if (stance_pattern_ < 0) {
+		Eigen::Vector3d full_action = Eigen::Vector3d::Zero();
+		robot::GaitState gait_state = robot_->getGaitState();
+		stance_pattern_ = robot_->getStancePattern(gait_state, full_action);
+		stance_areas_ = robot_->getPatternFootstepSearchAreas(stance_pattern_);
+	}
+
+	if (!stance_stencils_.isDefined(key_yaw, stance_pattern_)) {
+		double yaw;
+		terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
+		stance_stencils_.compute(key_yaw, stance_pattern_, yaw, stance_areas_);
+	}
+
+	return stance_stencils_.getStencil(key_yaw, stance_pattern_);
+}
+
+
+void GridBasedBodyAdjacency::updateStanceCostField(unsigned short int key_yaw)
+{
+	const StanceStencil& stencil = getStanceStencil(key_yaw);
+
+	std::size_t field_index =
+			(std::size_t) key_yaw * robot::Robot::NUM_STANCE_PATTERNS + stance_pattern_;
+	if (field_index >= stance_cost_fields_.size())
+		stance_cost_fields_.resize(field_index + 1);
+
+	StanceCostField& field = stance_cost_fields_[field_index];
+	if (!field.isUpdated(terrain_view_->getVersion(), number_top_cost_))
+		field.compute(*terrain_view_, stencil, number_top_cost_,
+				uncertainty_factor_ * terrain_view_->getAverageCost(), num_threads_);
+}
+
+
+bool GridBasedBodyAdjacency::getFieldCost(double& cost,
+										  bool& is_unknown_cost,
+										  unsigned short int key_yaw,
+										  const Key& terrain_key)
+{
+	std::size_t field_index =
+			(std::size_t) key_yaw * robot::Robot::NUM_STANCE_PATTERNS + stance_pattern_;
+	if ((field_index >= stance_cost_fields_.size()) ||
+			!stance_cost_fields_[field_index].isUpdated(terrain_view_->getVersion(), number_top_cost_))
+		return false;
+
+	return stance_cost_fields_[field_index].getCost(cost, is_unknown_cost,
+			terrain_key.x, terrain_key.y);
+}
+
+
+void GridBasedBodyAdjacency::updateTerrainView(bool is_forced)
+{
+	bool is_view_changed = snapshot_reader_.update(terrain_, is_forced);
+	terrain_view_ = &snapshot_reader_.getSnapshot().getTerrainView();
+	if (!is_view_changed)
+		return;
+
+	// Invalidating the cached costs of the states whose stance areas overlap the changed cells
+	int min_x, min_y, max_x, max_y;
+	if (snapshot_reader_.getDirtyRegion(min_x, min_y, max_x, max_y)) {
+		terrain_index_.update(*terrain_view_, min_x, min_y, max_x, max_y);
+
+		int reach = stance_stencils_.getReach();
+		body_cost_cache_.invalidate(min_x - reach, min_y - reach, max_x + reach, max_y + reach);
+	} else {
+		terrain_index_.reset(*terrain_view_);
+		body_cost_cache_.invalidateAll();
 	}
 }
 
 
+void GridBasedBodyAdjacency::setTerrainSnapshots(environment::TerrainSnapshotBuffer* snapshots)
+{
+	// The versions of the views of different buffers aren't related
+	snapshot_reader_.setSharedSnapshots(snapshots);
+	stance_cost_fields_.clear();
+	if (terrain_ != NULL)
+		updateTerrainView(true);
+}
+
+
+void GridBasedBodyAdjacency::pinTerrainSnapshot()
+{
+	snapshot_reader_.release();
+	updateTerrainView(true);
+	snapshot_reader_.pin();
+}
+
+
+void GridBasedBodyAdjacency::releaseTerrainSnapshot()
+{
+	snapshot_reader_.release();
+}
+
+
+void GridBasedBodyAdjacency::notifyTerrainChanged()
+{
+	snapshot_reader_.notifyChanged();
+}
+
+
 bool GridBasedBodyAdjacency::isStanceAdjacency()
 {
 	return is_stance_adjacency_;
@@ -8,7 +8,8 @@ namespace model
 {
 
 LatticeBasedBodyAdjacency::LatticeBasedBodyAdjacency() : robot_(NULL),
-		terrain_(NULL), is_stance_adjacency_(true),	number_top_cost_(10),
+		terrain_(NULL), terrain_view_(NULL), obstacle_grid_(NULL), is_stance_adjacency_(true),
+		is_lazy_evaluation_(false), number_top_cost_(10),
 		uncertainty_factor_(1.15)
 {
 	name_ = "Lattice-based Body";
@@ -18,7 +19,8 @@ LatticeBasedBodyAdjacency::LatticeBasedBodyAdjacency() : robot_(NULL),
 
 LatticeBasedBodyAdjacency::~LatticeBasedBodyAdjacency()
 {
-
+	for (std::size_t i = 0; i < feature_adapters_.size(); i++)
+		delete feature_adapters_[i];
 }
 
 
@@ -28,10 +30,16 @@ void LatticeBasedBodyAdjacency::reset(robot::Robot* robot,
 	printf(BLUE "Setting the robot information in the %s adjacency model \n"
 			COLOR_RESET, name_.c_str());
 	robot_ = robot;
+	gait_state_ = robot_->getGaitState();
 
 	printf(BLUE "Setting the environment information in the %s adjacency model"
 			" \n" COLOR_RESET, name_.c_str());
 	terrain_ = environment;
+	snapshot_reader_.clear();
+	updateTerrainView(true);
+	body_footprints_.clear();
+	primitive_successors_.clear();
+	stance_stencils_.reset(terrain_->getResolution(true));
 
 	for (int i = 0; i < (int) features_.size(); i++)
 		features_[i]->reset(robot);
@@ -41,146 +49,413 @@ void LatticeBasedBodyAdjacency::reset(robot::Robot* robot,
 void LatticeBasedBodyAdjacency::getSuccessors(std::list<Edge>& successors,
 											  Vertex state_vertex)
 {
-	// Getting the 3d pose for generating the actions
-	std::vector<Action3d> actions;
-	Eigen::Vector3d current_state;
-	terrain_->getTerrainSpaceModel().vertexToState(current_state, state_vertex);
+	getSuccessors(successor_buffer_, state_vertex);
+	successors.insert(successors.end(), successor_buffer_.begin(), successor_buffer_.end());
+}
 
-	// Converting state to pose
-	Pose3d current_pose;
-	current_pose.position = current_state.head(2);
-	current_pose.orientation = current_state(2);
 
-	// Gets actions according the defined body motor primitives
-	robot_->getBodyMotorPrimitive().generateActions(actions, current_pose);
+void LatticeBasedBodyAdjacency::getSuccessors(std::vector<Edge>& successors,
+											  Vertex state_vertex)
+{
+	DWL_INSTRUMENT_STAGE(instrumentation_, SUCCESSORS);
+	successors.clear();
+
+	// Updating the terrain view and obstacle grid if the terrain map changed
+	updateTerrainView(false);
 
-	// Evaluating every action (body motor primitives)
-	if (terrain_->isTerrainInformation()) {
-		unsigned int action_size = actions.size();
+	// Getting the start cell and yaw bin of the current state
+	Eigen::Vector3d current_state;
+	Key start_key;
+	unsigned short int start_key_yaw;
+	getStartCell(current_state, start_key, start_key_yaw, state_vertex);
+
+	// Getting the successors of the body motor primitives
+	const std::vector<PrimitiveSuccessor>& primitives =
+			getPrimitiveSuccessors(start_key_yaw, start_key);
+
+	// Evaluating every action (body motor primitives), the lazy successors are evaluated when
+	// the search pops them
+	if (terrain_view_->isTerrainInformation() && is_lazy_evaluation_)
+		getLazySuccessors(successors, primitives, start_key);
+	else if (terrain_view_->isTerrainInformation()) {
+		std::vector<double>& body_costs = body_cost_buffer_;
+		std::vector<environment::FeatureState>& feature_states = feature_state_buffer_;
+		std::vector<unsigned int>& successor_actions = successor_action_buffer_;
+		body_costs.clear();
+		feature_states.clear();
+		successor_actions.clear();
+
+		unsigned int action_size = primitives.size();
 		for (unsigned int i = 0; i < action_size; i++) {
-			// Converting the action to current vertex
+			const PrimitiveSuccessor& primitive = primitives[i];
+
+			// Getting the key of the successor cell
+			int key_x = start_key.x + primitive.dx;
+			int key_y = start_key.y + primitive.dy;
+			if ((key_x < 0) || (key_x > 0xffff) || (key_y < 0) || (key_y > 0xffff))
+				continue;
+
+			Key terrain_key;
+			terrain_key.x = key_x;
+			terrain_key.y = key_y;
+
+			// Getting the state vertex of the successor
 			Eigen::Vector3d action_state;
-			action_state << actions[i].pose.position, actions[i].pose.orientation;
-			Vertex current_action_vertex, terrain_vertex;
+			terrain_->getTerrainSpaceModel().keyToState(action_state(0), terrain_key.x, true);
+			terrain_->getTerrainSpaceModel().keyToState(action_state(1), terrain_key.y, true);
+			action_state(2) = primitive.yaw;
+			Vertex current_action_vertex;
 			terrain_->getTerrainSpaceModel().stateToVertex(current_action_vertex, action_state);
 
-			// Converting state vertex to environment vertex
-			terrain_->getTerrainSpaceModel().stateVertexToEnvironmentVertex(terrain_vertex,
-					current_action_vertex, XY_Y);
-
-			// Computing the current action
-			current_action_ = action_state - current_state;
+			// Getting the current action
+			current_action_ = primitive.action;
 
 			// Checks if there is an obstacle
-			if (isFreeOfObstacle(current_action_vertex, XY_Y, true)) {
-				if (!isStanceAdjacency()) {
-					double terrain_cost;
-					if (terrain_->getTerrainDataMap().count(terrain_vertex) == 0)
-						terrain_cost = uncertainty_factor_ * terrain_->getAverageCostOfTerrain();
-					else
-						terrain_cost = terrain_->getTerrainCost(terrain_vertex);
-
-					successors.push_back(Edge(current_action_vertex, terrain_cost));
-				} else {
-					// Computing the body cost
-					double body_cost;
-					computeBodyCost(body_cost, action_state);
-					body_cost += actions[i].cost;
-					successors.push_back(Edge(current_action_vertex, body_cost));
+			bool is_free;
+			{
+				DWL_INSTRUMENT_STAGE(instrumentation_, OBSTACLE_CHECK);
+				is_free = isFreeOfObstacle(current_action_vertex, XY_Y, true);
+			}
+			if (!is_free) {
+				DWL_INSTRUMENT_COUNT(instrumentation_, REJECTED_PRIMITIVES, 1);
+				continue;
+			}
+
+			if (!isStanceAdjacency()) {
+				double terrain_cost;
+				if (!terrain_view_->getCost(terrain_cost, terrain_key.x, terrain_key.y))
+					terrain_cost = uncertainty_factor_ * terrain_view_->getAverageCost();
+
+				successors.push_back(Edge(current_action_vertex, terrain_cost));
+			} else {
+				// Computing the terrain cost of the body, the features are computed in batch
+				double terrain_cost;
+				computeStanceCost(terrain_cost, terrain_key, primitive.key_yaw);
+				body_costs.push_back(terrain_cost);
+				successor_actions.push_back(i);
+				successors.push_back(Edge(current_action_vertex, 0));
+
+				if (!features_.empty()) {
+					environment::FeatureState feature_state;
+					feature_state.pose.position = current_state.head(2) + primitive.action.head(2);
+					feature_state.pose.orientation = current_state(2) + primitive.action(2);
+					feature_state.body_action = current_action_;
+					feature_states.push_back(feature_state);
 				}
 			}
 		}
+
+		// Computing the cost of the body features for all the successors
+		if (isStanceAdjacency()) {
+			computeFeatureCosts(body_costs, feature_states);
+			for (std::size_t k = 0; k < successors.size(); k++)
+				successors[k].weight = body_costs[k] + primitives[successor_actions[k]].cost;
+		}
 	} else
 		printf(RED "Could not computed the successors because there is not terrain information \n"
 				COLOR_RESET);
 }
 
 
-void LatticeBasedBodyAdjacency::computeBodyCost(double& cost,
-												Eigen::Vector3d state)
+void LatticeBasedBodyAdjacency::setLazyEvaluation(bool is_lazy)
 {
-	// Getting the stance areas according to the action
-	stance_areas_ = robot_->getFootstepSearchAreas(current_action_);
-
-	// Computing the terrain cost
-	double terrain_cost = 0;
-	unsigned int area_size = stance_areas_.size();
-	for (unsigned int n = 0; n < area_size; n++) {
-		// Computing the boundary of stance area
-		Eigen::Vector2d boundary_min, boundary_max;
-		boundary_min(0) = stance_areas_[n].min_x + state(0);
-		boundary_min(1) = stance_areas_[n].min_y + state(1);
-		boundary_max(0) = stance_areas_[n].max_x + state(0);
-		boundary_max(1) = stance_areas_[n].max_y + state(1);
-
-		// Computing the stance cost
-		std::set< std::pair<Weight, Vertex>, pair_first_less<Weight, Vertex> > stance_cost_queue;
-		double stance_cost = 0;
-		double resolution = stance_areas_[n].resolution;
-		for (double y = boundary_min(1); y <= boundary_max(1); y += resolution) {
-			for (double x = boundary_min(0); x <= boundary_max(0); x += resolution) {
-				// Computing the rotated coordinate according to the orientation of the body
-				Eigen::Vector2d point_position;
-				double current_x = state(0);
-				double current_y = state(1);
-				double current_yaw = state(2);
-				point_position(0) = (x - current_x) * cos(current_yaw) -
-						(y - current_y) * sin(current_yaw) + current_x;
-				point_position(1) = (x - current_x) * sin(current_yaw) +
-						(y - current_y) * cos(current_yaw) + current_y;
-
-				Vertex current_2d_vertex;
-				terrain_->getTerrainSpaceModel().coordToVertex(current_2d_vertex, point_position);
-
-				// Inserts the element in an organized vertex queue, according to the maximum value
-				if (terrain_->getTerrainDataMap().count(current_2d_vertex) > 0) {
-					stance_cost_queue.insert(std::pair<Weight, Vertex>(
-							terrain_->getTerrainCost(current_2d_vertex),
-							current_2d_vertex));
-				}
-			}
-		}
+	is_lazy_evaluation_ = is_lazy;
+}
+
 
-		// Averaging the 5-best (lowest) cost
-		unsigned int number_top_cost = number_top_cost_;
-		if (stance_cost_queue.size() < number_top_cost)
-			number_top_cost = stance_cost_queue.size();
+bool LatticeBasedBodyAdjacency::isLazyEvaluation() const
+{
+	return is_lazy_evaluation_;
+}
 
-		if (number_top_cost == 0) {
-			stance_cost += uncertainty_factor_ * terrain_->getAverageCostOfTerrain();
+
+bool LatticeBasedBodyAdjacency::evaluateEdge(Weight& cost,
+											 Vertex source,
+											 Vertex target)
+{
+	DWL_INSTRUMENT_COUNT(instrumentation_, EVALUATED_EDGES, 1);
+	cost = std::numeric_limits<Weight>::max();
+
+	// Updating the terrain view and obstacle grid if the terrain map changed
+	updateTerrainView(false);
+	if (!terrain_view_->isTerrainInformation())
+		return false;
+
+	// Getting the start cell and yaw bin of the source state
+	Eigen::Vector3d current_state;
+	Key start_key;
+	unsigned short int start_key_yaw;
+	getStartCell(current_state, start_key, start_key_yaw, source);
+
+	// Getting the cell and yaw bin of the target state
+	Eigen::Vector3d target_state;
+	Key target_key;
+	unsigned short int target_key_yaw;
+	getStartCell(target_state, target_key, target_key_yaw, target);
+
+	// Checks if there is an obstacle, the footprint only depends on the target state
+	bool is_free;
+	{
+		DWL_INSTRUMENT_STAGE(instrumentation_, OBSTACLE_CHECK);
+		is_free = isFreeOfObstacle(target, XY_Y, true);
+	}
+	if (!is_free) {
+		DWL_INSTRUMENT_COUNT(instrumentation_, REJECTED_PRIMITIVES, 1);
+		return false;
+	}
+
+	// Evaluating the primitives that reach the target state, the edge has the cost of the
+	// cheapest one
+	const std::vector<PrimitiveSuccessor>& primitives =
+			getPrimitiveSuccessors(start_key_yaw, start_key);
+	bool is_reachable = false;
+	for (unsigned int i = 0; i < primitives.size(); i++) {
+		const PrimitiveSuccessor& primitive = primitives[i];
+		if ((start_key.x + primitive.dx != target_key.x) ||
+				(start_key.y + primitive.dy != target_key.y) ||
+				(primitive.key_yaw != target_key_yaw))
+			continue;
+
+		// Getting the current action
+		current_action_ = primitive.action;
+
+		double edge_cost;
+		if (!isStanceAdjacency()) {
+			if (!terrain_view_->getCost(edge_cost, target_key.x, target_key.y))
+				edge_cost = uncertainty_factor_ * terrain_view_->getAverageCost();
 		} else {
-			for (unsigned int i = 0; i < number_top_cost; i++) {
-				stance_cost += stance_cost_queue.begin()->first;
-				stance_cost_queue.erase(stance_cost_queue.begin());
+			// Computing the terrain cost of the body and the cost of the body features
+			double terrain_cost;
+			computeStanceCost(terrain_cost, target_key, primitive.key_yaw);
+			body_cost_buffer_.assign(1, terrain_cost);
+			feature_state_buffer_.clear();
+			if (!features_.empty()) {
+				environment::FeatureState feature_state;
+				feature_state.pose.position = current_state.head(2) + primitive.action.head(2);
+				feature_state.pose.orientation = current_state(2) + primitive.action(2);
+				feature_state.body_action = current_action_;
+				feature_state_buffer_.push_back(feature_state);
 			}
+			computeFeatureCosts(body_cost_buffer_, feature_state_buffer_);
+			edge_cost = body_cost_buffer_[0] + primitive.cost;
+		}
+
+		if (!is_reachable || (edge_cost < cost))
+			cost = edge_cost;
+		is_reachable = true;
+	}
+
+	return is_reachable;
+}
+
 
-			stance_cost /= number_top_cost;
+BodyCostCache& LatticeBasedBodyAdjacency::getBodyCostCache()
+{
+	return body_cost_cache_;
+}
+
+
+void LatticeBasedBodyAdjacency::addFeature(environment::Feature* feature)
+{
+	feature_adapters_.push_back(new environment::FeatureAdapter(feature));
+	addFeature(feature_adapters_.back());
+}
+
+
+void LatticeBasedBodyAdjacency::addFeature(environment::BatchFeature* feature)
+{
+	double weight;
+	feature->getWeight(weight);
+	printf(BLUE "Adding the %s feature with a weight of %f to the %s adjacency model\n"
+			COLOR_RESET, feature->getName().c_str(), weight, name_.c_str());
+	instrumentation_.setFeatureName(features_.size(), feature->getName());
+	features_.push_back(feature);
+}
+
+
+AdjacencyInstrumentation& LatticeBasedBodyAdjacency::getInstrumentation()
+{
+	return instrumentation_;
+}
+
+
+const std::vector<PrimitiveSuccessor>& LatticeBasedBodyAdjacency::getPrimitiveSuccessors(unsigned short int key_yaw,
+																						 const Key& start_key)
+{
+	if (key_yaw >= primitive_successors_.size())
+		primitive_successors_.resize(key_yaw + 1);
+
+	std::vector<PrimitiveSuccessor>& successors = primitive_successors_[key_yaw];
+	if (successors.empty()) {
+		// Generating the actions from the reference start cell and the center of the yaw bin
+		Pose3d start_pose;
+		terrain_->getTerrainSpaceModel().keyToState(start_pose.position(0), start_key.x, true);
+		terrain_->getTerrainSpaceModel().keyToState(start_pose.position(1), start_key.y, true);
+		terrain_->getTerrainSpaceModel().keyToState(start_pose.orientation, key_yaw, false);
+
+		std::vector<Action3d> actions;
+		robot_->getBodyMotorPrimitive().generateActions(actions, start_pose);
+
+		// Getting the key deltas and end yaw bin of every action
+		for (std::size_t i = 0; i < actions.size(); i++) {
+			PrimitiveSuccessor successor;
+			unsigned short int key_x, key_y;
+			terrain_->getTerrainSpaceModel().stateToKey(key_x,
+					(double) actions[i].pose.position(0), true);
+			terrain_->getTerrainSpaceModel().stateToKey(key_y,
+					(double) actions[i].pose.position(1), true);
+			successor.dx = (int) key_x - (int) start_key.x;
+			successor.dy = (int) key_y - (int) start_key.y;
+
+			terrain_->getTerrainSpaceModel().stateToKey(successor.key_yaw,
+					(double) actions[i].pose.orientation, false);
+			terrain_->getTerrainSpaceModel().keyToState(successor.yaw, successor.key_yaw, false);
+
+			successor.action << actions[i].pose.position - start_pose.position,
+					actions[i].pose.orientation - start_pose.orientation;
+			successor.cost = actions[i].cost;
+
+			// Merging the primitive with the first one that reaches the same successor
+			successor.parallel_index = i;
+			successor.parallel_cost = successor.cost;
+			for (std::size_t j = 0; j < successors.size(); j++) {
+				PrimitiveSuccessor& parallel = successors[j];
+				if ((parallel.dx == successor.dx) && (parallel.dy == successor.dy) &&
+						(parallel.key_yaw == successor.key_yaw)) {
+					successor.parallel_index = j;
+					parallel.parallel_cost = std::min(parallel.parallel_cost, successor.cost);
+					break;
+				}
+			}
+			successors.push_back(successor);
 		}
+	}
+
+	return successors;
+}
+
+
+void LatticeBasedBodyAdjacency::getStartCell(Eigen::Vector3d& state,
+											 Key& start_key,
+											 unsigned short int& start_key_yaw,
+											 Vertex state_vertex)
+{
+	terrain_->getTerrainSpaceModel().vertexToState(state, state_vertex);
+	Vertex start_vertex;
+	terrain_->getTerrainSpaceModel().stateVertexToEnvironmentVertex(start_vertex, state_vertex, XY_Y);
+	terrain_->getTerrainSpaceModel().vertexToKey(start_key, start_vertex, true);
+	terrain_->getTerrainSpaceModel().stateToKey(start_key_yaw, (double) state(2), false);
+}
+
 
-		terrain_cost += stance_cost;
+void LatticeBasedBodyAdjacency::getLazySuccessors(std::vector<Edge>& successors,
+												  const std::vector<PrimitiveSuccessor>& primitives,
+												  const Key& start_key)
+{
+	// The stance cost is an average of terrain costs or the unknown cost, so it isn't lower than
+	// the minimum of both
+	double stance_bound = std::min(terrain_view_->getMinimumCost(),
+			uncertainty_factor_ * terrain_view_->getAverageCost());
+
+	unsigned int action_size = primitives.size();
+	for (unsigned int i = 0; i < action_size; i++) {
+		const PrimitiveSuccessor& primitive = primitives[i];
+		if (primitive.parallel_index != i)
+			continue;
+
+		// Getting the key of the successor cell
+		int key_x = start_key.x + primitive.dx;
+		int key_y = start_key.y + primitive.dy;
+		if ((key_x < 0) || (key_x > 0xffff) || (key_y < 0) || (key_y > 0xffff))
+			continue;
+
+		// Getting the state vertex of the successor
+		Eigen::Vector3d action_state;
+		terrain_->getTerrainSpaceModel().keyToState(action_state(0), key_x, true);
+		terrain_->getTerrainSpaceModel().keyToState(action_state(1), key_y, true);
+		action_state(2) = primitive.yaw;
+		Vertex current_action_vertex;
+		terrain_->getTerrainSpaceModel().stateToVertex(current_action_vertex, action_state);
+
+		// Getting the lower bound of the cost, the terrain cost is exact and cheap
+		double cost_bound;
+		if (!isStanceAdjacency()) {
+			if (!terrain_view_->getCost(cost_bound, key_x, key_y))
+				cost_bound = uncertainty_factor_ * terrain_view_->getAverageCost();
+		} else
+			cost_bound = stance_bound + primitive.parallel_cost;
+
+		successors.push_back(Edge(current_action_vertex, cost_bound));
 	}
-	terrain_cost /= stance_areas_.size();
+	DWL_INSTRUMENT_COUNT(instrumentation_, LAZY_EDGES, successors.size());
+}
 
 
-	// Getting robot and terrain information
-	RobotAndTerrain info;
-	info.body_action = current_action_;
-	info.pose.position = (Eigen::Vector2d) state.head(2);
-	info.pose.orientation = (double) state(2);
-	info.height_map = terrain_->getTerrainHeightMap();
-	info.resolution = terrain_->getResolution(true);
+void LatticeBasedBodyAdjacency::computeStanceCost(double& cost,
+												  const Key& terrain_key,
+												  unsigned short int key_yaw)
+{
+	DWL_INSTRUMENT_STAGE(instrumentation_, STANCE_COST);
+
+	// Getting the stance pattern according to the action
+	int pattern = robot_->getStancePattern(gait_state_, current_action_);
+
+	// Getting the stance stencil of the current yaw bin, it's computed from the precomputed
+	// stance areas only the first time that the yaw bin and stance pattern are evaluated
+	if (!stance_stencils_.isDefined(key_yaw, pattern)) {
+		double yaw;
+		terrain_->getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
+		stance_stencils_.compute(key_yaw, pattern, yaw,
+				robot_->getPatternFootstepSearchAreas(pattern));
+	}
+	const StanceStencil& stencil = stance_stencils_.getStencil(key_yaw, pattern);
+
+	// Getting the terrain cost from the cache, otherwise it's computed from the stance stencil
+	double terrain_cost;
+	double unknown_cost = uncertainty_factor_ * terrain_view_->getAverageCost();
+	uint64_t cache_key = BodyCostCache::getKey(terrain_key.x, terrain_key.y, key_yaw, pattern);
+	if (body_cost_cache_.find(terrain_cost, cache_key, unknown_cost))
+		DWL_INSTRUMENT_COUNT(instrumentation_, CACHE_HITS, 1);
+	else {
+		DWL_INSTRUMENT_COUNT(instrumentation_, CACHE_MISSES, 1);
+		DWL_INSTRUMENT_COUNT(instrumentation_, SAMPLED_CELLS, stencil.offsets.size());
+		terrain_cost = stance_cost_kernel_.computeTerrainCost(*terrain_view_, stencil,
+				terrain_key.x, terrain_key.y, number_top_cost_, unknown_cost);
+		body_cost_cache_.insert(cache_key, terrain_cost,
+				stance_cost_kernel_.getNumberOfUnknownFeet() > 0, unknown_cost);
+	}
 
-	// Computing the cost of the body features
 	cost = terrain_cost;
+}
+
+
+void LatticeBasedBodyAdjacency::computeFeatureCosts(std::vector<double>& costs,
+													const std::vector<environment::FeatureState>& states)
+{
 	unsigned int feature_size = features_.size();
+	if ((feature_size == 0) || states.empty())
+		return;
+
+	DWL_INSTRUMENT_STAGE(instrumentation_, FEATURE_COST);
+
+	// Borrowing the terrain information for the whole batch
+	environment::FeatureTerrain terrain;
+	terrain.height_map = &snapshot_reader_.getSnapshot().getHeightMap();
+	terrain.terrain_view = terrain_view_;
+	terrain.resolution = snapshot_reader_.getSnapshot().getResolution();
+
 	for (unsigned int i = 0; i < feature_size; i++) {
 		// Computing the cost associated with body path features
-		double feature_cost, weight;
-		features_[i]->computeCost(feature_cost, info);
+		double weight;
+		{
+			DWL_INSTRUMENT_FEATURE(instrumentation_, i);
+			features_[i]->computeCosts(feature_cost_buffer_, states, terrain);
+		}
 		features_[i]->getWeight(weight);
 
 		// Computing the cost of the body feature
-		cost += weight * feature_cost;
+		for (std::size_t k = 0; k < states.size(); k++)
+			costs[k] += weight * feature_cost_buffer_[k];
 	}
 }
 
@@ -189,79 +464,120 @@ bool LatticeBasedBodyAdjacency::isFreeOfObstacle(Vertex state_vertex,
 												 TypeOfState state_representation,
 												 bool body)
 {
-	// Getting the terrain obstacle map
-	ObstacleMap obstacle_map = terrain_->getObstacleMap();
-
-	// Converting the vertex to state (x,y,yaw)
-	Eigen::Vector3d state_3d;
-	Eigen::Vector2d state_2d;
-	double current_x, current_y, current_yaw;
-	if (state_representation == XY) {
-		terrain_->getObstacleSpaceModel().vertexToState(state_2d, state_vertex);
-		current_x = state_2d(0);
-		current_y = state_2d(1);
-		current_yaw = 0;
+	if (!obstacle_grid_->isObstacleInformation())
+		return true;
+
+	if (body) {
+		// Converting the vertex to state (x,y,yaw)
+		Eigen::Vector2d position;
+		double yaw;
+		if (state_representation == XY) {
+			terrain_->getObstacleSpaceModel().vertexToState(position, state_vertex);
+			yaw = 0;
+		} else {
+			Eigen::Vector3d state_3d;
+			terrain_->getObstacleSpaceModel().vertexToState(state_3d, state_vertex);
+			position = state_3d.head(2);
+			yaw = state_3d(2);
+		}
+
+		// Getting the obstacle cell of the body position
+		Vertex body_vertex;
+		Key body_key;
+		terrain_->getObstacleSpaceModel().coordToVertex(body_vertex, position);
+		terrain_->getObstacleSpaceModel().vertexToKey(body_key, body_vertex, true);
+
+		// Checking if the body footprint, for the current orientation, collides
+		unsigned short int key_yaw;
+		terrain_->getObstacleSpaceModel().stateToKey(key_yaw, yaw, false);
+		return !obstacle_grid_->isColliding(getBodyFootprint(key_yaw), body_key.x, body_key.y);
 	} else {
-		terrain_->getObstacleSpaceModel().vertexToState(state_3d, state_vertex);
-		current_x = state_3d(0);
-		current_y = state_3d(1);
-		current_yaw = state_3d(2);
+		// Converting the state vertex to terrain vertex
+		Vertex terrain_vertex;
+		Key terrain_key;
+		terrain_->getObstacleSpaceModel().stateVertexToEnvironmentVertex(terrain_vertex,
+				state_vertex, state_representation);
+		terrain_->getObstacleSpaceModel().vertexToKey(terrain_key, terrain_vertex, true);
+
+		return !obstacle_grid_->isOccupied(terrain_key.x, terrain_key.y);
 	}
+}
 
-	bool is_free = true;
-	if (terrain_->isObstacleInformation()) {
-		if (body) {
-			// Getting the body area of the robot
-			SearchArea body_workspace = robot_->getPredefinedBodyWorkspace();
-
-			// Computing the boundary of stance area
-			Eigen::Vector2d boundary_min, boundary_max;
-			boundary_min(0) = body_workspace.min_x + current_x;
-			boundary_min(1) = body_workspace.min_y + current_y;
-			boundary_max(0) = body_workspace.max_x + current_x;
-			boundary_max(1) = body_workspace.max_y + current_y;
-
-			// Getting the resolution of the obstacle map
-			double obstacle_resolution = terrain_->getObstacleResolution();
-			if (body_workspace.resolution > obstacle_resolution)
-				obstacle_resolution = body_workspace.resolution;
-
-			for (double y = boundary_min(1); y <= boundary_max(1); y += obstacle_resolution) {
-				for (double x = boundary_min(0); x <= boundary_max(0); x += obstacle_resolution) {
-					// Computing the rotated coordinate according to the orientation of the body
-					Eigen::Vector2d point_position;
-					point_position(0) = (x - current_x) * cos(current_yaw) -
-							(y - current_y) * sin(current_yaw) + current_x;
-					point_position(1) = (x - current_x) * sin(current_yaw) +
-							(y - current_y) * cos(current_yaw) + current_y;
-
-					Vertex current_2d_vertex;
-					terrain_->getObstacleSpaceModel().coordToVertex(current_2d_vertex, point_position);
-
-					// Checking if there is an obstacle
-					if (obstacle_map.count(current_2d_vertex) > 0) {
-						if (obstacle_map.find(current_2d_vertex)->second) {
-							is_free = false;
-							goto found_obstacle;
-						}
-					}
-				}
-			}
-		} else {
-			// Converting the state vertex to terrain vertex
-			Vertex terrain_vertex;
-			terrain_->getObstacleSpaceModel().stateVertexToEnvironmentVertex(terrain_vertex,
-					state_vertex, state_representation);
-
-			if (obstacle_map.count(terrain_vertex) > 0) {
-				if (obstacle_map.find(terrain_vertex)->second)
-					is_free = false;
-			}
-		}
+
+const environment::FootprintMask& LatticeBasedBodyAdjacency::getBodyFootprint(unsigned short int key_yaw)
+{
+	if (key_yaw >= body_footprints_.size())
+		body_footprints_.resize(key_yaw + 1);
+
+	environment::FootprintMask& footprint = body_footprints_[key_yaw];
+	if (!footprint.isDefined()) {
+		// Getting the orientation of the yaw bin
+		double yaw;
+		terrain_->getObstacleSpaceModel().keyToState(yaw, key_yaw, false);
+
+		// Getting the body area of the robot
+		const SearchArea& body_workspace = robot_->getPredefinedBodyWorkspace();
+
+		// Getting the resolution of the obstacle map
+		double obstacle_resolution = terrain_->getObstacleResolution();
+		double step = obstacle_resolution;
+		if (body_workspace.resolution > step)
+			step = body_workspace.resolution;
+
+		std::vector<environment::CellOffset> offsets;
+		environment::FootprintMask::rasterize(offsets, body_workspace, yaw, step,
+				obstacle_resolution);
+		footprint.reset(offsets);
 	}
 
-	found_obstacle:
-	return is_free;
+	return footprint;
+}
+
+
+void LatticeBasedBodyAdjacency::updateTerrainView(bool is_forced)
+{
+	bool is_view_changed = snapshot_reader_.update(terrain_, is_forced);
+	terrain_view_ = &snapshot_reader_.getSnapshot().getTerrainView();
+	obstacle_grid_ = &snapshot_reader_.getSnapshot().getObstacleGrid();
+	if (!is_view_changed)
+		return;
+
+	// Invalidating the cached costs of the states whose stance areas overlap the changed cells
+	int min_x, min_y, max_x, max_y;
+	if (snapshot_reader_.getDirtyRegion(min_x, min_y, max_x, max_y)) {
+		int reach = stance_stencils_.getReach();
+		body_cost_cache_.invalidate(min_x - reach, min_y - reach, max_x + reach, max_y + reach);
+	} else
+		body_cost_cache_.invalidateAll();
+}
+
+
+void LatticeBasedBodyAdjacency::setTerrainSnapshots(environment::TerrainSnapshotBuffer* snapshots)
+{
+	// The versions of the views of different buffers aren't related
+	snapshot_reader_.setSharedSnapshots(snapshots);
+	if (terrain_ != NULL)
+		updateTerrainView(true);
+}
+
+
+void LatticeBasedBodyAdjacency::pinTerrainSnapshot()
+{
+	snapshot_reader_.release();
+	updateTerrainView(true);
+	snapshot_reader_.pin();
+}
+
+
+void LatticeBasedBodyAdjacency::releaseTerrainSnapshot()
+{
+	snapshot_reader_.release();
+}
+
+
+void LatticeBasedBodyAdjacency::notifyTerrainChanged()
+{
+	snapshot_reader_.notifyChanged();
 }
 
 
@@ -0,0 +1,60 @@
+#include <dwl/model/NeighborStencil.h>
+#include <algorithm>
+#include <cstdlib>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+/**
+ * @brief Search directions of the grid. The first 8 are the directions of the 8-connected grid,
+ * in the order of the original search, the next 8 complete the 16-connected grid and the last 16
+ * complete the 32-connected grid. Every direction is followed by its opposite
+ */
+static const int DIRECTIONS[32][2] = {
+		{1,0}, {-1,0}, {0,1}, {0,-1}, {1,1}, {-1,-1}, {-1,1}, {1,-1},
+		{2,1}, {-2,-1}, {1,2}, {-1,-2}, {-1,2}, {1,-2}, {-2,1}, {2,-1},
+		{3,1}, {-3,-1}, {1,3}, {-1,-3}, {-1,3}, {1,-3}, {-3,1}, {3,-1},
+		{3,2}, {-3,-2}, {2,3}, {-2,-3}, {-2,3}, {2,-3}, {-3,2}, {3,-2}};
+
+
+NeighborStencil::NeighborStencil() : connectivity_(0), reach_(0)
+{
+
+}
+
+
+NeighborStencil::~NeighborStencil()
+{
+
+}
+
+
+bool NeighborStencil::reset(unsigned int connectivity,
+							int neighboring_definition)
+{
+	if ((connectivity != 8) && (connectivity != 16) && (connectivity != 32)) {
+		printf(RED "Could not set a connectivity of %u directions, it has to be 8, 16 or 32"
+				" \n" COLOR_RESET, connectivity);
+		return false;
+	}
+
+	offsets_.clear();
+	reach_ = 0;
+	for (int r = 1; r <= neighboring_definition; r++) {
+		for (unsigned int d = 0; d < connectivity; d++) {
+			NeighborOffset offset(r * DIRECTIONS[d][0], r * DIRECTIONS[d][1], d);
+			offsets_.push_back(offset);
+			reach_ = std::max(reach_, std::max(abs(offset.dx), abs(offset.dy)));
+		}
+	}
+	connectivity_ = connectivity;
+
+	return true;
+}
+
+} //@namespace model
+} //@namespace dwl
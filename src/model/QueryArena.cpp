@@ -0,0 +1,107 @@
+#include <dwl/model/QueryArena.h>
+#include <algorithm>
+#include <new>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+QueryArena::QueryArena(std::size_t block_size) : current_block_(0), offset_(0),
+		block_size_(block_size), used_size_(0)
+{
+	for (unsigned int i = 0; i < NUM_SIZE_CLASSES; i++)
+		free_lists_[i] = NULL;
+}
+
+
+QueryArena::~QueryArena()
+{
+	for (std::size_t i = 0; i < blocks_.size(); i++)
+		::operator delete(blocks_[i]);
+}
+
+
+void* QueryArena::allocate(std::size_t size)
+{
+	unsigned int size_class = getSizeClass(size);
+	if (free_lists_[size_class] != NULL) {
+		FreeChunk* chunk = free_lists_[size_class];
+		free_lists_[size_class] = chunk->next;
+		return chunk;
+	}
+
+	// Carving the chunk from the first block with enough free space, the blocks of the previous
+	// queries are reused
+	std::size_t chunk_size = MIN_CHUNK_SIZE << size_class;
+	while ((current_block_ < blocks_.size()) &&
+			(offset_ + chunk_size > block_sizes_[current_block_])) {
+		current_block_++;
+		offset_ = 0;
+	}
+	if (current_block_ == blocks_.size()) {
+		std::size_t block_size = std::max(block_size_, chunk_size);
+		blocks_.push_back(static_cast<char*>(::operator new(block_size)));
+		block_sizes_.push_back(block_size);
+		offset_ = 0;
+	}
+
+	void* chunk = blocks_[current_block_] + offset_;
+	offset_ += chunk_size;
+	used_size_ += chunk_size;
+	return chunk;
+}
+
+
+void QueryArena::deallocate(void* chunk,
+							std::size_t size)
+{
+	if (chunk == NULL)
+		return;
+
+	unsigned int size_class = getSizeClass(size);
+	FreeChunk* free_chunk = static_cast<FreeChunk*>(chunk);
+	free_chunk->next = free_lists_[size_class];
+	free_lists_[size_class] = free_chunk;
+}
+
+
+void QueryArena::reset()
+{
+	current_block_ = 0;
+	offset_ = 0;
+	used_size_ = 0;
+	for (unsigned int i = 0; i < NUM_SIZE_CLASSES; i++)
+		free_lists_[i] = NULL;
+}
+
+
+std::size_t QueryArena::getUsedSize() const
+{
+	return used_size_;
+}
+
+
+std::size_t QueryArena::getCapacity() const
+{
+	std::size_t capacity = 0;
+	for (std::size_t i = 0; i < block_sizes_.size(); i++)
+		capacity += block_sizes_[i];
+
+	return capacity;
+}
+
+
+unsigned int QueryArena::getSizeClass(std::size_t size)
+{
+	unsigned int size_class = 0;
+	while ((MIN_CHUNK_SIZE << size_class) < size)
+		size_class++;
+
+	return size_class;
+}
+
+} //@namespace model
+} //@namespace dwl
@@ -0,0 +1,162 @@
+#include <dwl/model/StanceCostField.h>
+#include <algorithm>
+#include <set>
+#include <thread>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+StanceCostField::StanceCostField() : min_key_x_(0), min_key_y_(0), size_x_(0), size_y_(0),
+		view_version_(0), number_top_cost_(0), is_computed_(false)
+{
+
+}
+
+
+StanceCostField::~StanceCostField()
+{
+
+}
+
+
+void StanceCostField::compute(const environment::DenseTerrainView& terrain_view,
+							  const StanceStencil& stencil,
+							  unsigned int number_top_cost,
+							  double unknown_cost,
+							  unsigned int num_threads)
+{
+	// Getting the sliding window of every foot
+	unsigned int num_feet = stencil.foot_begin.size() - 1;
+	windows_.resize(num_feet);
+	for (unsigned int n = 0; n < num_feet; n++) {
+		FootWindow& window = windows_[n];
+		window.offsets.assign(stencil.offsets.begin() + stencil.foot_begin[n],
+				stencil.offsets.begin() + stencil.foot_begin[n + 1]);
+
+		std::set<std::pair<int, int> > cells;
+		for (std::size_t i = 0; i < window.offsets.size(); i++)
+			cells.insert(std::make_pair(window.offsets[i].dx, window.offsets[i].dy));
+
+		window.leaving.clear();
+		window.entering.clear();
+		for (std::size_t i = 0; i < window.offsets.size(); i++) {
+			const environment::CellOffset& offset = window.offsets[i];
+			if (cells.find(std::make_pair(offset.dx - 1, offset.dy)) == cells.end())
+				window.leaving.push_back(offset);
+			if (cells.find(std::make_pair(offset.dx + 1, offset.dy)) == cells.end())
+				window.entering.push_back(offset);
+		}
+	}
+
+	// Computing the field over the bounding box of the view
+	terrain_view.getBounds(min_key_x_, min_key_y_, size_x_, size_y_);
+	cost_.resize((std::size_t) size_x_ * size_y_);
+	is_unknown_cost_.resize((std::size_t) size_x_ * size_y_);
+
+	num_threads = std::max(std::min(num_threads, (unsigned int) size_y_), 1u);
+	if (num_threads == 1)
+		computeRows(terrain_view, 0, size_y_, number_top_cost, unknown_cost);
+	else {
+		std::vector<std::thread> threads;
+		for (unsigned int i = 0; i < num_threads; i++) {
+			int first_row = (long) size_y_ * i / num_threads;
+			int end_row = (long) size_y_ * (i + 1) / num_threads;
+			threads.push_back(std::thread(&StanceCostField::computeRows, this,
+					std::cref(terrain_view), first_row, end_row, number_top_cost, unknown_cost));
+		}
+		for (unsigned int i = 0; i < num_threads; i++)
+			threads[i].join();
+	}
+
+	view_version_ = terrain_view.getVersion();
+	number_top_cost_ = number_top_cost;
+	is_computed_ = true;
+}
+
+
+bool StanceCostField::isUpdated(unsigned int view_version,
+								unsigned int number_top_cost) const
+{
+	return is_computed_ && (view_version_ == view_version) &&
+			(number_top_cost_ == number_top_cost);
+}
+
+
+void StanceCostField::computeRows(const environment::DenseTerrainView& terrain_view,
+								  int first_row,
+								  int end_row,
+								  unsigned int number_top_cost,
+								  double unknown_cost)
+{
+	unsigned int num_feet = windows_.size();
+	std::vector<std::vector<double> > window_costs(num_feet);
+	for (int y = first_row; y < end_row; y++) {
+		int key_y = min_key_y_ + y;
+		for (int x = 0; x < size_x_; x++) {
+			int key_x = min_key_x_ + x;
+			double terrain_cost = 0;
+			bool is_unknown_cost = false;
+			for (unsigned int n = 0; n < num_feet; n++) {
+				const FootWindow& window = windows_[n];
+				std::vector<double>& costs = window_costs[n];
+
+				if (x == 0) {
+					// Gathering the whole window at the beginning of the row
+					costs.clear();
+					for (std::size_t i = 0; i < window.offsets.size(); i++) {
+						int index = terrain_view.getIndex(key_x + window.offsets[i].dx,
+								key_y + window.offsets[i].dy);
+						if ((index >= 0) && terrain_view.isValid(index))
+							costs.push_back(terrain_view.getCost(index));
+					}
+					std::sort(costs.begin(), costs.end());
+				} else {
+					// Sliding the window one cell
+					for (std::size_t i = 0; i < window.leaving.size(); i++) {
+						int index = terrain_view.getIndex(key_x - 1 + window.leaving[i].dx,
+								key_y + window.leaving[i].dy);
+						if ((index >= 0) && terrain_view.isValid(index))
+							costs.erase(std::lower_bound(costs.begin(), costs.end(),
+									terrain_view.getCost(index)));
+					}
+					for (std::size_t i = 0; i < window.entering.size(); i++) {
+						int index = terrain_view.getIndex(key_x + window.entering[i].dx,
+								key_y + window.entering[i].dy);
+						if ((index >= 0) && terrain_view.isValid(index)) {
+							double cost = terrain_view.getCost(index);
+							costs.insert(std::upper_bound(costs.begin(), costs.end(), cost), cost);
+						}
+					}
+				}
+
+				// Averaging the best distinct costs in ascending order, the window keeps the equal
+				// costs for removing them later
+				if (costs.empty() || (number_top_cost == 0)) {
+					terrain_cost += unknown_cost;
+					is_unknown_cost = true;
+				} else {
+					double stance_cost = costs[0];
+					unsigned int num_best = 1;
+					for (std::size_t k = 1; (k < costs.size()) && (num_best < number_top_cost); k++) {
+						if (costs[k] != costs[k - 1]) {
+							stance_cost += costs[k];
+							num_best++;
+						}
+					}
+					terrain_cost += stance_cost / num_best;
+				}
+			}
+
+			int index = y * size_x_ + x;
+			cost_[index] = terrain_cost / num_feet;
+			is_unknown_cost_[index] = is_unknown_cost;
+		}
+	}
+}
+
+} //@namespace model
+} //@namespace dwl
@@ -0,0 +1,136 @@
+#include <dwl/model/StanceCostKernel.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+StanceCostKernel::StanceCostKernel() : num_unknown_feet_(0)
+{
+
+}
+
+
+StanceCostKernel::~StanceCostKernel()
+{
+
+}
+
+
+double StanceCostKernel::computeTerrainCost(const environment::DenseTerrainView& terrain_view,
+											const StanceStencil& stencil,
+											int key_x,
+											int key_y,
+											unsigned int number_top_cost,
+											double unknown_cost)
+{
+	if (costs_.size() < stencil.offsets.size())
+		costs_.resize(stencil.offsets.size());
+
+	double terrain_cost = 0;
+	num_unknown_feet_ = 0;
+	unsigned int num_feet = stencil.foot_begin.size() - 1;
+	for (unsigned int n = 0; n < num_feet; n++) {
+		// Gathering the costs of the cells with terrain information
+		unsigned int size = 0;
+		for (unsigned int k = stencil.foot_begin[n]; k < stencil.foot_begin[n + 1]; k++) {
+			int index = terrain_view.getIndex(key_x + stencil.offsets[k].dx,
+					key_y + stencil.offsets[k].dy);
+			if ((index >= 0) && terrain_view.isValid(index))
+				costs_[size++] = terrain_view.getCost(index);
+		}
+
+		if ((size == 0) || (number_top_cost == 0))
+			num_unknown_feet_++;
+
+		terrain_cost += computeTopCostAverage(costs_.data(), size, number_top_cost, unknown_cost);
+	}
+
+	return terrain_cost / num_feet;
+}
+
+
+unsigned int StanceCostKernel::getNumberOfUnknownFeet() const
+{
+	return num_unknown_feet_;
+}
+
+
+double StanceCostKernel::computeTopCostAverage(const double* costs,
+											   unsigned int size,
+											   unsigned int number_top_cost,
+											   double unknown_cost)
+{
+	if ((size == 0) || (number_top_cost == 0))
+		return unknown_cost;
+
+	if (best_costs_.size() < number_top_cost)
+		best_costs_.resize(number_top_cost);
+
+	// Filling the set of best costs
+	unsigned int num_best = 0;
+	unsigned int i = 0;
+	for (; (i < size) && (num_best < number_top_cost); i++)
+		insertBestCost(costs[i], num_best, number_top_cost);
+
+	// Selecting the rest of the best costs, only the costs below the k-th best cost are inserted
+	// (an equal cost is merged with it)
+#ifdef __AVX2__
+	for (; i + 4 <= size; i += 4) {
+		__m256d threshold = _mm256_set1_pd(best_costs_[number_top_cost - 1]);
+		__m256d values = _mm256_loadu_pd(costs + i);
+		int mask = _mm256_movemask_pd(_mm256_cmp_pd(values, threshold, _CMP_LT_OQ));
+		if (mask == 0)
+			continue;
+
+		for (unsigned int j = 0; j < 4; j++) {
+			if ((mask >> j) & 1)
+				insertBestCost(costs[i + j], num_best, number_top_cost);
+		}
+	}
+#endif
+	for (; i < size; i++)
+		insertBestCost(costs[i], num_best, number_top_cost);
+
+	// Averaging the best costs in ascending order
+	double stance_cost = 0;
+	for (unsigned int k = 0; k < num_best; k++)
+		stance_cost += best_costs_[k];
+
+	return stance_cost / num_best;
+}
+
+
+void StanceCostKernel::insertBestCost(double cost,
+									  unsigned int& num_best,
+									  unsigned int number_top_cost)
+{
+	// Finding the position that keeps the buffer sorted
+	unsigned int position = num_best;
+	while ((position > 0) && (cost < best_costs_[position - 1]))
+		position--;
+
+	// Merging the equal costs, the queue of the stance cost is ordered (and so unique) by cost
+	if ((position > 0) && (best_costs_[position - 1] == cost))
+		return;
+
+	if (num_best == number_top_cost) {
+		if (position == num_best)
+			return;
+	} else
+		num_best++;
+
+	// Shifting the worse costs, the worst one is dropped if the buffer is full
+	for (unsigned int k = num_best - 1; k > position; k--)
+		best_costs_[k] = best_costs_[k - 1];
+	best_costs_[position] = cost;
+}
+
+} //@namespace model
+} //@namespace dwl
@@ -0,0 +1,73 @@
+#include <dwl/model/StanceStencils.h>
+#include <algorithm>
+
+
+namespace dwl
+{
+
+namespace model
+{
+
+StanceStencils::StanceStencils() : resolution_(0), reach_(0)
+{
+
+}
+
+
+StanceStencils::~StanceStencils()
+{
+
+}
+
+
+void StanceStencils::reset(double resolution)
+{
+	stencils_.clear();
+	resolution_ = resolution;
+	reach_ = 0;
+}
+
+
+void StanceStencils::compute(unsigned short int key_yaw,
+							 int pattern,
+							 double yaw,
+							 const SearchAreaMap& stance_areas)
+{
+	std::size_t index = (std::size_t) key_yaw * robot::Robot::NUM_STANCE_PATTERNS + pattern;
+	if (index >= stencils_.size())
+		stencils_.resize(index + 1);
+
+	StanceStencil& stencil = stencils_[index];
+	stencil.offsets.clear();
+	stencil.foot_begin.clear();
+
+	// Rasterizing the stance area of every foot
+	std::vector<environment::CellOffset> foot_offsets;
+	for (SearchAreaMap::const_iterator area_iter = stance_areas.begin();
+			area_iter != stance_areas.end(); area_iter++) {
+		const SearchArea& area = area_iter->second;
+		environment::FootprintMask::rasterize(foot_offsets, area, yaw, area.resolution,
+				resolution_);
+
+		stencil.foot_begin.push_back(stencil.offsets.size());
+		stencil.offsets.insert(stencil.offsets.end(), foot_offsets.begin(), foot_offsets.end());
+	}
+	stencil.foot_begin.push_back(stencil.offsets.size());
+	stencil.is_defined = true;
+
+	// Updating the reach of the stencils
+	for (std::size_t i = 0; i < stencil.offsets.size(); i++) {
+		int reach = std::max(abs(stencil.offsets[i].dx), abs(stencil.offsets[i].dy));
+		if (reach > reach_)
+			reach_ = reach;
+	}
+}
+
+
+int StanceStencils::getReach() const
+{
+	return reach_;
+}
+
+} //@namespace model
+} //@namespace dwl
@@ -67,5 +67,17 @@ void BodyMotorPrimitives::generateActions(std::vector<Action3d>& actions,
 	}
 }
 
+const std::vector<BodyMotorPrimitive>& BodyMotorPrimitives::getPrimitives() const
+{
+	return actions_;
+}
+
+
+void BodyMotorPrimitives::setPrimitives(const std::vector<BodyMotorPrimitive>& primitives)
+{
+	actions_ = primitives;
+	is_defined_motor_primitives_ = true;
+}
+
 } //@namespace behavior
 } //@namespace dwl
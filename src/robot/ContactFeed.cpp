@@ -0,0 +1,123 @@
+#include <dwl/robot/ContactFeed.h>
+
+
+namespace dwl
+{
+
+namespace robot
+{
+
+ContactFeed::ContactFeed() : sequence_(0), estimated_ground_(0)
+{
+	for (unsigned int i = 0; i < SAMPLE_SIZE; i++)
+		sample_[i].store(0., std::memory_order_relaxed);
+}
+
+
+ContactFeed::~ContactFeed()
+{
+
+}
+
+
+void ContactFeed::publish(const Pose& pose,
+						  const Contact* contacts,
+						  unsigned int num_contacts)
+{
+	if (num_contacts > MAX_CONTACTS)
+		num_contacts = MAX_CONTACTS;
+
+	// Updating the estimated ground, it's kept if there isn't any contact
+	if (num_contacts > 0) {
+		double ground = 0;
+		for (unsigned int i = 0; i < num_contacts; i++)
+			ground += contacts[i].position(2);
+		estimated_ground_ = ground / num_contacts;
+	}
+
+	// Marking the sample as being written, the readers retry until the sequence is even again
+	uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+	sequence_.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	unsigned int index = 0;
+	for (int k = 0; k < 3; k++)
+		sample_[index++].store(pose.position(k), std::memory_order_relaxed);
+	sample_[index++].store(pose.orientation.x(), std::memory_order_relaxed);
+	sample_[index++].store(pose.orientation.y(), std::memory_order_relaxed);
+	sample_[index++].store(pose.orientation.z(), std::memory_order_relaxed);
+	sample_[index++].store(pose.orientation.w(), std::memory_order_relaxed);
+	sample_[index++].store(estimated_ground_, std::memory_order_relaxed);
+	sample_[index++].store(num_contacts, std::memory_order_relaxed);
+	for (unsigned int i = 0; i < num_contacts; i++) {
+		sample_[index++].store(contacts[i].end_effector, std::memory_order_relaxed);
+		for (int k = 0; k < 3; k++)
+			sample_[index++].store(contacts[i].position(k), std::memory_order_relaxed);
+	}
+
+	sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+
+void ContactFeed::publish(const Pose& pose,
+						  const std::vector<Contact>& contacts)
+{
+	publish(pose, contacts.empty() ? NULL : &contacts[0], contacts.size());
+}
+
+
+uint64_t ContactFeed::read(GaitState& state,
+						   double& estimated_ground) const
+{
+	double sample[SAMPLE_SIZE];
+	uint64_t sequence;
+	unsigned int num_contacts;
+	while (true) {
+		sequence = sequence_.load(std::memory_order_acquire);
+		if (sequence & 1)
+			continue;
+
+		// Copying the header, and the contacts that are described by it
+		unsigned int index = 0;
+		for (; index < POSE_SIZE + 2; index++)
+			sample[index] = sample_[index].load(std::memory_order_relaxed);
+		num_contacts = sample[POSE_SIZE + 1];
+		if (num_contacts > MAX_CONTACTS)
+			num_contacts = MAX_CONTACTS;
+		for (; index < POSE_SIZE + 2 + CONTACT_SIZE * num_contacts; index++)
+			sample[index] = sample_[index].load(std::memory_order_relaxed);
+
+		// Retrying if the producer published while copying
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (sequence_.load(std::memory_order_relaxed) == sequence)
+			break;
+	}
+
+	// Converting the words of the sample
+	unsigned int index = 0;
+	for (int k = 0; k < 3; k++)
+		state.pose.position(k) = sample[index++];
+	state.pose.orientation.x() = sample[index++];
+	state.pose.orientation.y() = sample[index++];
+	state.pose.orientation.z() = sample[index++];
+	state.pose.orientation.w() = sample[index++];
+	estimated_ground = sample[index++];
+	index++;
+	state.contacts.resize(num_contacts);
+	for (unsigned int i = 0; i < num_contacts; i++) {
+		state.contacts[i].end_effector = sample[index++];
+		for (int k = 0; k < 3; k++)
+			state.contacts[i].position(k) = sample[index++];
+	}
+
+	return sequence / 2;
+}
+
+
+uint64_t ContactFeed::getVersion() const
+{
+	return sequence_.load(std::memory_order_acquire) / 2;
+}
+
+} //@namespace robot
+} //@namespace dwl
@@ -9,11 +9,12 @@ namespace dwl
 namespace robot
 {
 
-Robot::Robot() : body_behavior_(NULL), num_feet_(0), num_end_effectors_(0),
-		estimated_ground_from_body_(-0.55), last_past_foot_(1),
-		feet_lateral_offset_(0), displacement_(0)
+Robot::Robot() : last_past_foot_(1), contact_feed_version_(0), body_behavior_(NULL), num_feet_(0),
+		num_end_effectors_(0), estimated_ground_from_body_(-0.55), feet_lateral_offset_(0),
+		displacement_(0)
 {
 	body_behavior_ = new behavior::BodyMotorPrimitives();
+	updateStanceTables();
 }
 
 
@@ -153,36 +154,82 @@ void Robot::read(std::string filename)
 	// Reading the body work window
 	if (!yaml_reader_.read(body_workspace_, "body_workspace", properties_ns))
 		printf(YELLOW "Warning: the body workspace description was not read\n" COLOR_RESET);
+
+	// Precomputing the stances and stance areas of every stance pattern
+	updateStanceTables();
 }
 
 
 void Robot::setCurrentPose(const Pose& pose)
 {
-	current_pose_ = pose;
+	std::lock_guard<std::mutex> lock(update_mutex_);
+	std::shared_ptr<GaitState> state = std::make_shared<GaitState>(*loadGaitState());
+	state->pose = pose;
+	std::atomic_store(&gait_state_, std::shared_ptr<const GaitState>(state));
 }
 
 
 void Robot::setCurrentContacts(const std::vector<Contact>& contacts)
 {
-	current_contacts_ = contacts;
+	std::lock_guard<std::mutex> lock(update_mutex_);
+	std::shared_ptr<GaitState> state = std::make_shared<GaitState>(*loadGaitState());
+	state->contacts = contacts;
 
-	estimated_ground_from_body_ = 0;
+	double estimated_ground = 0;
 	for (int i = 0; i < num_feet_; i++) //TODO
-		estimated_ground_from_body_ += contacts[i].position(2);
+		estimated_ground += contacts[i].position(2);
+
+	estimated_ground /= num_feet_;
+
+	// The stances depend on the estimated ground, the previous table is kept by the gait states
+	// that were taken before
+	state->stance_table = computeStanceTable(estimated_ground);
+	std::atomic_store(&gait_state_, std::shared_ptr<const GaitState>(state));
+}
+
 
-	estimated_ground_from_body_ /= num_feet_;
+Pose Robot::getCurrentPose() const
+{
+	return loadGaitState()->pose;
+}
+
+
+std::vector<Contact> Robot::getCurrentContacts() const
+{
+	return loadGaitState()->contacts;
 }
 
 
-Pose Robot::getCurrentPose()
+GaitState Robot::getGaitState() const
 {
-	return current_pose_;
+	return *loadGaitState();
 }
 
 
-std::vector<Contact> Robot::getCurrentContacts()
+ContactFeed& Robot::getContactFeed()
 {
-	return current_contacts_;
+	return contact_feed_;
+}
+
+
+bool Robot::updateFromContactFeed()
+{
+	std::lock_guard<std::mutex> lock(update_mutex_);
+	if (contact_feed_.getVersion() == contact_feed_version_)
+		return false;
+
+	// Reading the last sample, the last swing foot and stance table of the gait state are kept
+	std::shared_ptr<GaitState> state = std::make_shared<GaitState>(*loadGaitState());
+	double estimated_ground;
+	contact_feed_version_ = contact_feed_.read(*state, estimated_ground);
+
+	// The stances depend on the estimated ground
+	if (!state->contacts.empty() &&
+			(estimated_ground != state->stance_table->estimated_ground_from_body))
+		state->stance_table = computeStanceTable(estimated_ground);
+
+	std::atomic_store(&gait_state_, std::shared_ptr<const GaitState>(state));
+	return true;
 }
 
 
@@ -192,19 +239,44 @@ behavior::MotorPrimitives& Robot::getBodyMotorPrimitive()
 }
 
 
-SearchArea Robot::getPredefinedBodyWorkspace()
+const SearchArea& Robot::getPredefinedBodyWorkspace() const
 {
 	return body_workspace_;
 }
 
 
-SearchAreaMap Robot::getPredefinedLegWorkspaces()
+const SearchAreaMap& Robot::getPredefinedLegWorkspaces() const
 {
 	return foot_workspaces_;
 }
 
 
-Vector3dMap Robot::getStance(const Eigen::Vector3d& action) //TODO Virtual method
+Vector3dMap Robot::getStance(const Eigen::Vector3d& action)
+{
+	return getPatternStance(getStancePattern(action));
+}
+
+
+const Vector3dMap& Robot::getStance(GaitState& state,
+									const Eigen::Vector3d& action) const
+{
+	return getPatternStance(state, getStancePattern(state, action));
+}
+
+
+int Robot::getStancePattern(const Eigen::Vector3d& action)
+{
+	GaitState state;
+	state.last_past_foot = last_past_foot_;
+	int pattern = getStancePattern(state, action);
+	last_past_foot_ = state.last_past_foot;
+
+	return pattern;
+}
+
+
+int Robot::getStancePattern(GaitState& state,
+							const Eigen::Vector3d& action) const
 {
 	int lateral_pattern, displacement_pattern;
 	double frontal_action = action(0);
@@ -234,122 +306,209 @@ Vector3dMap Robot::getStance(const Eigen::Vector3d& action) //TODO Virtual metho
 		past_foot_id = 1;
 		lateral_pattern = 0;
 	} else {
-		past_foot_id = last_past_foot_;
+		past_foot_id = state.last_past_foot;
 		if (past_foot_id == 0)
 			lateral_pattern = -1;
 		else
 			lateral_pattern = 1;
 	}
-	last_past_foot_ = past_foot_id;
+	state.last_past_foot = past_foot_id;
+
+	return 3 * (displacement_pattern + 1) + (lateral_pattern + 1);
+}
 
 
-	// Defining the stance position per leg
-	Vector3dMap stance;
-	for (EndEffectorMap::iterator it = feet_.begin(); it != feet_.end(); ++it) {
-		unsigned int id = it->first;
-		std::string name = it->second;
+const Vector3dMap& Robot::getNominalStance() const
+{
+	return nominal_stance_;
+}
 
-		Eigen::Vector3d position;
-		if ((name == "lf_foot") || (name == "lh_foot"))
-			position(0) = nominal_stance_[id](0) -
-				lateral_pattern * feet_lateral_offset_ +
-				displacement_pattern * displacement_;
-		else
-			position(0) = nominal_stance_[id](0) +
-				lateral_pattern * feet_lateral_offset_ +
-				displacement_pattern * displacement_;
 
-		position(1) = nominal_stance_[id](1);
-		position(2) = estimated_ground_from_body_;
-		stance[id] = position;
-	}
+const PatternOfLocomotionMap& Robot::getPatternOfLocomotion() const
+{
+	return pattern_locomotion_;
+}
+
 
-	return stance;
+const SearchAreaMap& Robot::getFootstepSearchAreas(const Eigen::Vector3d& action)
+{
+	return footstep_area_table_[getStancePattern(action)];
 }
 
 
-Vector3dMap Robot::getNominalStance()
+const SearchAreaMap& Robot::getFootstepSearchAreas(GaitState& state,
+												   const Eigen::Vector3d& action) const
 {
-	return nominal_stance_;
+	return footstep_area_table_[getStancePattern(state, action)];
 }
 
 
-PatternOfLocomotionMap Robot::getPatternOfLocomotion()
+Vector3dMap Robot::getPatternStance(int pattern) const
 {
-	return pattern_locomotion_;
+	// Copying the stance while the current table is kept by the loaded gait state
+	std::shared_ptr<const GaitState> state = loadGaitState();
+	return state->stance_table->stances[pattern];
 }
 
 
-SearchAreaMap Robot::getFootstepSearchAreas(const Eigen::Vector3d& action)
+const Vector3dMap& Robot::getPatternStance(GaitState& state,
+										   int pattern) const
 {
-	// Getting the current stance
-	Vector3dMap current_stance = getStance(action);
+	if (!state.stance_table)
+		state.stance_table = loadGaitState()->stance_table;
 
-	// Getting the footstep search regions
-	SearchAreaMap footstep_areas;
-	footstep_areas = getFootstepSearchSize(action);
+	return state.stance_table->stances[pattern];
+}
 
-	for (EndEffectorMap::iterator l = feet_.begin(); l != feet_.end(); l++) {
-		unsigned int leg_id = l->first;
-		footstep_areas[leg_id].max_x += current_stance[leg_id](0);
-		footstep_areas[leg_id].min_x += current_stance[leg_id](0);
-		footstep_areas[leg_id].max_y += current_stance[leg_id](1);
-		footstep_areas[leg_id].min_y += current_stance[leg_id](1);
-	}
 
-	return footstep_areas;
+const SearchAreaMap& Robot::getPatternFootstepSearchAreas(int pattern) const
+{
+	return footstep_area_table_[pattern];
 }
 
 
-SearchAreaMap Robot::getFootstepSearchSize(const Eigen::Vector3d& action)
+const SearchAreaMap& Robot::getFootstepSearchSize(const Eigen::Vector3d& action) const
 {
 	// Determining if the movements is forward or backward because the footstep search areas
 	// changes according the action
-	int displacement_pattern;
-	double frontal_action = action(0);
-	if (frontal_action >= 0)
-		displacement_pattern = 1;
+	if (action(0) >= 0)
+		return footstep_size_table_[0];
 	else
-		displacement_pattern = -1;
+		return footstep_size_table_[1];
+}
 
-	SearchAreaMap footstep_areas;
-	SearchArea footstep_area;
-	for (EndEffectorMap::iterator l = feet_.begin(); l != feet_.end(); l++) {
-		unsigned int leg_id = l->first;
-		footstep_area.resolution = footstep_window_[leg_id].resolution;
-		footstep_area.max_x = displacement_pattern * footstep_window_[leg_id].max_x;
-		footstep_area.min_x = displacement_pattern * footstep_window_[leg_id].min_x;
-		footstep_area.max_y = footstep_window_[leg_id].max_y;
-		footstep_area.min_y = footstep_window_[leg_id].min_y;
-		footstep_areas[leg_id] = footstep_area;
-	}
 
-	return footstep_areas;
+double Robot::getExpectedGround(int leg_id)
+{
+	return getExpectedGround(*loadGaitState(), leg_id);
 }
 
 
-double Robot::getExpectedGround(int leg_id)
+double Robot::getExpectedGround(const GaitState& state,
+								int leg_id) const
 {
-	return current_pose_.position(2) + estimated_ground_from_body_;
+	if (!state.stance_table)
+		return state.pose.position(2) +
+				loadGaitState()->stance_table->estimated_ground_from_body;
+
+	return state.pose.position(2) + state.stance_table->estimated_ground_from_body;
 }
 
 
-double Robot::getNumberOfLegs()
+double Robot::getNumberOfLegs() const
 {
 	return num_feet_;
 }
 
 
-EndEffectorMap Robot::getEndEffectorMap()
+const EndEffectorMap& Robot::getEndEffectorMap() const
 {
 	return end_effectors_;
 }
 
 
-EndEffectorMap Robot::getLegMap()
+const EndEffectorMap& Robot::getLegMap() const
 {
 	return feet_;
 }
 
+void Robot::updateStanceTables()
+{
+	// Computing the footstep search regions of the forward and backward actions
+	footstep_size_table_.assign(2, SearchAreaMap());
+	for (int direction = 0; direction < 2; direction++) {
+		int displacement_pattern = (direction == 0) ? 1 : -1;
+		SearchAreaMap& footstep_areas = footstep_size_table_[direction];
+		for (EndEffectorMap::iterator l = feet_.begin(); l != feet_.end(); l++) {
+			unsigned int leg_id = l->first;
+			const SearchArea& window = footstep_window_[leg_id];
+
+			SearchArea footstep_area;
+			footstep_area.resolution = window.resolution;
+			footstep_area.max_x = displacement_pattern * window.max_x;
+			footstep_area.min_x = displacement_pattern * window.min_x;
+			footstep_area.max_y = window.max_y;
+			footstep_area.min_y = window.min_y;
+			footstep_areas[leg_id] = footstep_area;
+		}
+	}
+
+	// Publishing a gait state with the stance table of the estimated ground of the properties
+	std::shared_ptr<const StanceTable> stance_table =
+			computeStanceTable(estimated_ground_from_body_);
+	{
+		std::lock_guard<std::mutex> lock(update_mutex_);
+		std::shared_ptr<const GaitState> current = loadGaitState();
+		std::shared_ptr<GaitState> state =
+				current ? std::make_shared<GaitState>(*current) : std::make_shared<GaitState>();
+		state->stance_table = stance_table;
+		std::atomic_store(&gait_state_, std::shared_ptr<const GaitState>(state));
+	}
+
+	footstep_area_table_.assign(NUM_STANCE_PATTERNS, SearchAreaMap());
+	for (int pattern = 0; pattern < NUM_STANCE_PATTERNS; pattern++) {
+		// Getting the footstep search regions, a positive or null frontal action (i.e. a
+		// displacement pattern of -1 or 0) moves forward. They only depend on the horizontal
+		// position of the stance, so they don't depend on the estimated ground
+		int displacement_pattern = pattern / 3 - 1;
+		const Vector3dMap& stance = stance_table->stances[pattern];
+		SearchAreaMap& footstep_areas = footstep_area_table_[pattern];
+		footstep_areas = footstep_size_table_[(displacement_pattern <= 0) ? 0 : 1];
+		for (Vector3dMap::const_iterator l = stance.begin(); l != stance.end(); l++) {
+			unsigned int leg_id = l->first;
+			footstep_areas[leg_id].max_x += l->second(0);
+			footstep_areas[leg_id].min_x += l->second(0);
+			footstep_areas[leg_id].max_y += l->second(1);
+			footstep_areas[leg_id].min_y += l->second(1);
+		}
+	}
+}
+
+
+std::shared_ptr<const StanceTable> Robot::computeStanceTable(double estimated_ground) const
+{
+	std::shared_ptr<StanceTable> table = std::make_shared<StanceTable>();
+	table->estimated_ground_from_body = estimated_ground;
+	table->stances.assign(NUM_STANCE_PATTERNS, Vector3dMap());
+	for (int pattern = 0; pattern < NUM_STANCE_PATTERNS; pattern++) {
+		// Getting the displacement and lateral patterns
+		int displacement_pattern = pattern / 3 - 1;
+		int lateral_pattern = pattern % 3 - 1;
+
+		// Defining the stance position per leg
+		Vector3dMap& stance = table->stances[pattern];
+		for (EndEffectorMap::const_iterator it = feet_.begin(); it != feet_.end(); ++it) {
+			unsigned int id = it->first;
+			std::string name = it->second;
+			Vector3dMap::const_iterator nominal_iter = nominal_stance_.find(id);
+			if (nominal_iter == nominal_stance_.end())
+				continue;
+			const Eigen::Vector3d& nominal_stance = nominal_iter->second;
+
+			Eigen::Vector3d position;
+			if ((name == "lf_foot") || (name == "lh_foot"))
+				position(0) = nominal_stance(0) -
+					lateral_pattern * feet_lateral_offset_ +
+					displacement_pattern * displacement_;
+			else
+				position(0) = nominal_stance(0) +
+					lateral_pattern * feet_lateral_offset_ +
+					displacement_pattern * displacement_;
+
+			position(1) = nominal_stance(1);
+			position(2) = estimated_ground;
+			stance[id] = position;
+		}
+	}
+
+	return table;
+}
+
+
+std::shared_ptr<const GaitState> Robot::loadGaitState() const
+{
+	return std::atomic_load(&gait_state_);
+}
+
 } //@namespace robot
 } //@namespace dwl
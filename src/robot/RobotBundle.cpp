@@ -0,0 +1,425 @@
+#include <dwl/robot/RobotBundle.h>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace dwl
+{
+
+namespace robot
+{
+
+/** @brief Magic number of the bundle file */
+static const char BUNDLE_MAGIC[8] = {'D', 'W', 'L', 'R', 'B', 'N', 'D', 'L'};
+
+/** @brief Byte-order mark of the bundle */
+static const uint32_t BUNDLE_BYTE_ORDER = 0x01020304;
+
+
+/** @brief Appends a plain value to the payload */
+template <typename T>
+static void writeValue(std::string& payload,
+					   const T& value)
+{
+	payload.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+
+/** @brief Appends a string to the payload, as its length followed by its characters */
+static void writeString(std::string& payload,
+						const std::string& value)
+{
+	writeValue(payload, (uint32_t) value.size());
+	payload.append(value);
+}
+
+
+/** @brief Appends a search area to the payload */
+static void writeSearchArea(std::string& payload,
+							const SearchArea& area)
+{
+	writeValue(payload, area.min_x);
+	writeValue(payload, area.max_x);
+	writeValue(payload, area.min_y);
+	writeValue(payload, area.max_y);
+	writeValue(payload, area.resolution);
+}
+
+
+/** @brief Read cursor over the mapped payload, every read is checked against its size */
+struct PayloadCursor
+{
+	PayloadCursor(const char* _data, std::size_t _size) :
+		data(_data), size(_size), offset(0), is_valid(true) {}
+
+	/** @brief Gets a pointer to the next bytes of the payload, or NULL if they are missing */
+	const char* next(std::size_t num_bytes)
+	{
+		if (!is_valid || (num_bytes > size - offset)) {
+			is_valid = false;
+			return NULL;
+		}
+
+		const char* pointer = data + offset;
+		offset += num_bytes;
+		return pointer;
+	}
+
+	const char* data;
+	std::size_t size;
+	std::size_t offset;
+	bool is_valid;
+};
+
+
+/** @brief Reads a plain value from the payload */
+template <typename T>
+static void readValue(T& value,
+					  PayloadCursor& cursor)
+{
+	const char* pointer = cursor.next(sizeof(T));
+	if (pointer != NULL)
+		memcpy(&value, pointer, sizeof(T));
+}
+
+
+/** @brief Reads a string from the payload */
+static void readString(std::string& value,
+					   PayloadCursor& cursor)
+{
+	uint32_t length = 0;
+	readValue(length, cursor);
+	const char* pointer = cursor.next(length);
+	if (pointer != NULL)
+		value.assign(pointer, length);
+}
+
+
+/** @brief Reads a search area from the payload */
+static void readSearchArea(SearchArea& area,
+						   PayloadCursor& cursor)
+{
+	readValue(area.min_x, cursor);
+	readValue(area.max_x, cursor);
+	readValue(area.min_y, cursor);
+	readValue(area.max_y, cursor);
+	readValue(area.resolution, cursor);
+}
+
+
+bool RobotBundle::compile(std::string robot_filename,
+						  std::string primitives_filename,
+						  std::string bundle_filename)
+{
+	Robot robot;
+	robot.read(robot_filename);
+	robot.getBodyMotorPrimitive().read(primitives_filename);
+
+	return write(robot, bundle_filename);
+}
+
+
+bool RobotBundle::write(Robot& robot,
+						std::string bundle_filename)
+{
+	behavior::BodyMotorPrimitives* primitives =
+			dynamic_cast<behavior::BodyMotorPrimitives*>(robot.body_behavior_);
+	if (primitives == NULL) {
+		printf(RED "Could not write the robot bundle because the body motor primitives are not"
+				" defined\n" COLOR_RESET);
+		return false;
+	}
+
+	// Writing the end-effectors and feet
+	std::string payload;
+	writeValue(payload, (uint32_t) robot.end_effectors_.size());
+	for (EndEffectorMap::iterator it = robot.end_effectors_.begin();
+			it != robot.end_effectors_.end(); it++) {
+		writeValue(payload, (int32_t) it->first);
+		writeString(payload, it->second);
+	}
+	writeValue(payload, (uint32_t) robot.feet_.size());
+	for (EndEffectorMap::iterator it = robot.feet_.begin(); it != robot.feet_.end(); it++) {
+		writeValue(payload, (int32_t) it->first);
+		writeString(payload, it->second);
+	}
+
+	// Writing the patches of the end-effectors
+	writeValue(payload, (uint32_t) robot.patchs_.size());
+	for (PatchMap::iterator it = robot.patchs_.begin(); it != robot.patchs_.end(); it++) {
+		writeValue(payload, (int32_t) it->first);
+		writeValue(payload, (uint32_t) it->second.size());
+		for (std::size_t i = 0; i < it->second.size(); i++)
+			writeString(payload, it->second[i]);
+	}
+
+	// Writing the pattern of locomotion
+	writeValue(payload, (uint32_t) robot.pattern_locomotion_.size());
+	for (PatternOfLocomotionMap::iterator it = robot.pattern_locomotion_.begin();
+			it != robot.pattern_locomotion_.end(); it++) {
+		writeValue(payload, (int32_t) it->first);
+		writeValue(payload, (int32_t) it->second);
+	}
+
+	// Writing the nominal stance
+	writeValue(payload, (uint32_t) robot.nominal_stance_.size());
+	for (Vector3dMap::iterator it = robot.nominal_stance_.begin();
+			it != robot.nominal_stance_.end(); it++) {
+		writeValue(payload, (int32_t) it->first);
+		for (int k = 0; k < 3; k++)
+			writeValue(payload, (double) it->second(k));
+	}
+
+	// Writing the footstep search windows and the foot workspaces
+	writeValue(payload, (uint32_t) robot.footstep_window_.size());
+	for (SearchAreaMap::iterator it = robot.footstep_window_.begin();
+			it != robot.footstep_window_.end(); it++) {
+		writeValue(payload, (int32_t) it->first);
+		writeSearchArea(payload, it->second);
+	}
+	writeValue(payload, (uint32_t) robot.foot_workspaces_.size());
+	for (SearchAreaMap::iterator it = robot.foot_workspaces_.begin();
+			it != robot.foot_workspaces_.end(); it++) {
+		writeValue(payload, (int32_t) it->first);
+		writeSearchArea(payload, it->second);
+	}
+
+	// Writing the body workspace and the scalar properties
+	writeSearchArea(payload, robot.body_workspace_);
+	writeValue(payload, robot.num_feet_);
+	writeValue(payload, robot.num_end_effectors_);
+	writeValue(payload, robot.estimated_ground_from_body_);
+	writeValue(payload, robot.feet_lateral_offset_);
+	writeValue(payload, robot.displacement_);
+
+	// Writing the body motor primitives as a flat array (x, y, yaw, cost)
+	const std::vector<behavior::BodyMotorPrimitive>& body_primitives =
+			primitives->getPrimitives();
+	writeValue(payload, (uint32_t) body_primitives.size());
+	for (std::size_t i = 0; i < body_primitives.size(); i++) {
+		for (int k = 0; k < 3; k++)
+			writeValue(payload, (double) body_primitives[i].action(k));
+		writeValue(payload, body_primitives[i].cost);
+	}
+
+	// Writing the header and the payload
+	Header header;
+	memcpy(header.magic, BUNDLE_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	header.byte_order = BUNDLE_BYTE_ORDER;
+	header.payload_size = payload.size();
+	header.checksum = computeChecksum(payload.data(), payload.size());
+
+	std::ofstream bundle(bundle_filename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!bundle.is_open()) {
+		printf(RED "Could not open the robot bundle %s\n" COLOR_RESET, bundle_filename.c_str());
+		return false;
+	}
+	bundle.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	bundle.write(payload.data(), payload.size());
+	bundle.close();
+	if (!bundle) {
+		printf(RED "Could not write the robot bundle %s\n" COLOR_RESET, bundle_filename.c_str());
+		return false;
+	}
+
+	printf(BLUE "Wrote the robot bundle %s (%u primitives)\n" COLOR_RESET,
+			bundle_filename.c_str(), (unsigned int) body_primitives.size());
+	return true;
+}
+
+
+bool RobotBundle::read(Robot& robot,
+					   std::string bundle_filename)
+{
+	behavior::BodyMotorPrimitives* primitives =
+			dynamic_cast<behavior::BodyMotorPrimitives*>(robot.body_behavior_);
+	if (primitives == NULL) {
+		printf(RED "Could not read the robot bundle because the body motor primitives are not"
+				" defined\n" COLOR_RESET);
+		return false;
+	}
+
+	// Mapping the bundle file
+	int file = open(bundle_filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		printf(RED "Could not open the robot bundle %s\n" COLOR_RESET, bundle_filename.c_str());
+		return false;
+	}
+	struct stat file_status;
+	if ((fstat(file, &file_status) != 0) || (file_status.st_size < (off_t) sizeof(Header))) {
+		printf(RED "Could not read the robot bundle %s because it's truncated\n" COLOR_RESET,
+				bundle_filename.c_str());
+		close(file);
+		return false;
+	}
+	std::size_t file_size = file_status.st_size;
+	void* mapping = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED) {
+		printf(RED "Could not map the robot bundle %s\n" COLOR_RESET, bundle_filename.c_str());
+		return false;
+	}
+	const char* data = static_cast<const char*>(mapping);
+
+	// Validating the header and the checksum of the payload
+	Header header;
+	memcpy(&header, data, sizeof(header));
+	const char* error = NULL;
+	if (memcmp(header.magic, BUNDLE_MAGIC, sizeof(header.magic)) != 0)
+		error = "it isn't a robot bundle";
+	else if (header.version != VERSION)
+		error = "its version is not supported";
+	else if (header.byte_order != BUNDLE_BYTE_ORDER)
+		error = "its byte order doesn't match";
+	else if (header.payload_size != file_size - sizeof(Header))
+		error = "it's truncated";
+	else if (header.checksum != computeChecksum(data + sizeof(Header), header.payload_size))
+		error = "its checksum doesn't match";
+	if (error != NULL) {
+		printf(RED "Could not read the robot bundle %s because %s\n" COLOR_RESET,
+				bundle_filename.c_str(), error);
+		munmap(mapping, file_size);
+		return false;
+	}
+
+	// Reading the end-effectors and feet
+	PayloadCursor cursor(data + sizeof(Header), header.payload_size);
+	EndEffectorMap end_effectors, feet;
+	uint32_t size = 0;
+	readValue(size, cursor);
+	for (uint32_t i = 0; (i < size) && cursor.is_valid; i++) {
+		int32_t id = 0;
+		readValue(id, cursor);
+		readString(end_effectors[id], cursor);
+	}
+	readValue(size, cursor);
+	for (uint32_t i = 0; (i < size) && cursor.is_valid; i++) {
+		int32_t id = 0;
+		readValue(id, cursor);
+		readString(feet[id], cursor);
+	}
+
+	// Reading the patches of the end-effectors
+	PatchMap patchs;
+	readValue(size, cursor);
+	for (uint32_t i = 0; (i < size) && cursor.is_valid; i++) {
+		int32_t id = 0;
+		uint32_t num_patchs = 0;
+		readValue(id, cursor);
+		readValue(num_patchs, cursor);
+		std::vector<std::string>& patch_names = patchs[id];
+		for (uint32_t k = 0; (k < num_patchs) && cursor.is_valid; k++) {
+			patch_names.push_back(std::string());
+			readString(patch_names.back(), cursor);
+		}
+	}
+
+	// Reading the pattern of locomotion
+	PatternOfLocomotionMap pattern_locomotion;
+	readValue(size, cursor);
+	for (uint32_t i = 0; (i < size) && cursor.is_valid; i++) {
+		int32_t id = 0, next_id = 0;
+		readValue(id, cursor);
+		readValue(next_id, cursor);
+		pattern_locomotion[id] = next_id;
+	}
+
+	// Reading the nominal stance
+	Vector3dMap nominal_stance;
+	readValue(size, cursor);
+	for (uint32_t i = 0; (i < size) && cursor.is_valid; i++) {
+		int32_t id = 0;
+		readValue(id, cursor);
+		Eigen::Vector3d& stance = nominal_stance[id];
+		for (int k = 0; k < 3; k++)
+			readValue(stance(k), cursor);
+	}
+
+	// Reading the footstep search windows and the foot workspaces
+	SearchAreaMap footstep_window, foot_workspaces;
+	readValue(size, cursor);
+	for (uint32_t i = 0; (i < size) && cursor.is_valid; i++) {
+		int32_t id = 0;
+		readValue(id, cursor);
+		readSearchArea(footstep_window[id], cursor);
+	}
+	readValue(size, cursor);
+	for (uint32_t i = 0; (i < size) && cursor.is_valid; i++) {
+		int32_t id = 0;
+		readValue(id, cursor);
+		readSearchArea(foot_workspaces[id], cursor);
+	}
+
+	// Reading the body workspace and the scalar properties
+	SearchArea body_workspace;
+	double num_feet = 0, num_end_effectors = 0, estimated_ground_from_body = 0;
+	double feet_lateral_offset = 0, displacement = 0;
+	readSearchArea(body_workspace, cursor);
+	readValue(num_feet, cursor);
+	readValue(num_end_effectors, cursor);
+	readValue(estimated_ground_from_body, cursor);
+	readValue(feet_lateral_offset, cursor);
+	readValue(displacement, cursor);
+
+	// Reading the body motor primitives directly from the mapped array
+	std::vector<behavior::BodyMotorPrimitive> body_primitives;
+	uint32_t num_primitives = 0;
+	readValue(num_primitives, cursor);
+	const char* primitive_data = cursor.next((std::size_t) num_primitives * 4 * sizeof(double));
+	if (primitive_data != NULL) {
+		body_primitives.resize(num_primitives);
+		for (uint32_t i = 0; i < num_primitives; i++) {
+			double values[4];
+			memcpy(values, primitive_data + i * sizeof(values), sizeof(values));
+			body_primitives[i].action << values[0], values[1], values[2];
+			body_primitives[i].cost = values[3];
+		}
+	}
+
+	munmap(mapping, file_size);
+	if (!cursor.is_valid || (cursor.offset != cursor.size)) {
+		printf(RED "Could not read the robot bundle %s because its payload is malformed\n"
+				COLOR_RESET, bundle_filename.c_str());
+		return false;
+	}
+
+	// Setting the robot properties once the whole bundle was read
+	robot.end_effectors_.swap(end_effectors);
+	robot.feet_.swap(feet);
+	robot.patchs_.swap(patchs);
+	robot.pattern_locomotion_.swap(pattern_locomotion);
+	robot.nominal_stance_.swap(nominal_stance);
+	robot.footstep_window_.swap(footstep_window);
+	robot.foot_workspaces_.swap(foot_workspaces);
+	robot.body_workspace_ = body_workspace;
+	robot.num_feet_ = num_feet;
+	robot.num_end_effectors_ = num_end_effectors;
+	robot.estimated_ground_from_body_ = estimated_ground_from_body;
+	robot.feet_lateral_offset_ = feet_lateral_offset;
+	robot.displacement_ = displacement;
+	primitives->setPrimitives(body_primitives);
+	robot.updateStanceTables();
+
+	return true;
+}
+
+
+uint64_t RobotBundle::computeChecksum(const char* data,
+									  std::size_t size)
+{
+	uint64_t checksum = 14695981039346656037ULL;
+	for (std::size_t i = 0; i < size; i++) {
+		checksum ^= (unsigned char) data[i];
+		checksum *= 1099511628211ULL;
+	}
+
+	return checksum;
+}
+
+} //@namespace robot
+} //@namespace dwl
@@ -0,0 +1,127 @@
+#include <dwl/model/GridBasedBodyAdjacency.h>
+#include <dwl/model/LatticeBasedBodyAdjacency.h>
+#include <dwl/environment/TerrainMap.h>
+#include <dwl/robot/Robot.h>
+#include <dwl/behavior/MotorPrimitives.h>
+#include "../../benchmark/AllocationCounter.h"
+#include <cmath>
+#include <random>
+
+
+/**
+ * Checks that the successor expansion of the body adjacency models doesn't allocate memory in
+ * steady state, i.e. once the reusable successor buffer, the body cost caches and the internal
+ * buffers of the models are warm. Every heap allocation of the process is counted by the global
+ * operator new of benchmark/AllocationCounter.cpp, which is linked in this test, and the warm
+ * expansions of the grid and lattice models have to count none.
+ *
+ * Usage: BodyAdjacencyAllocationTest [--robot file] [--primitives file]
+ * The exit code is 1 if a warm expansion allocates.
+ */
+
+
+using namespace dwl;
+
+
+/** @brief Number of expanded states */
+static const unsigned int NUM_STATES = 500;
+
+
+/**
+ * @brief Counts the allocations of the warm expansions of a model. The states are expanded twice
+ * for warming the buffers and caches up, and the third expansion is measured
+ * @param Adjacency Body adjacency model
+ * @param const std::vector<Vertex>& State vertices
+ * @return The number of allocations of the warm expansion
+ */
+template <typename Adjacency>
+static unsigned long countWarmAllocations(Adjacency& adjacency,
+										  const std::vector<Vertex>& state_vertices)
+{
+	std::vector<Edge> successors;
+	for (unsigned int pass = 0; pass < 2; pass++) {
+		for (std::size_t i = 0; i < state_vertices.size(); i++)
+			adjacency.getSuccessors(successors, state_vertices[i]);
+	}
+
+	unsigned long allocations = benchmark::getNumberOfAllocations();
+	for (std::size_t i = 0; i < state_vertices.size(); i++)
+		adjacency.getSuccessors(successors, state_vertices[i]);
+
+	return benchmark::getNumberOfAllocations() - allocations;
+}
+
+
+int main(int argc, char** argv)
+{
+	std::string robot_file = "benchmark/config/quadruped.yaml";
+	std::string primitives_file = "benchmark/config/body_primitives.yaml";
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string argument = argv[i];
+		if (argument == "--robot")
+			robot_file = argv[i + 1];
+		else if (argument == "--primitives")
+			primitives_file = argv[i + 1];
+	}
+
+	robot::Robot robot;
+	robot.read(robot_file);
+	robot.getBodyMotorPrimitive().read(primitives_file);
+
+	// Generating a rubble terrain with holes
+	const double size = 4., resolution = 0.04;
+	environment::TerrainMap terrain_map;
+	terrain_map.setResolution(resolution, true);
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<double> uniform(0., 1.);
+	for (double y = 0; y < size; y += resolution) {
+		for (double x = 0; x < size; x += resolution) {
+			if (uniform(generator) < 0.05)
+				continue;
+
+			TerrainCell cell;
+			terrain_map.getTerrainSpaceModel().stateToKey(cell.key.x, x, true);
+			terrain_map.getTerrainSpaceModel().stateToKey(cell.key.y, y, true);
+			cell.plane_size = resolution;
+			cell.height_size = resolution;
+			cell.height = 0.15 * uniform(generator);
+			cell.cost = uniform(generator);
+			terrain_map.addCellToTerrainMap(cell);
+		}
+	}
+
+	std::vector<Vertex> state_vertices(NUM_STATES);
+	for (unsigned int i = 0; i < NUM_STATES; i++) {
+		Eigen::Vector3d state;
+		state << size * uniform(generator), size * uniform(generator),
+				2 * M_PI * uniform(generator) - M_PI;
+		terrain_map.getTerrainSpaceModel().stateToVertex(state_vertices[i], state);
+	}
+
+	unsigned int num_failures = 0;
+	model::GridBasedBodyAdjacency grid_adjacency;
+	grid_adjacency.reset(&robot, &terrain_map);
+	unsigned long allocations = countWarmAllocations(grid_adjacency, state_vertices);
+	if (allocations > 0) {
+		printf(RED "The warm expansion of the grid model made %lu allocations\n" COLOR_RESET,
+				allocations);
+		num_failures++;
+	}
+
+	model::LatticeBasedBodyAdjacency lattice_adjacency;
+	lattice_adjacency.reset(&robot, &terrain_map);
+	allocations = countWarmAllocations(lattice_adjacency, state_vertices);
+	if (allocations > 0) {
+		printf(RED "The warm expansion of the lattice model made %lu allocations\n" COLOR_RESET,
+				allocations);
+		num_failures++;
+	}
+
+	if (num_failures > 0) {
+		printf(RED "BodyAdjacencyAllocationTest failed\n" COLOR_RESET);
+		return 1;
+	}
+
+	printf(GREEN "BodyAdjacencyAllocationTest passed\n" COLOR_RESET);
+	return 0;
+}
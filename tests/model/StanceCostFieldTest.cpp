@@ -0,0 +1,144 @@
+#include <dwl/model/StanceCostField.h>
+#include <dwl/model/StanceCostKernel.h>
+#include <dwl/model/StanceStencils.h>
+#include <dwl/environment/TerrainMap.h>
+#include <dwl/environment/DenseTerrainView.h>
+#include <cmath>
+#include <random>
+
+
+/**
+ * Checks that the per-yaw stance cost field computes the same terrain costs than evaluating the
+ * stance cost kernel (i.e. computeBodyCost) in every body cell. The random terrain has holes, so
+ * the stance areas of some feet are unknown, and quantized costs, so there are many ties. Every
+ * number of top cost, a few yaw bins and two stance patterns are checked, together with the flag
+ * of the unknown feet.
+ *
+ * Usage: StanceCostFieldTest
+ * The exit code is 1 if any cost or flag is different.
+ */
+
+using namespace dwl;
+
+
+/** @brief Tolerance of the costs, the field and the kernel add the same costs in the same order */
+static const double COST_TOLERANCE = 1e-12;
+
+
+/**
+ * @brief Gets the stance areas of a quadruped, the second pattern moves the areas forward
+ * @param SearchAreaMap& Stance areas
+ * @param int Stance pattern
+ * @param double Resolution of the areas
+ */
+static void getStanceAreas(SearchAreaMap& stance_areas,
+						   int pattern,
+						   double resolution)
+{
+	double shift = 0.06 * pattern;
+	for (int n = 0; n < 4; n++) {
+		SearchArea area;
+		area.min_x = ((n % 2) ? 0.2 : -0.35) + shift;
+		area.max_x = area.min_x + 0.12;
+		area.min_y = (n / 2) ? 0.1 : -0.22;
+		area.max_y = area.min_y + 0.12;
+		area.resolution = resolution;
+		stance_areas[n] = area;
+	}
+}
+
+
+int main()
+{
+	const double resolution = 0.04;
+	unsigned int num_failures = 0;
+	unsigned int num_checks = 0;
+	unsigned int num_unknown = 0;
+
+	// Generating a random terrain with holes and quantized costs
+	environment::TerrainMap terrain_map;
+	terrain_map.setResolution(resolution, true);
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<double> uniform(0., 1.);
+	std::uniform_int_distribution<int> level(0, 7);
+	for (double y = 0; y < 2.; y += resolution) {
+		for (double x = 0; x < 2.; x += resolution) {
+			if ((uniform(generator) < 0.1) || ((x > 0.8) && (x < 1.2) && (y > 0.8) && (y < 1.2)))
+				continue;
+
+			TerrainCell cell;
+			terrain_map.getTerrainSpaceModel().stateToKey(cell.key.x, x, true);
+			terrain_map.getTerrainSpaceModel().stateToKey(cell.key.y, y, true);
+			cell.plane_size = resolution;
+			cell.height_size = resolution;
+			cell.height = 0;
+			cell.cost = 0.25 * level(generator);
+			terrain_map.addCellToTerrainMap(cell);
+		}
+	}
+
+	environment::DenseTerrainView terrain_view;
+	terrain_view.reset(&terrain_map);
+	int min_key_x, min_key_y, size_x, size_y;
+	terrain_view.getBounds(min_key_x, min_key_y, size_x, size_y);
+	double unknown_cost = 1.15 * terrain_view.getAverageCost();
+
+	model::StanceStencils stance_stencils;
+	stance_stencils.reset(resolution);
+	model::StanceCostKernel stance_cost_kernel;
+	model::StanceCostField stance_cost_field;
+	for (int pattern = 0; pattern < 2; pattern++) {
+		SearchAreaMap stance_areas;
+		getStanceAreas(stance_areas, pattern, resolution);
+		for (unsigned short int key_yaw = 30; key_yaw < 42; key_yaw += 3) {
+			double yaw;
+			terrain_map.getTerrainSpaceModel().keyToState(yaw, key_yaw, false);
+			stance_stencils.compute(key_yaw, pattern, yaw, stance_areas);
+			const model::StanceStencil& stencil = stance_stencils.getStencil(key_yaw, pattern);
+
+			for (unsigned int number_top_cost = 0; number_top_cost <= 12; number_top_cost++) {
+				stance_cost_field.compute(terrain_view, stencil, number_top_cost, unknown_cost,
+						1 + number_top_cost % 4);
+
+				for (int key_y = min_key_y; key_y < min_key_y + size_y; key_y++) {
+					for (int key_x = min_key_x; key_x < min_key_x + size_x; key_x++) {
+						double expected = stance_cost_kernel.computeTerrainCost(terrain_view,
+								stencil, key_x, key_y, number_top_cost, unknown_cost);
+						bool is_expected_unknown =
+								stance_cost_kernel.getNumberOfUnknownFeet() > 0;
+
+						double cost;
+						bool is_unknown_cost;
+						num_checks++;
+						if (!stance_cost_field.getCost(cost, is_unknown_cost, key_x, key_y) ||
+								(fabs(cost - expected) > COST_TOLERANCE) ||
+								(is_unknown_cost != is_expected_unknown)) {
+							if (num_failures < 10)
+								printf(RED "The field cost of the cell (%d,%d) with yaw key %u, "
+										"pattern %d and k=%u is %f instead of %f\n" COLOR_RESET,
+										key_x, key_y, key_yaw, pattern, number_top_cost, cost,
+										expected);
+							num_failures++;
+						}
+						if (is_expected_unknown)
+							num_unknown++;
+					}
+				}
+			}
+		}
+	}
+
+	if (num_unknown == 0) {
+		printf(RED "StanceCostFieldTest didn't check any cell with unknown feet\n" COLOR_RESET);
+		num_failures++;
+	}
+
+	if (num_failures > 0) {
+		printf(RED "StanceCostFieldTest failed with %u wrong cells of %u\n" COLOR_RESET,
+				num_failures, num_checks);
+		return 1;
+	}
+
+	printf(GREEN "StanceCostFieldTest passed (%u cells)\n" COLOR_RESET, num_checks);
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include <dwl/model/StanceCostKernel.h>
+#include <dwl/utils/utils.h>
+#include <cmath>
+#include <random>
+#include <set>
+
+
+/**
+ * Checks that the top-k stance cost kernel computes the same costs than the cost-ordered queue
+ * of the previous stance cost, i.e. a std::set ordered by pair_first_less. The set merges the
+ * equal costs, which are common on flat terrain, so the random costs are quantized for having
+ * many ties. The number of costs covers the scalar and the AVX2 paths of the kernel.
+ *
+ * Usage: StanceCostKernelTest
+ * The exit code is 1 if any cost is different.
+ */
+
+
+/**
+ * @brief Computes the average of the best costs with the cost-ordered queue of the stance cost
+ * @param const std::vector<double>& Costs
+ * @param unsigned int Number of top (lowest) cost
+ * @param double Cost if there isn't any cost
+ * @return The average of the best costs
+ */
+static double computeQueueAverage(const std::vector<double>& costs,
+								  unsigned int number_top_cost,
+								  double unknown_cost)
+{
+	std::set< std::pair<dwl::Weight, dwl::Vertex>,
+			dwl::pair_first_less<dwl::Weight, dwl::Vertex> > stance_cost_queue;
+	for (std::size_t i = 0; i < costs.size(); i++)
+		stance_cost_queue.insert(std::pair<dwl::Weight, dwl::Vertex>(costs[i], i));
+
+	if (stance_cost_queue.size() < number_top_cost)
+		number_top_cost = stance_cost_queue.size();
+
+	if (number_top_cost == 0)
+		return unknown_cost;
+
+	double stance_cost = 0;
+	for (unsigned int i = 0; i < number_top_cost; i++) {
+		stance_cost += stance_cost_queue.begin()->first;
+		stance_cost_queue.erase(stance_cost_queue.begin());
+	}
+
+	return stance_cost / number_top_cost;
+}
+
+
+int main()
+{
+	dwl::model::StanceCostKernel kernel;
+	const double unknown_cost = 1.15;
+	unsigned int num_failures = 0;
+
+	// Checking the example of ties, the queue averages {0,5,7}
+	double ties[] = {0, 0, 0, 5, 5, 7};
+	double cost = kernel.computeTopCostAverage(ties, 6, 5, unknown_cost);
+	if (cost != 4.) {
+		printf(RED "The average of the costs with ties is %f instead of 4\n" COLOR_RESET, cost);
+		num_failures++;
+	}
+
+	// Checking random costs with different number of costs and top costs
+	std::mt19937 generator(1234);
+	std::uniform_int_distribution<int> level(0, 9);
+	std::uniform_real_distribution<double> value(0., 10.);
+	for (unsigned int trial = 0; trial < 2000; trial++) {
+		unsigned int size = trial % 71;
+		bool is_quantized = (trial % 3) != 0;
+		std::vector<double> costs(size);
+		for (unsigned int i = 0; i < size; i++)
+			costs[i] = is_quantized ? 0.5 * level(generator) : value(generator);
+
+		for (unsigned int number_top_cost = 0; number_top_cost <= 12; number_top_cost++) {
+			double expected = computeQueueAverage(costs, number_top_cost, unknown_cost);
+			double cost = kernel.computeTopCostAverage(costs.data(), size,
+					number_top_cost, unknown_cost);
+			if (cost != expected) {
+				printf(RED "The average of %u costs with k=%u is %f instead of %f\n"
+						COLOR_RESET, size, number_top_cost, cost, expected);
+				num_failures++;
+			}
+		}
+	}
+
+	if (num_failures > 0) {
+		printf(RED "StanceCostKernelTest failed with %u wrong costs\n" COLOR_RESET, num_failures);
+		return 1;
+	}
+
+	printf(GREEN "StanceCostKernelTest passed\n" COLOR_RESET);
+	return 0;
+}
@@ -0,0 +1,185 @@
+#include <dwl/robot/ContactFeed.h>
+#include <dwl/robot/GaitState.h>
+#include <dwl/utils/utils.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Stress test of the contact feed: a producer publishes a sequence of samples while several
+ * readers copy them. Every word of a sample is a function of its index, so a reader detects a
+ * torn copy (i.e. words of different samples), a version that doesn't match the sample, or a
+ * version that goes backwards. It's meant to be run also under ThreadSanitizer.
+ *
+ * Usage: ContactFeedTest [--samples number] [--readers number]
+ * The exit code is 1 if any read sample is inconsistent.
+ */
+
+
+/** @brief Number of contacts of the sample of an index */
+static unsigned int getNumberOfContacts(uint64_t index)
+{
+	return index % (dwl::robot::ContactFeed::MAX_CONTACTS + 1);
+}
+
+
+/** @brief Fills the pose and contacts of the sample of an index */
+static void getSample(dwl::Pose& pose,
+					  std::vector<dwl::Contact>& contacts,
+					  uint64_t index)
+{
+	double value = index;
+	pose.position << value, 2 * value, 3 * value;
+	pose.orientation.x() = value + 0.25;
+	pose.orientation.y() = value + 0.5;
+	pose.orientation.z() = value + 0.75;
+	pose.orientation.w() = value + 1;
+
+	contacts.resize(getNumberOfContacts(index));
+	for (unsigned int i = 0; i < contacts.size(); i++) {
+		contacts[i].end_effector = i;
+		contacts[i].position << value, i, value + i;
+	}
+}
+
+
+/**
+ * @brief Gets the estimated ground of the sample of an index, i.e. the average height of its
+ * contacts, or the one of the last sample with contacts
+ */
+static double getEstimatedGround(uint64_t index)
+{
+	unsigned int num_contacts = getNumberOfContacts(index);
+	if (num_contacts == 0) {
+		if (index == 0)
+			return 0;
+
+		return getEstimatedGround(index - 1);
+	}
+
+	return index + (num_contacts - 1) / 2.;
+}
+
+
+/**
+ * @brief Checks that a read sample is the sample of its version
+ * @param const GaitState& Read gait state
+ * @param double Read estimated ground
+ * @param uint64_t Version of the sample
+ * @return True if the sample matches its version
+ */
+static bool isConsistent(const dwl::robot::GaitState& state,
+						 double estimated_ground,
+						 uint64_t version)
+{
+	uint64_t index = version - 1;
+	double value = index;
+	if ((state.pose.position(0) != value) || (state.pose.position(1) != 2 * value) ||
+			(state.pose.position(2) != 3 * value) ||
+			(state.pose.orientation.x() != value + 0.25) ||
+			(state.pose.orientation.y() != value + 0.5) ||
+			(state.pose.orientation.z() != value + 0.75) ||
+			(state.pose.orientation.w() != value + 1))
+		return false;
+
+	if (estimated_ground != getEstimatedGround(index))
+		return false;
+
+	if (state.contacts.size() != getNumberOfContacts(index))
+		return false;
+
+	for (unsigned int i = 0; i < state.contacts.size(); i++) {
+		if ((state.contacts[i].end_effector != (int) i) ||
+				(state.contacts[i].position(0) != value) ||
+				(state.contacts[i].position(1) != i) ||
+				(state.contacts[i].position(2) != value + i))
+			return false;
+	}
+
+	return true;
+}
+
+
+int main(int argc, char **argv)
+{
+	uint64_t num_samples = 2000000;
+	unsigned int num_readers = 3;
+	for (int i = 1; i < argc; i++) {
+		if ((strcmp(argv[i], "--samples") == 0) && (i + 1 < argc))
+			num_samples = strtoull(argv[++i], NULL, 10);
+		else if ((strcmp(argv[i], "--readers") == 0) && (i + 1 < argc))
+			num_readers = atoi(argv[++i]);
+	}
+
+	dwl::robot::ContactFeed feed;
+	std::atomic<bool> is_publishing(true);
+	std::vector<unsigned long> num_reads(num_readers, 0);
+	std::vector<unsigned long> num_failures(num_readers, 0);
+
+	// Reading the samples until the producer finishes
+	std::vector<std::thread> readers;
+	for (unsigned int r = 0; r < num_readers; r++) {
+		readers.push_back(std::thread([&feed, &is_publishing, &num_reads, &num_failures, r]() {
+			dwl::robot::GaitState state;
+			double estimated_ground;
+			uint64_t last_version = 0;
+			bool is_last_read = false;
+			while (!is_last_read) {
+				is_last_read = !is_publishing.load(std::memory_order_acquire);
+				uint64_t version = feed.read(state, estimated_ground);
+				if (version < last_version) {
+					printf(RED "The version %lu was read after the version %lu\n" COLOR_RESET,
+							(unsigned long) version, (unsigned long) last_version);
+					num_failures[r]++;
+				} else if ((version > 0) && !isConsistent(state, estimated_ground, version)) {
+					printf(RED "The sample of the version %lu is inconsistent\n" COLOR_RESET,
+							(unsigned long) version);
+					num_failures[r]++;
+				}
+				last_version = version;
+				num_reads[r]++;
+			}
+		}));
+	}
+
+	// Publishing the samples
+	dwl::Pose pose;
+	std::vector<dwl::Contact> contacts;
+	for (uint64_t index = 0; index < num_samples; index++) {
+		getSample(pose, contacts, index);
+		feed.publish(pose, contacts);
+	}
+	is_publishing.store(false, std::memory_order_release);
+
+	unsigned long total_reads = 0, total_failures = 0;
+	for (unsigned int r = 0; r < num_readers; r++) {
+		readers[r].join();
+		total_reads += num_reads[r];
+		total_failures += num_failures[r];
+	}
+
+	// Checking the last sample, the readers finish after the producer
+	dwl::robot::GaitState state;
+	double estimated_ground;
+	uint64_t version = feed.read(state, estimated_ground);
+	if ((version != num_samples) || ((version > 0) &&
+			!isConsistent(state, estimated_ground, version))) {
+		printf(RED "The last sample has the version %lu instead of %lu\n" COLOR_RESET,
+				(unsigned long) version, (unsigned long) num_samples);
+		total_failures++;
+	}
+
+	printf("Published %lu samples, %u readers made %lu reads\n",
+			(unsigned long) num_samples, num_readers, total_reads);
+	if (total_failures > 0) {
+		printf(RED "ContactFeedTest failed with %lu inconsistent reads\n" COLOR_RESET,
+				total_failures);
+		return 1;
+	}
+
+	printf(GREEN "ContactFeedTest passed\n" COLOR_RESET);
+	return 0;
+}
@@ -0,0 +1,178 @@
+#include <dwl/robot/RobotBundle.h>
+#include <dwl/robot/Robot.h>
+#include <dwl/robot/GaitState.h>
+#include <dwl/behavior/BodyMotorPrimitives.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+
+/**
+ * Checks that the robot bundle gives the same in-memory robot and body motor primitives than the
+ * yaml files. A robot is read from the yaml files, and another one from the bundle that is
+ * compiled from them with RobotBundle::compile (i.e. the robot bundle compiler). Their properties
+ * and precomputed stance tables are compared through the robot queries, and their primitives one
+ * by one. The properties without queries (e.g. the patches and the stance offsets) are compared by
+ * writing both robots to a bundle, which have to be byte-identical.
+ *
+ * Usage: RobotBundleTest [--robot file] [--primitives file] [--bundle file]
+ * The exit code is 1 if the robots or their primitives differ.
+ */
+
+
+/** @brief Number of differences between the robots */
+static unsigned int num_failures = 0;
+
+
+/** @brief Reports a difference between the yaml and bundle robots */
+static void reportDifference(const char* property)
+{
+	printf(RED "The bundle robot differs from the yaml robot in the %s\n" COLOR_RESET, property);
+	num_failures++;
+}
+
+
+/** @brief Indicates if two search areas are equal */
+static bool isEqual(const dwl::SearchArea& a,
+					const dwl::SearchArea& b)
+{
+	return (a.min_x == b.min_x) && (a.max_x == b.max_x) && (a.min_y == b.min_y) &&
+			(a.max_y == b.max_y) && (a.resolution == b.resolution);
+}
+
+
+/** @brief Indicates if two maps of search areas are equal */
+static bool isEqual(const dwl::SearchAreaMap& a,
+					const dwl::SearchAreaMap& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (dwl::SearchAreaMap::const_iterator it_a = a.begin(), it_b = b.begin();
+			it_a != a.end(); it_a++, it_b++) {
+		if ((it_a->first != it_b->first) || !isEqual(it_a->second, it_b->second))
+			return false;
+	}
+
+	return true;
+}
+
+
+/** @brief Reads the bytes of a file */
+static std::string readFile(std::string filename)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+
+int main(int argc, char **argv)
+{
+	std::string robot_filename = "benchmark/config/quadruped.yaml";
+	std::string primitives_filename = "benchmark/config/body_primitives.yaml";
+	std::string bundle_filename = "RobotBundleTest.bundle";
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--robot") == 0)
+			robot_filename = argv[++i];
+		else if (strcmp(argv[i], "--primitives") == 0)
+			primitives_filename = argv[++i];
+		else if (strcmp(argv[i], "--bundle") == 0)
+			bundle_filename = argv[++i];
+	}
+	std::string yaml_bundle_filename = bundle_filename + ".yaml";
+	std::string bundle_bundle_filename = bundle_filename + ".bundle";
+
+	// Reading the robot from the yaml files and from the compiled bundle
+	dwl::robot::Robot yaml_robot;
+	yaml_robot.read(robot_filename);
+	yaml_robot.getBodyMotorPrimitive().read(primitives_filename);
+
+	dwl::robot::Robot bundle_robot;
+	if (!dwl::robot::RobotBundle::compile(robot_filename, primitives_filename, bundle_filename) ||
+			!dwl::robot::RobotBundle::read(bundle_robot, bundle_filename)) {
+		printf(RED "RobotBundleTest failed because the bundle could not be compiled or read\n"
+				COLOR_RESET);
+		std::remove(bundle_filename.c_str());
+		return 1;
+	}
+
+	// Comparing the robot properties
+	if (yaml_robot.getEndEffectorMap() != bundle_robot.getEndEffectorMap())
+		reportDifference("end-effector map");
+	if (yaml_robot.getLegMap() != bundle_robot.getLegMap())
+		reportDifference("leg map");
+	if (yaml_robot.getNumberOfLegs() != bundle_robot.getNumberOfLegs())
+		reportDifference("number of legs");
+	if (yaml_robot.getPatternOfLocomotion() != bundle_robot.getPatternOfLocomotion())
+		reportDifference("pattern of locomotion");
+	if (yaml_robot.getNominalStance() != bundle_robot.getNominalStance())
+		reportDifference("nominal stance");
+	if (!isEqual(yaml_robot.getPredefinedBodyWorkspace(),
+			bundle_robot.getPredefinedBodyWorkspace()))
+		reportDifference("body workspace");
+	if (!isEqual(yaml_robot.getPredefinedLegWorkspaces(),
+			bundle_robot.getPredefinedLegWorkspaces()))
+		reportDifference("leg workspaces");
+	if (!isEqual(yaml_robot.getFootstepSearchSize(), bundle_robot.getFootstepSearchSize()))
+		reportDifference("footstep search size");
+
+	// Comparing the precomputed stance tables and the expected ground of the feet
+	for (int pattern = 0; pattern < dwl::robot::Robot::NUM_STANCE_PATTERNS; pattern++) {
+		if (yaml_robot.getPatternStance(pattern) != bundle_robot.getPatternStance(pattern))
+			reportDifference("stance of a stance pattern");
+		if (!isEqual(yaml_robot.getPatternFootstepSearchAreas(pattern),
+				bundle_robot.getPatternFootstepSearchAreas(pattern)))
+			reportDifference("stance areas of a stance pattern");
+	}
+	dwl::robot::GaitState state;
+	state.pose.position = Eigen::Vector3d::Zero();
+	state.pose.orientation = Eigen::Quaterniond::Identity();
+	for (dwl::EndEffectorMap::const_iterator it = yaml_robot.getLegMap().begin();
+			it != yaml_robot.getLegMap().end(); it++) {
+		if (yaml_robot.getExpectedGround(state, it->first) !=
+				bundle_robot.getExpectedGround(state, it->first))
+			reportDifference("expected ground of a foot");
+	}
+
+	// Comparing the body motor primitives
+	const std::vector<dwl::behavior::BodyMotorPrimitive>& yaml_primitives =
+			dynamic_cast<dwl::behavior::BodyMotorPrimitives&>(
+					yaml_robot.getBodyMotorPrimitive()).getPrimitives();
+	const std::vector<dwl::behavior::BodyMotorPrimitive>& bundle_primitives =
+			dynamic_cast<dwl::behavior::BodyMotorPrimitives&>(
+					bundle_robot.getBodyMotorPrimitive()).getPrimitives();
+	if (yaml_primitives.size() != bundle_primitives.size())
+		reportDifference("number of body motor primitives");
+	else {
+		for (std::size_t i = 0; i < yaml_primitives.size(); i++) {
+			if ((yaml_primitives[i].action != bundle_primitives[i].action) ||
+					(yaml_primitives[i].cost != bundle_primitives[i].cost))
+				reportDifference("body motor primitive");
+		}
+	}
+
+	// Comparing the properties without queries by writing both robots
+	if (!dwl::robot::RobotBundle::write(yaml_robot, yaml_bundle_filename) ||
+			!dwl::robot::RobotBundle::write(bundle_robot, bundle_bundle_filename) ||
+			(readFile(yaml_bundle_filename) != readFile(bundle_bundle_filename)))
+		reportDifference("written bundle");
+
+	std::remove(bundle_filename.c_str());
+	std::remove(yaml_bundle_filename.c_str());
+	std::remove(bundle_bundle_filename.c_str());
+
+	if (yaml_primitives.empty() || yaml_robot.getLegMap().empty()) {
+		printf(RED "RobotBundleTest failed because the yaml robot doesn't have legs or"
+				" primitives\n" COLOR_RESET);
+		return 1;
+	}
+
+	if (num_failures > 0) {
+		printf(RED "RobotBundleTest failed with %u differences\n" COLOR_RESET, num_failures);
+		return 1;
+	}
+
+	printf(GREEN "RobotBundleTest passed\n" COLOR_RESET);
+	return 0;
+}
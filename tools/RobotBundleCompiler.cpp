@@ -0,0 +1,21 @@
+#include <dwl/robot/RobotBundle.h>
+
+
+/**
+ * Compiles the yaml files of the robot properties and body motor primitives into a binary robot
+ * bundle, which is loaded with dwl::robot::RobotBundle::read.
+ *
+ * Usage: RobotBundleCompiler robot.yaml body_primitives.yaml robot.bundle
+ */
+int main(int argc, char** argv)
+{
+	if (argc != 4) {
+		printf("Usage: %s robot.yaml body_primitives.yaml robot.bundle\n", argv[0]);
+		return 2;
+	}
+
+	if (!dwl::robot::RobotBundle::compile(argv[1], argv[2], argv[3]))
+		return 1;
+
+	return 0;
+}